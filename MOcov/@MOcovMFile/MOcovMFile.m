@@ -1,145 +1,124 @@
-function obj = MOcovMFile(fn)
+function obj = MOcovMFile(fn, parse_info)
     % instantiate MOcov m-file representation of line coverage
     %
-    % obj=MOcovMFile(fn)
+    % obj=MOcovMFile(fn[, parse_info])
     %
     % Input:
     %   fn                  Filename of .m file
+    %   parse_info          Optional struct, as returned by get_parse_info,
+    %                       for a file with the same contents as fn. If
+    %                       provided, fn is not parsed.
     %
     % Output:
     %   obj                 MOcovMFile instance that contains, internally,
-    %                       the filename, each line of the m-file, which lines
-    %                       are executable, and an array counting how often
-    %                       each line has been executed.
-
-    props = get_mfile_props(fn);
+    %                       the filename, where each line of the m-file
+    %                       starts, which lines are executable, an array
+    %                       counting how often each line has been executed,
+    %                       the time spent on each line, and the md5
+    %                       checksum of the contents of the file.
+    %
+    % Notes:
+    %   - the lines of the m-file are not kept in memory, but read again
+    %     from fn when needed (see get_lines), which requires that fn is
+    %     not changed or removed while the instance is used.
+
+    if nargin < 2
+        props = get_mfile_props(fn);
+    else
+        props = get_mfile_props_from_parse_info(fn, parse_info);
+    end
     obj = class(props, 'MOcovMFile');
 
+function props = get_mfile_props_from_parse_info(fn, parse_info)
+    % fields must be set in the same order as in get_mfile_props
+    keys = {'executable', 'function_start', 'block_leader'};
+    for k = 1:numel(keys)
+        if ~isfield(parse_info, keys{k})
+            error('parse information is missing field ''%s''', keys{k});
+        end
+    end
+
+    props = struct();
+    props.filename = mocov_get_absolute_path(fn);
+    props.executable = parse_info.executable;
+    props.executed_count = zeros(size(props.executable));
+    props.function_start = parse_info.function_start;
+    props.block_leader = parse_info.block_leader;
+    if isfield(parse_info, 'line_offsets')
+        props.line_offsets = parse_info.line_offsets;
+    elseif isfield(parse_info, 'lines')
+        % parse information stored by an earlier version
+        n_chars = cellfun(@numel, parse_info.lines(:));
+        props.line_offsets = cumsum([0; n_chars + 1]);
+    else
+        error('parse information is missing field ''line_offsets''');
+    end
+    if isfield(parse_info, 'content_hash')
+        props.content_hash = parse_info.content_hash;
+    else
+        % parse information stored by an earlier version
+        props.content_hash = mocov_util_md5(fn);
+    end
+    props.executed_time = zeros(size(props.executable));
+
 function props = get_mfile_props(fn)
     % get properties of a matlab file. The output has
     %   .filename: filename of mfile
     %   .executable:        Nx1 boolean array for N lines,
     %                       indicating which lines can be executed
     %   .executed_count:    Nx1 false array
-    %   .lines              Nx1 cellstr with lines of mfile
-
-    % read the matlab file
-    fid = fopen(fn);
-    cleaner = onCleanup(@()fclose(fid));
-    s = fread(fid, inf, 'char=>char')';
-
-    % split by newline character
-    lines = regexp(s, sprintf('\n'), 'split');
-
-    % state variables
-    in_line_continuation = false;  % whether the previous line contained a
-    % line continuation, i.e. ended with '...'
-
-    inside_class = false;  % the file contains a `classdef` statement
-
-    inside_properties = false; % a `properties` section was opened
-    % but not closed.
+    %   .function_start:    Nx1 boolean array, indicating which lines start
+    %                       a function definition
+    %   .block_leader:      Nx1 array; for each executable line, the first
+    %                       line of the block of consecutive executable
+    %                       lines it belongs to (0 for non-executable lines)
+    %   .line_offsets       (N+1)x1 array; line k consists of the
+    %                       characters after position line_offsets(k)
+    %                       and before position line_offsets(k+1)
+    %   .content_hash       md5 checksum of the contents of mfile
+    %   .executed_time      Nx1 zero array
+
+    % read the matlab file as bytes, so that the checksum is computed from
+    % the same buffer without reading the file again
+    [s, bytes] = mocov_util_read_text(fn);
+
+    % lines are separated by a newline character
+    line_offsets = [0; find(s(:) == sprintf('\n')); numel(s) + 1];
 
     % see which lines are executable
-    n = numel(lines);
-    executable = false(n, 1);
-    for k = 1:n
-        line = lines{k};
-
-        line_without_quotes = regexprep(line, '''.*''|".*"', '');
-
-        comment_start = find(line_without_quotes == '%', 1);
-        if isempty(comment_start)
-            line_code = line_without_quotes;
-        else
-            line_code = line_without_quotes(1:(comment_start - 1));
-        end
-
-        line_code_trimmed = regexprep(line_code, '\s', '');
-        if isempty(line_code_trimmed)
-            continue
-        end
-
-        % Check for statements that ~changes/depends on~ the 'parser' state
-        classdef_statement = line_is_class_def(line_code_trimmed);
-        inside_class = inside_class || classdef_statement;
-
-        properties_section = line_opens_properties_section( ...
-                                                           line_code_trimmed, inside_class);
-        % When a properties section is opened set the inside_properties flag
-        inside_properties = inside_properties || properties_section;
-        % When inside_properties is set and an 'end' appears, the section
-        % is closed.
-        % This can be considered a hack, since assumes no code that includes
-        % an `end` is allowed inside properties.
-        inside_properties = inside_properties && ...
-            ~line_ends_with_end_statement(line_code_trimmed);
-
-        % classify line
-        executable(k) = ~( ...
-                          in_line_continuation || ...
-                          line_is_function_def(line_code_trimmed) || ...
-                          classdef_statement || ...
-                          line_opens_methods_section(line_code_trimmed, inside_class) || ...
-                          inside_properties || ...  % Arbitrary code cannot run inside
-                          ...                       % properties section, just a subset
-                          line_is_case_statement(line_code) || ...
-                          line_is_elseif_statement(line_code) || ...
-                          line_is_else_statement(line_code) || ...
-                          line_is_sole_end_statement(line_code_trimmed));
-
-        in_line_continuation = line_has_line_continuation(line_code);
-    end
+    [executable, function_start, has_code, has_control_flow] = ...
+                                                        mocov_scan_mfile(s);
 
     % put results in struct
     props = struct();
     props.filename = mocov_get_absolute_path(fn);
     props.executable = executable;
     props.executed_count = zeros(size(props.executable));
-    props.lines = lines;
-
-function tf = line_is_function_def(line)
-    % returns true if the string in line indicates a function definition
-    newline = sprintf('\n');
-    pat = [newline '\s*function([\[\]\w ,~]*=)?[ ]*'...
-           '(?<name>[a-zA-Z]\w*)(\([^\)]*\))?'];
-
-    tf = ~isempty(regexp([newline line], pat, 'once'));
-    % addition, so that defs that span multiple lines with ... get
-    % recognized properly
-    tf = tf || ~isempty(regexp(line, 'function\s*\[.*\].*\.\.\.', 'once'));
-
-function tf = line_is_class_def(line)
-    % returns true if the line opens a class definition
-    tf = ~isempty(regexp(line, '^\s*classdef\W*', 'once'));
-
-function tf = line_opens_methods_section(line, inside_class)
-    % returns true if the line opens a method section inside class definition
-    tf = inside_class && ...
-       ~isempty(regexp(line, '^\s*methods\s*(\([^\(\)]*\))?\s*$', 'once'));
-
-function tf = line_opens_properties_section(line, inside_class)
-    % returns true if the line opens a properties section inside class definition
-    tf = inside_class && ...
-       ~isempty(regexp(line, '^\s*properties\s*(\([^\(\)]*\))?\s*$', 'once'));
-
-function tf = line_is_sole_end_statement(line)
-    % returns true if the string in line is just an end statement
-    tf = isempty(regexprep(line, '([\s,;]|^)?end([\s,;]|$)?', ''));
-
-function tf = line_is_case_statement(line)
-    tf = ~isempty(regexp(line, '^\s*case\W*', 'once'));
-
-function tf = line_is_elseif_statement(line)
-    tf = ~isempty(regexp(line, '^\s*elseif\W*', 'once'));
-
-function tf = line_is_else_statement(line)
-    tf = ~isempty(regexp(line, '^\s*else\W*', 'once'));
-
-function tf = line_ends_with_end_statement(line)
-    % returns true if the line has a finishing 'end'
-    tf = ~isempty(regexp(line, '(^|\W)end\s*[,;]?\s*$', 'once'));
-
-function tf = line_has_line_continuation(line)
-    % returns true if the line contains a line continuation
-    tf = ~isempty(regexp(line, '\.\.\.', 'once'));
+    props.function_start = function_start;
+    props.block_leader = get_block_leader(executable, has_code, ...
+                                          has_control_flow);
+    props.line_offsets = line_offsets;
+    props.content_hash = mocov_md5(bytes);
+    props.executed_time = zeros(size(props.executable));
+
+function block_leader = get_block_leader(executable, has_code, ...
+                                         has_control_flow)
+    % group executable lines in blocks that are always executed together:
+    % a new block starts after a line that may change the control flow,
+    % or after a non-executable line with code (such as 'else' or 'end')
+    n = numel(executable);
+    block_leader = zeros(n, 1);
+
+    leader = 0;
+    starts_new_block = true;
+    for k = 1:n
+        if executable(k)
+            if starts_new_block
+                leader = k;
+            end
+            block_leader(k) = leader;
+            starts_new_block = has_control_flow(k);
+        elseif has_code(k)
+            starts_new_block = true;
+        end
+    end
@@ -1,19 +1,31 @@
-function obj = add_lines_executed_count(obj, lines)
+function obj = add_lines_executed_count(obj, lines, granularity)
     % increase line executed counter
     %
-    % obj=add_lines_executed_count(obj, lines)
+    % obj=add_lines_executed_count(obj, lines[, granularity])
     %
     % Inputs:
     %   obj                 MOcovMFile instance
     %   lines               Nx1 vector with counts that a line represented
     %                       by obj was executed
+    %   granularity         Optional, one of:
+    %                       'line'   lines has counts for each line
+    %                       'block'  lines only has counts for the first
+    %                                line of each block (see
+    %                                get_lines_block_leader); the counts of
+    %                                the other lines in each block are set
+    %                                to the count of the first line
+    %                       Default: 'line'
     %
     % Output:
     %   obj                 MOcovMFile instance with the counts increased
 
+    if nargin >= 3 && strcmp(granularity, 'block')
+        lines = expand_block_counts(obj, lines);
+    end
+
     n = find(lines > 0, 1, 'last');
 
-    obj_n = numel(get_lines(obj));
+    obj_n = numel(obj.executable);
     if obj_n < n
         error(['Cannot set line %d to be executed, as '...
                '%s has only %d lines'], ...
@@ -21,3 +33,15 @@ function obj = add_lines_executed_count(obj, lines)
     end
 
     obj.executed_count(1:n) = obj.executed_count(1:n) + lines(1:n);
+
+function counts = expand_block_counts(obj, block_counts)
+    leader = get_lines_block_leader(obj);
+    n = numel(leader);
+
+    n_block_counts = min(n, numel(block_counts));
+    padded_block_counts = zeros(n, 1);
+    padded_block_counts(1:n_block_counts) = block_counts(1:n_block_counts);
+
+    counts = zeros(n, 1);
+    in_block = leader > 0;
+    counts(in_block) = padded_block_counts(leader(in_block));
@@ -0,0 +1,28 @@
+function obj = add_lines_executed_time(obj, times)
+    % increase the time spent on each line
+    %
+    % obj=add_lines_executed_time(obj, times)
+    %
+    % Inputs:
+    %   obj                 MOcovMFile instance
+    %   times               Nx1 vector with the time in seconds spent on
+    %                       each line represented by obj, as returned by
+    %                       mocov_line_covered('get_times')
+    %
+    % Output:
+    %   obj                 MOcovMFile instance with the times increased
+    %
+    % Notes:
+    %   - with 'block' granularity the time of each block is recorded
+    %     for the first line of the block only.
+
+    n = find(times > 0, 1, 'last');
+
+    obj_n = numel(obj.executable);
+    if obj_n < n
+        error(['Cannot add time to line %d, as '...
+               '%s has only %d lines'], ...
+              n, get_filename(obj), obj_n);
+    end
+
+    obj.executed_time(1:n) = obj.executed_time(1:n) + times(1:n);
@@ -0,0 +1,14 @@
+function content_hash = get_content_hash(obj)
+    % get the md5 checksum of the contents of an m-file
+    %
+    % content_hash=get_content_hash(obj)
+    %
+    % Input:
+    %   obj                 MOcovMFile instance
+    %
+    % Output:
+    %   content_hash        1x32 char array with the md5 checksum of the
+    %                       contents of the m-file, as computed when the
+    %                       file was parsed
+
+    content_hash = obj.content_hash;
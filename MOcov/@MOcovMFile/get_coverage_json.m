@@ -22,7 +22,7 @@ function json = get_coverage_json(obj, root_dir)
     %     in combination with travis-ci
 
     name = mocov_get_relative_path(root_dir, obj.filename);
-    source_digest = mocov_util_md5(obj.filename);
+    source_digest = get_content_hash(obj);
     coverage = get_coverage(obj);
 
     json = sprintf(['{ "name": "%s",\n', ...
@@ -34,27 +34,11 @@ function json_coverage = get_coverage(obj)
     executable = get_lines_executable(obj);
     executed_count = get_lines_executed_count(obj);
 
-    n = numel(executable);
+    % format all lines at once; lines that cannot be executed are NaN
+    % first, which is then replaced by null
+    values = double(executed_count(:));
+    values(~executable) = NaN;
+    values_str = strrep(sprintf('%d,', values), 'NaN', 'null');
 
-    json_parts = cell(1, 2 * n + 1);
-    json_parts{1} = '[';
-    for k = 1:n
-        line_executable = executable(k);
-
-        if line_executable
-            coverage_str = sprintf('%d', executed_count(k));
-        else
-            coverage_str = 'null';
-        end
-
-        json_parts{2 * k} = coverage_str;
-        if k < n
-            suffix = ',';
-        else
-            suffix = ']';
-        end
-
-        json_parts{2 * k + 1} = suffix;
-    end
-
-    json_coverage = sprintf('%s', json_parts{:});
+    % remove the trailing comma
+    json_coverage = ['[' values_str(1:(end - 1)) ']'];
@@ -36,18 +36,19 @@ function xml = get_coverage_xml(obj, root_dir)
 
 function xml = get_reportable_lines_xml(obj)
     idxs = find(get_lines_executable(obj));
-    n = numel(idxs);
 
     executed_count = get_lines_executed_count(obj);
-    lines = cell(1, n);
-    for k = 1:n
-        idx = idxs(k);
-        hits = executed_count(idx);
-        lines{k} = sprintf('<line number="%d" hits="%d" branch="false"/>', ...
-                           idx, hits);
+    hits = executed_count(idxs);
+
+    % format all lines at once, with line number and hits in each column
+    % (without any lines, sprintf would still output part of the pattern)
+    lines = '';
+    if ~isempty(idxs)
+        lines = sprintf('<line number="%d" hits="%d" branch="false"/>\n', ...
+                        [idxs(:)'; hits(:)']);
     end
 
-    xml = sprintf('%s\n', '<lines>', lines{:}, '</lines>');
+    xml = sprintf('%s\n%s%s\n', '<lines>', lines, '</lines>');
 
 function r = get_coverage_ratio(obj)
     executable = get_lines_executable(obj);
@@ -8,5 +8,17 @@ function lines = get_lines(obj)
     %
     % Output:
     %   lines               Nx1 cell with strings, if the m-file has N lines
+    %
+    % Notes:
+    %   - the lines are read from the file (see get_text); use
+    %     get_lines_executable to find the number of lines without reading
+    %     the file.
+
+    text = get_text(obj);
+    offsets = obj.line_offsets;
 
-    lines = obj.lines;
+    n = numel(offsets) - 1;
+    lines = cell(n, 1);
+    for k = 1:n
+        lines{k} = text((offsets(k) + 1):(offsets(k + 1) - 1));
+    end
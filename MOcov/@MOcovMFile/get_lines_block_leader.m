@@ -0,0 +1,16 @@
+function leader = get_lines_block_leader(obj)
+    % get the first line of the block that each line belongs to
+    %
+    % leader=get_lines_block_leader(obj)
+    %
+    % Input:
+    %   obj                 MOcovMFile instance
+    %
+    % Output:
+    %   leader              Nx1 numeric vector, with leader(k)=j indicating
+    %                       that the k-th line is executable and is always
+    %                       executed directly after line j (or j==k), unless
+    %                       an error is raised in between. Lines that are
+    %                       not executable have a value of zero.
+
+    leader = obj.block_leader;
@@ -0,0 +1,15 @@
+function time = get_lines_executed_time(obj)
+    % get the time spent on each line
+    %
+    % time=get_lines_executed_time(obj)
+    %
+    % Input:
+    %   obj                 MOcovMFile instance
+    %
+    % Output:
+    %   time                Nx1 numeric vector, with time(k)=t indicating
+    %                       that t seconds were spent on the k-th line,
+    %                       including the time of recording it. Only set
+    %                       when coverage was collected with timing.
+
+    time = obj.executed_time;
@@ -0,0 +1,13 @@
+function msk = get_lines_function_start(obj)
+    % get a mask indicating which lines start a function definition
+    %
+    % msk=get_lines_function_start(obj)
+    %
+    % Input:
+    %   obj                 MOcovMFile instance
+    %
+    % Output:
+    %   msk                 Nx1 logical mask, with msk(k)==true indicating
+    %                       that the k-th line starts a function definition
+
+    msk = obj.function_start;
@@ -0,0 +1,22 @@
+function parse_info = get_parse_info(obj)
+    % get the information obtained by parsing the m-file
+    %
+    % parse_info=get_parse_info(obj)
+    %
+    % Input:
+    %   obj                 MOcovMFile instance
+    %
+    % Output:
+    %   parse_info          struct with where each line of the m-file
+    %                       starts and which lines are executable. It can
+    %                       be stored and passed to the MOcovMFile
+    %                       constructor later, to
+    %                       avoid parsing a file with the same contents
+    %                       again.
+
+    parse_info = struct();
+    parse_info.executable = obj.executable;
+    parse_info.function_start = obj.function_start;
+    parse_info.block_leader = obj.block_leader;
+    parse_info.line_offsets = obj.line_offsets;
+    parse_info.content_hash = obj.content_hash;
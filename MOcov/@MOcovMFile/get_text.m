@@ -0,0 +1,22 @@
+function text = get_text(obj)
+    % read the contents of an m-file
+    %
+    % text=get_text(obj)
+    %
+    % Input:
+    %   obj                 MOcovMFile instance
+    %
+    % Output:
+    %   text                1xN char array with the contents of the m-file
+    %
+    % Notes:
+    %   - the contents are read from the file each time this method is
+    %     called, rather than kept in memory. An error is raised if the
+    %     file has changed since it was parsed.
+
+    fn = get_filename(obj);
+    [text, bytes] = mocov_util_read_text(fn);
+
+    if ~strcmp(mocov_md5(bytes), obj.content_hash)
+        error('File %s has changed since it was parsed', fn);
+    end
@@ -14,46 +14,52 @@ function write_html(obj, fn, index_fn)
 
     mfile_fn = obj.filename;
 
-    fid = fopen(fn, 'w');
-    cleaner = onCleanup(@()fclose(fid));
+    header = sprintf(['<!DOCTYPE html>\n'...
+                      '<html><head><title>%s</title>'...
+                      '<STYLE TYPE="text/css"><!--'...
+                      'TD{font-family: "Courier New", '...
+                      'Courier, monospace; font-size: 10pt;}'...
+                      '---></STYLE>'...
+                      '</head>'...
+                      '<body>'...
+                      '<p>(Back to <a href="%s">index</a>)</p>'...
+                      '<h1>%s</h1>'...
+                      '<p style="font-family:'...
+                      '''Courier New''">'...
+                      '<table>\n'...
+                      '<tr><th>Line</th><th>Code</th></tr>\n'], ...
+                     mfile_fn, index_fn, mfile_fn);
+    footer = '</table></p></body></html>';
 
-    fprintf(fid, ['<!DOCTYPE html>\n'...
-                  '<html><head><title>%s</title>'...
-                  '<STYLE TYPE="text/css"><!--'...
-                  'TD{font-family: "Courier New", '...
-                  'Courier, monospace; font-size: 10pt;}'...
-                  '---></STYLE>'...
-                  '</head>'...
-                  '<body>'...
-                  '<p>(Back to <a href="%s">index</a>)</p>'...
-                  '<h1>%s</h1>'...
-                  '<p style="font-family:'...
-                  '''Courier New''">'...
-                  '<table>\n'], ...
-            mfile_fn, index_fn, mfile_fn);
-    fprintf(fid, '<tr><th>Line</th><th>Code</th></tr>\n');
-
-    lines = get_lines(obj);
+    lines = convert_raw_to_html(get_lines(obj));
     missed = get_lines_executable(obj) & ~get_lines_executed(obj);
 
     html_red_color = '#FF0000';
     html_white_color = '#FFFFFF';
 
-    for k = 1:numel(lines)
-        line = convert_raw_to_html(lines{k});
-
+    % the page is built in memory and written at once; each line is
+    % appended separately, because sprintf skips empty arguments
+    row_end = sprintf('</td></tr>\n');
+    n = numel(lines);
+    rows = cell(1, n);
+    for k = 1:n
         if missed(k)
             html_color = html_red_color;
         else
             html_color = html_white_color;
         end
 
-        fprintf(fid, '<tr><td>%d</td><td bgcolor="%s">%s</td></tr>\n', ...
-                k, html_color, line);
+        rows{k} = [sprintf('<tr><td>%d</td><td bgcolor="%s">', ...
+                           k, html_color), ...
+                   lines{k}, row_end];
     end
-    fprintf(fid, '</table></p></body></html>');
 
-function line = convert_raw_to_html(line)
+    fid = fopen(fn, 'w');
+    cleaner = onCleanup(@()fclose(fid));
+    fprintf(fid, '%s', [header, rows{:}, footer]);
+
+function lines = convert_raw_to_html(lines)
+    % lines is a cellstr; all lines are converted at once
     orig_new = {'&', '&amp;'; ...
                 ' ', '&nbsp;'; ...
                 '<', '&lt;'; ...
@@ -62,5 +68,5 @@ function line = convert_raw_to_html(line)
 
     n_replacements = size(orig_new, 1);
     for k = 1:n_replacements
-        line = strrep(line, orig_new{k, 1}, orig_new{k, 2});
+        lines = strrep(lines, orig_new{k, 1}, orig_new{k, 2});
     end
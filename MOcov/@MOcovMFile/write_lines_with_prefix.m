@@ -1,7 +1,7 @@
-function write_lines_with_prefix(obj, fn, decorator)
+function write_lines_with_prefix(obj, fn, decorator, granularity)
     % write lines in mfile with prefix
     %
-    % write_lines_with_prefix(obj, fn, decorator)
+    % write_lines_with_prefix(obj, fn, decorator[, granularity])
     %
     % Inputs:
     %   obj                 MOcovMFile instance
@@ -12,6 +12,12 @@ function write_lines_with_prefix(obj, fn, decorator)
     %                       called, each executable line is prefixed with its
     %                       corresponding prefix expression and the results are
     %                       written to the output file fn.
+    %   granularity         Optional, one of:
+    %                       'line'   prefix every executable line
+    %                       'block'  only prefix the first line of each
+    %                                block of executable lines (see
+    %                                get_lines_block_leader)
+    %                       Default: 'line'
     %
     % Notes:
     %   - the typical value for decorator is a function that returns
@@ -19,34 +25,35 @@ function write_lines_with_prefix(obj, fn, decorator)
     %     with k the input line number. This provides functionality to keep
     %     track of which lines are covered.
 
-    orig_lines = get_lines(obj);
-    n = numel(orig_lines);
+    text = get_text(obj);
+    n = numel(obj.executable);
 
-    executable = get_lines_executable(obj);
-
-    new_lines = cell(1, n);
-    for k = 1:n
-        line = orig_lines{k};
+    if nargin >= 4 && strcmp(granularity, 'block')
+        decorate = get_lines_block_leader(obj) == (1:n)';
+    else
+        decorate = get_lines_executable(obj);
+    end
 
-        if executable(k)
-            prefix = decorator(k);
-        else
-            prefix = '';
+    % the contents are copied in chunks between the starts of decorated
+    % lines, rather than line by line
+    decorated = find(decorate(:));
+    starts = obj.line_offsets(decorated) + 1;
+    chunk_starts = [1; starts];
+    chunk_ends = [starts - 1; numel(text)];
+
+    n_decorated = numel(decorated);
+    parts = cell(2, n_decorated + 1);
+    parts{1, 1} = '';
+    for k = 1:(n_decorated + 1)
+        if k > 1
+            parts{1, k} = decorator(decorated(k - 1));
         end
-
-        new_lines{k} = sprintf('%s%s\n', prefix, line);
+        parts{2, k} = text(chunk_starts(k):chunk_ends(k));
     end
 
     pth = fileparts(fn);
-    mkdir_recursively(pth);
+    mocov_util_mkdir_recursively(pth);
 
     fid = fopen(fn, 'w');
     cleaner = onCleanup(@()fclose(fid));
-    fprintf(fid, '%s', new_lines{:});
-
-function mkdir_recursively(pth)
-    if ~isempty(pth) && ~mocov_util_isfolder(pth)
-        parent = fileparts(pth);
-        mkdir_recursively(parent);
-        mkdir(pth);
-    end
+    fprintf(fid, '%s', parts{:});
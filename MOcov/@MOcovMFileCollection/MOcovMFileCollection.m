@@ -1,7 +1,8 @@
-function obj = MOcovMFileCollection(root_dir, method, monitor, exclude_pat)
+function obj = MOcovMFileCollection(root_dir, method, monitor, exclude_pat, ...
+                                   options)
     % instantiate MOcovMFileCollection
     %
-    % obj=MOcovMFileCollection(root_dir, method, monitor)
+    % obj=MOcovMFileCollection(root_dir, method, monitor, exclude_pat, options)
     %
     % Inputs:
     %   root_dir                root directory containing m-files to be
@@ -14,9 +15,75 @@ function obj = MOcovMFileCollection(root_dir, method, monitor, exclude_pat)
     %                           default: 'file'
     %   monitor                 optional MOcovProgressMonitor instance
     %   exclude_pat             Optional cell array of patterns to exclude.
+    %   options                 Optional struct with fields:
+    %                           .granularity    (only used if method=='file')
+    %                                           one of:
+    %                               - 'line'    record every executable line
+    %                               - 'block'   only record the first line
+    %                                           of each block of executable
+    %                                           lines that are always executed
+    %                                           together. This is faster, but
+    %                                           lines after a line that raised
+    %                                           an error are considered to be
+    %                                           executed as well.
+    %                                           default: 'line'
+    %                           .probe          (only used if method=='file')
+    %                                           one of:
+    %                               - 'call'    call mocov_line_covered for
+    %                                           every executed line
+    %                               - 'buffer'  increase a count in a global
+    %                                           variable for executed lines
+    %                                           in functions, and add these
+    %                                           counts to mocov_line_covered
+    %                                           when coverage is collected.
+    %                                           This is faster, but counts are
+    %                                           lost if the global variables
+    %                                           are cleared.
+    %                                           default: 'call'
+    %                           .cache_dir      (only used if method=='file')
+    %                                           optional directory in which
+    %                                           parsed and rewritten m-files
+    %                                           are stored, keyed by the md5
+    %                                           of their contents. Files that
+    %                                           did not change since an
+    %                                           earlier run are not parsed or
+    %                                           rewritten again.
+    %                                           default: [] (no caching)
+    %                           .jobs           number of jobs to parse,
+    %                                           rewrite and report m-files
+    %                                           in parallel (see
+    %                                           mocov_run_jobs).
+    %                                           default: 1
+    %                           .hash_content   if true, compute the md5 of
+    %                                           the contents of each m-file
+    %                                           even if no cache is used,
+    %                                           so that coverage snapshots
+    %                                           can be checked against the
+    %                                           files when merged.
+    %                                           default: false
+    %                           .timing         (only used if method=='file'
+    %                                           and probe=='call')
+    %                                           if true, also record the
+    %                                           time spent on each line
+    %                                           (see get_hotspots).
+    %                                           default: false
+    %                           .mode           (only used if method=='file')
+    %                                           one of:
+    %                               - 'count'   count how often each line
+    %                                           is executed
+    %                               - 'hit'     only record whether lines
+    %                                           are executed, and allow
+    %                                           fully covered m-files to be
+    %                                           replaced by their originals
+    %                                           (see mocov_deinstrument)
+    %                                           default: 'count'
     %
     % See also: mocov
 
+    if nargin < 5 || isempty(options)
+        options = struct();
+    end
+
     if nargin < 4 || isempty(exclude_pat)
         exclude_pat = {};
     end
@@ -34,7 +101,25 @@ function obj = MOcovMFileCollection(root_dir, method, monitor, exclude_pat)
     props.monitor = monitor;
     props.exclude_pat = exclude_pat;
     props.mfiles = [];
+    props.rel_fns = [];
+    props.mfile_index = [];
     props.orig_path = [];
     props.temp_dir = [];
     props.method = method;
+    props.granularity = get_option(options, 'granularity', 'line');
+    props.probe = get_option(options, 'probe', 'call');
+    props.cache_dir = get_option(options, 'cache_dir', []);
+    props.content_hash = [];
+    props.jobs = get_option(options, 'jobs', 1);
+    props.hash_content = get_option(options, 'hash_content', false);
+    props.timing = get_option(options, 'timing', false);
+    props.probe_overhead = 0;
+    props.mode = get_option(options, 'mode', 'count');
     obj = class(props, 'MOcovMFileCollection');
+
+function value = get_option(options, key, default_value)
+    if isfield(options, key) && ~isempty(options.(key))
+        value = options.(key);
+    else
+        value = default_value;
+    end
@@ -8,8 +8,8 @@ function obj = add_lines_executed_count(obj)
     %
     % Output:
     %   obj                 MOcovMFileCollection instance with the counts
-    %                       increased for all m-files recorded by
-    %                       mocov_line_covered
+    %                       (and, if timing, the times) increased for all
+    %                       m-files recorded by mocov_line_covered
     %
     % See also: mocov_line_covered
 
@@ -19,12 +19,38 @@ function obj = add_lines_executed_count(obj)
         % Get data from Matlab's profiler
         abs_root_dir = mocov_get_absolute_path(obj.root_dir);
         set_mocov_line_covered_from_profile(abs_root_dir);
+
+        % the profiler counts every line, which is stored in snapshots
+        mocov_line_covered('granularity', 'line');
+    end
+
+    if strcmp(obj.method, 'file') && strcmp(obj.probe, 'buffer')
+        % add counts from the line buffers of the rewritten files
+        mocov_line_buffer('flush');
+    end
+
+    is_timing = strcmp(obj.method, 'file') && obj.timing;
+    if is_timing
+        % stop recording, so that the time spent below is not attributed
+        % to the last covered line
+        mocov_line_covered('timing', false);
+        times = mocov_line_covered('get_times');
     end
 
     s = mocov_line_covered();
 
+    % rewritten files may only record the first line of each block
+    if strcmp(obj.method, 'file')
+        granularity = obj.granularity;
+    else
+        granularity = 'line';
+    end
+
     filenames = s.keys;
     line_count = s.line_count;
+    add_count(monitor, 'probe_hits', sum(cellfun(@sum, line_count)));
+    rel_fns = obj.rel_fns;
+    n_mfiles = numel(rel_fns);
 
     n = numel(filenames);
     msg = sprintf('%d files show coverage', n);
@@ -36,8 +62,20 @@ function obj = add_lines_executed_count(obj)
             % no lines covered for this file
             continue
         end
-        [mfile, idx] = get_mfile(obj, fn);
-        mfile = add_lines_executed_count(mfile, line_count{k});
+
+        % rewrite_mfiles registers the k-th m-file as the k-th file of
+        % mocov_line_covered, so the name only has to be looked up for
+        % files that were not registered (as with the profiler)
+        if k <= n_mfiles && strcmp(rel_fns{k}, fn)
+            idx = k;
+            mfile = obj.mfiles{idx};
+        else
+            [mfile, idx] = get_mfile(obj, fn);
+        end
+        mfile = add_lines_executed_count(mfile, line_count{k}, granularity);
+        if is_timing
+            mfile = add_lines_executed_time(mfile, times{k});
+        end
         obj = set_mfile(obj, mfile, idx);
     end
 
@@ -49,22 +87,26 @@ function set_mocov_line_covered_from_profile(abs_root_dir)
     function_table = pinfo.FunctionTable;
 
     filenames = {function_table.FileName};
-    n = numel(filenames);
+    keep = find(cellfun(has_prefix, filenames));
+    if isempty(keep)
+        return
+    end
 
+    % functions in the same file (such as subfunctions) have their own
+    % entry in the function table; their lines are added together, so that
+    % each file is looked up only once
+    [unq_filenames, unused, file_ids] = unique(filenames(keep));
+    n = numel(unq_filenames);
     for k = 1:n
-        filename = filenames{k};
-
-        if ~has_prefix(filename)
+        executed = {function_table(keep(file_ids == k)).ExecutedLines};
+        executed = vertcat(executed{:});
+        if isempty(executed)
             continue
         end
 
-        rel_filename = mocov_get_relative_path(abs_root_dir, filename);
-
-        executed = function_table(k).ExecutedLines;
-        n_lines = size(executed, 1);
-        for j = 1:n_lines
-            line = executed(j, 1);
-            count = executed(j, 2);
-            mocov_line_covered(k, rel_filename, line, count);
-        end
+        % ExecutedLines has rows [line, count, ...]
+        rel_filename = mocov_get_relative_path(abs_root_dir, ...
+                                               unq_filenames{k});
+        mocov_line_covered('add', rel_filename, ...
+                           executed(:, 1), executed(:, 2));
     end
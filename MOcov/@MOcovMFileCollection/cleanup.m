@@ -17,18 +17,18 @@ function cleanup(obj)
         path(obj.orig_path);
     end
 
+    if strcmp(obj.method, 'file') && strcmp(obj.probe, 'buffer')
+        notify(obj.monitor, '', 'Removing line buffers');
+        mocov_line_buffer('clear');
+    end
+
+    if strcmp(obj.method, 'file') && strcmp(obj.mode, 'hit')
+        mocov_deinstrument('clear');
+    end
+
     if ~isempty(obj.temp_dir)
         msg = sprintf('Removing temporary files in %s', obj.temp_dir);
         notify(obj.monitor, '', msg);
 
-        if mocov_util_platform_is_octave()
-            % GNU Octave requires, by default, confirmation when using
-            % rmdir. The state of confirm_recursive_rmdir is stored,
-            % and set back to its original value when leaving this
-            % function.
-            confirm_val = confirm_recursive_rmdir(false);
-            cleaner = onCleanup(@()confirm_recursive_rmdir(confirm_val));
-        end
-
-        rmdir(obj.temp_dir, 's');
+        mocov_util_rmdir_recursively(obj.temp_dir);
     end
@@ -0,0 +1,20 @@
+function fn = get_cache_filename(obj, name)
+    % get the name of a file in the cache directory
+    %
+    % fn=get_cache_filename(obj[, name])
+    %
+    % Inputs:
+    %   obj                 MOcovMFileCollection instance
+    %   name                Optional name of a file in the cache
+    %
+    % Output:
+    %   fn                  path of the file with the given name in the
+    %                       cache directory, or the path of the directory
+    %                       itself if name is not provided. Each MOcov
+    %                       version uses a separate subdirectory, so that
+    %                       files cached by another version are never used.
+
+    fn = fullfile(obj.cache_dir, ['mocov-' mocov_util_version()]);
+    if nargin >= 2
+        fn = fullfile(fn, name);
+    end
@@ -0,0 +1,63 @@
+function contexts = get_contexts(obj)
+    % get which lines were hit by each context
+    %
+    % contexts=get_contexts(obj)
+    %
+    % Input:
+    %   obj                 MOcovMFileCollection instance
+    %
+    % Output:
+    %   contexts            struct with fields .names, .keys and .ranges,
+    %                       as returned by mocov_line_covered('get_contexts')
+    %
+    % Notes:
+    %   - with 'block' granularity only the first line of each block is
+    %     recorded; all lines in the blocks of the recorded lines are
+    %     considered hit, as in add_lines_executed_count.
+    %
+    % See also: mocov_set_context, mocov_contexts_save
+
+    contexts = mocov_line_covered('get_contexts');
+
+    ranges = contexts.ranges;
+    if ~strcmp(obj.method, 'file') || ~strcmp(obj.granularity, 'block') || ...
+            isempty(ranges)
+        return
+    end
+
+    % rows are sorted by context and file, so the rows for each
+    % combination of context and file are consecutive
+    group_starts = find([true; any(diff(ranges(:, 1:2), 1, 1) ~= 0, 2)]);
+    group_stops = [group_starts(2:end) - 1; size(ranges, 1)];
+
+    n_groups = numel(group_starts);
+    parts = cell(n_groups, 1);
+    for g = 1:n_groups
+        rows = ranges(group_starts(g):group_stops(g), :);
+        parts{g} = expand_blocks(obj, contexts.keys, rows);
+    end
+    contexts.ranges = vertcat(zeros(0, 4), parts{:});
+
+function rows = expand_blocks(obj, keys, rows)
+    % rows all have the same context and file
+    file_idx = rows(1, 2);
+    if file_idx > numel(obj.rel_fns) || ...
+            ~strcmp(obj.rel_fns{file_idx}, keys{file_idx})
+        % not a registered m-file of the collection
+        return
+    end
+
+    leader = get_lines_block_leader(obj.mfiles{file_idx});
+    hits = false(max([numel(leader); rows(:, 4)]), 1);
+    for r = 1:size(rows, 1)
+        first = rows(r, 3);
+        last = rows(r, 4);
+        hits(first:last) = true;
+        hits(leader >= first & leader <= last) = true;
+    end
+
+    changes = diff([false; hits; false]);
+    first_lines = find(changes == 1);
+    last_lines = find(changes == -1) - 1;
+    n = numel(first_lines);
+    rows = [repmat(rows(1, 1:2), n, 1), first_lines, last_lines];
@@ -0,0 +1,148 @@
+function [line_spots, function_spots] = get_hotspots(obj)
+    % get the lines and functions with the most time spent on them
+    %
+    % [line_spots, function_spots]=get_hotspots(obj)
+    %
+    % Input:
+    %   obj                 MOcovMFileCollection instance, for which
+    %                       coverage was collected with timing
+    %
+    % Outputs:
+    %   line_spots          struct with fields, each with one row for each
+    %                       line with time spent on it:
+    %                       .filename   cellstr with the file, relative to
+    %                                   the root directory
+    %                       .name       cellstr with the function containing
+    %                                   the line (or the file name without
+    %                                   extension, for lines in scripts)
+    %                       .line       line number
+    %                       .count      number of times the line (or, with
+    %                                   'block' granularity, its block) was
+    %                                   executed
+    %                       .time       time in seconds spent on the line
+    %                       .self_time  time in seconds, after subtracting
+    %                                   the time spent recording the line
+    %                       .code       cellstr with the line of code
+    %                       Rows are sorted by decreasing .self_time.
+    %   function_spots      struct with fields .filename, .name and .line
+    %                       (first line of the function), .count (number of
+    %                       calls, the count of its first executable line),
+    %                       .time and .self_time (sums over the lines of the
+    %                       function). Rows are sorted by decreasing
+    %                       .self_time.
+    %
+    % Notes:
+    %   - the time of a line is the time from recording it until the next
+    %     recorded line, so it includes the time spent in functions that
+    %     are not covered, but not that of covered functions it calls.
+    %     Function times are therefore exclusive of covered callees.
+    %   - with 'block' granularity the time of a block is attributed to its
+    %     first line.
+    %
+    % See also: mocov_line_covered, mocov_timing_probe_overhead
+
+    line_parts = cell(0, 1);
+    function_parts = cell(0, 1);
+
+    for k = 1:count_mfiles(obj)
+        mfile = get_mfile(obj, k);
+        [line_part, function_part] = get_mfile_hotspots(mfile, ...
+                                            obj.rel_fns{k}, ...
+                                            obj.probe_overhead);
+        line_parts{end + 1, 1} = line_part;
+        function_parts{end + 1, 1} = function_part;
+    end
+
+    line_keys = {'filename', 'name', 'line', 'count', 'time', ...
+                 'self_time', 'code'};
+    function_keys = line_keys(1:(end - 1));
+    line_spots = sort_by_self_time(concat_spots(line_parts, line_keys));
+    function_spots = sort_by_self_time(concat_spots(function_parts, ...
+                                                    function_keys));
+
+function [line_spot, function_spot] = get_mfile_hotspots(mfile, rel_fn, ...
+                                                         overhead)
+    time = reshape(get_lines_executed_time(mfile), [], 1);
+    count = reshape(get_lines_executed_count(mfile), [], 1);
+    code = reshape(get_lines(mfile), [], 1);
+
+    self_time = max(0, time - count * overhead);
+
+    % the function of each line is that of the last function start
+    % at or before the line; lines before any function are in a script
+    function_start = get_lines_function_start(mfile);
+    function_idx = cumsum(function_start(:));
+    start_lines = [1; find(function_start(:))];
+    [unused, script_name] = fileparts(rel_fn);
+    names = [{script_name}; cellfun(@get_function_name, ...
+                                     code(start_lines(2:end)), ...
+                                     'UniformOutput', false)];
+
+    rows = find(time > 0);
+    line_spot = struct();
+    line_spot.filename = repmat({rel_fn}, numel(rows), 1);
+    line_spot.name = names(function_idx(rows) + 1);
+    line_spot.line = rows;
+    line_spot.count = count(rows);
+    line_spot.time = time(rows);
+    line_spot.self_time = self_time(rows);
+    line_spot.code = code(rows);
+
+    % functions (and the script part) in which any time was spent
+    n_functions = numel(start_lines);
+    is_executable = get_lines_executable(mfile);
+    calls = zeros(n_functions, 1);
+    function_time = zeros(n_functions, 1);
+    function_self_time = zeros(n_functions, 1);
+    for f = 1:n_functions
+        msk = function_idx == f - 1;
+        first_executable = find(msk & is_executable(:), 1);
+        if ~isempty(first_executable)
+            calls(f) = count(first_executable);
+        end
+        function_time(f) = sum(time(msk));
+        function_self_time(f) = sum(self_time(msk));
+    end
+
+    rows = find(function_time > 0);
+    function_spot = struct();
+    function_spot.filename = repmat({rel_fn}, numel(rows), 1);
+    function_spot.name = names(rows);
+    function_spot.line = start_lines(rows);
+    function_spot.count = calls(rows);
+    function_spot.time = function_time(rows);
+    function_spot.self_time = function_self_time(rows);
+
+function name = get_function_name(line)
+    % name after an optional output list, as in 'function [a,b] = foo(x)'
+    name = regexp(line, ['^\s*function\s+(?:[^=(]*=)?\s*'...
+                         '([A-Za-z][\w.]*)'], 'tokens', 'once');
+    if isempty(name)
+        name = '';
+    else
+        name = name{1};
+    end
+
+function spots = concat_spots(parts, keys)
+    spots = struct();
+    for k = 1:numel(keys)
+        key = keys{k};
+        if any(strcmp(key, {'filename', 'name', 'code'}))
+            empty_values = cell(0, 1);
+        else
+            empty_values = zeros(0, 1);
+        end
+
+        values = cellfun(@(part)part.(key), parts, 'UniformOutput', false);
+        spots.(key) = vertcat(empty_values, values{:});
+    end
+
+function spots = sort_by_self_time(spots)
+    [unused, order] = sort(spots.self_time, 'descend');
+    spots = select_rows(spots, order);
+
+function spots = select_rows(spots, rows)
+    keys = fieldnames(spots);
+    for k = 1:numel(keys)
+        spots.(keys{k}) = spots.(keys{k})(rows);
+    end
@@ -0,0 +1,57 @@
+function page_names = get_html_page_names(obj, idxs)
+    % get the names of the HTML pages with coverage of individual m-files
+    %
+    % page_names=get_html_page_names(obj[, idxs])
+    %
+    % Inputs:
+    %   obj                 MOcovMFileCollection instance
+    %   idxs                Nx1 vector with indices of the m-files. If not
+    %                       provided, all m-files are used.
+    %
+    % Output:
+    %   page_names          Nx1 cell with the name of the page of each
+    %                       m-file, relative to the HTML output directory
+    %
+    % Notes:
+    %   - the name of a page is derived from the path of the m-file
+    %     relative to the root directory, so that it does not change when
+    %     other m-files are added or removed. Letters, digits, '_' and '.'
+    %     are kept, '/' is written as '--', and any other character as '-'
+    %     followed by its code in hexadecimal notation (preceded by 'u' for
+    %     codes above 255). For example, '+pkg/my_func.m' has the page
+    %     '-2Bpkg--my_func.m.html'.
+
+    if nargin < 2
+        idxs = 1:numel(obj.rel_fns);
+    end
+
+    n = numel(idxs);
+    page_names = cell(n, 1);
+    for j = 1:n
+        page_names{j} = [escape_path(obj.rel_fns{idxs(j)}) '.html'];
+    end
+
+function name = escape_path(rel_fn)
+    % separators are the same on all platforms
+    rel_fn = strrep(rel_fn, '\', '/');
+
+    is_kept = isstrprop(rel_fn, 'alphanum') & double(rel_fn) < 128 | ...
+                    rel_fn == '_' | rel_fn == '.';
+    if all(is_kept)
+        name = rel_fn;
+        return
+    end
+
+    parts = num2cell(rel_fn);
+    for k = find(~is_kept)
+        c = rel_fn(k);
+        code = double(c);
+        if c == '/'
+            parts{k} = '--';
+        elseif code < 256
+            parts{k} = sprintf('-%02X', code);
+        else
+            parts{k} = sprintf('-u%04X', code);
+        end
+    end
+    name = [parts{:}];
@@ -12,6 +12,10 @@ function [mfile, idx] = get_mfile(obj, fn)
     %                       string) or is the fn-th file (if fn is numeric)
     %   idx                 index of mfile within obj
     %
+    % Notes:
+    %   - filenames are looked up in a map built by load_mfiles, so this
+    %     takes constant time.
+    %
 
     if isnumeric(fn)
         lookup_func = @get_mfile_numeric;
@@ -25,18 +29,19 @@ function [mfile, idx] = get_mfile_numeric(obj, idx)
     mfile = obj.mfiles{idx};
 
 function [mfile, idx] = get_mfile_by_name(obj, fn)
-    root_dir = obj.root_dir;
-    abs_fn = mocov_get_absolute_path(fullfile(root_dir, fn));
+    mfile_index = obj.mfile_index;
+    if ~isa(mfile_index, 'containers.Map')
+        error('No mfiles - did you call ''prepare''?');
+    end
+
+    if ~isKey(mfile_index, fn)
+        % the name may not be in canonical form, as in 'sub/../f.m'
+        abs_fn = mocov_get_absolute_path(fullfile(obj.root_dir, fn));
+        fn = mocov_get_relative_path(obj.root_dir, abs_fn);
 
-    mfiles = obj.mfiles;
-    n = numel(mfiles);
-    for k = 1:n
-        mfile = mfiles{k};
-        mfile_fn = get_filename(mfile);
-        if strcmp(mfile_fn, abs_fn)
-            [mfile, idx] = get_mfile_numeric(obj, k);
-            return
+        if ~isKey(mfile_index, fn)
+            error('Not found: %s', fn);
         end
     end
 
-    error('Not found: %s', fn);
+    [mfile, idx] = get_mfile_numeric(obj, mfile_index(fn));
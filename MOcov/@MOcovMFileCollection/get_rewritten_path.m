@@ -0,0 +1,102 @@
+function dirs = get_rewritten_path(obj, orig_path)
+    % get the directories with rewritten m-files to add to the path
+    %
+    % dirs=get_rewritten_path(obj, orig_path)
+    %
+    % Inputs:
+    %   obj                 MOcovMFileCollection instance, for which
+    %                       rewrite_mfiles has set the temporary directory
+    %   orig_path           the search path before the m-files were
+    %                       rewritten, as returned by path()
+    %
+    % Output:
+    %   dirs                Nx1 cell with directories in the temporary
+    %                       directory, in the order in which they should
+    %                       come first in the path
+    %
+    % Notes:
+    %   - the rewritten tree mirrors the original one, so that for each
+    %     directory under the root directory that is in orig_path, the
+    %     corresponding directory in the temporary directory is returned
+    %     (in the same order as in orig_path). Directories that have no
+    %     rewritten m-files, either directly or in private, @class or
+    %     +package subdirectories, are skipped.
+    %   - if no directory under the root directory is in orig_path, all
+    %     directories that can be in the path and have rewritten m-files
+    %     are returned, which is what genpath would return, without the
+    %     directories that have no m-files.
+    %   - private, @class and +package directories are never returned, as
+    %     these are found through their parent directory.
+
+    path_dirs = get_path_dirs(obj.rel_fns);
+
+    abs_root_dir = mocov_get_absolute_path(obj.root_dir);
+    rel_dirs = get_relative_path_dirs(abs_root_dir, orig_path);
+
+    % only directories that contain rewritten files are added
+    rel_dirs = rel_dirs(ismember(rel_dirs, path_dirs));
+
+    if isempty(rel_dirs)
+        rel_dirs = path_dirs;
+    end
+
+    n = numel(rel_dirs);
+    dirs = cell(n, 1);
+    for k = 1:n
+        dirs{k} = fullfile(obj.temp_dir, rel_dirs{k});
+    end
+
+function path_dirs = get_path_dirs(rel_fns)
+    % directories, relative to the root directory, that must be in the
+    % path so that each m-file can be found
+    n = numel(rel_fns);
+    path_dirs = cell(n, 1);
+    for k = 1:n
+        parts = regexp(fileparts(rel_fns{k}), '[\\/]', 'split');
+
+        % a file in a private, @class or +package directory is found
+        % through the parent of the outermost such directory
+        is_special = strcmp(parts, 'private') | ...
+                        strncmp(parts, '@', 1) | strncmp(parts, '+', 1);
+        n_keep = find([is_special true], 1) - 1;
+
+        if n_keep == 0
+            path_dirs{k} = '';
+        else
+            path_dirs{k} = fullfile(parts{1:n_keep});
+        end
+    end
+
+    path_dirs = unique(path_dirs);
+
+function rel_dirs = get_relative_path_dirs(abs_root_dir, orig_path)
+    % directories in the path under the root directory, in the order of
+    % the path
+    orig_dirs = regexp(orig_path, pathsep(), 'split');
+
+    prefix = [abs_root_dir filesep()];
+    n_prefix = numel(prefix);
+
+    n = numel(orig_dirs);
+    rel_dirs = cell(n, 1);
+    keep = false(n, 1);
+    for k = 1:n
+        orig_dir = orig_dirs{k};
+        if isempty(orig_dir)
+            continue
+        end
+
+        if ~mocov_is_absolute_path(orig_dir)
+            orig_dir = mocov_get_absolute_path(orig_dir);
+        end
+
+        if strcmp(orig_dir, abs_root_dir)
+            rel_dirs{k} = '';
+            keep(k) = true;
+        elseif strncmp(orig_dir, prefix, n_prefix)
+            rel_dirs{k} = orig_dir((n_prefix + 1):end);
+            keep(k) = true;
+        end
+    end
+
+    rel_dirs = rel_dirs(keep);
@@ -0,0 +1,92 @@
+function obj = load_mfiles(obj)
+    % find and parse all m-files in the root directory
+    %
+    % obj=load_mfiles(obj)
+    %
+    % Input:
+    %   obj                 MOcovMFileCollection instance
+    %
+    % Output:
+    %   obj                 MOcovMFileCollection instance with a MOcovMFile
+    %                       instance for each m-file in the root directory,
+    %                       the filename of each m-file relative to the
+    %                       root directory, and (if the cache is used or
+    %                       the hash_content option was set) the md5 of
+    %                       each file.
+    %
+    % Notes:
+    %   - a map from relative filename to index is built once, so that
+    %     get_mfile finds a file by name in constant time.
+    %
+    % See also: prepare, merge_snapshots
+
+    monitor = obj.monitor;
+
+    start_phase(monitor, 'find');
+    fns = mocov_find_files(obj.root_dir, '*.m', monitor, obj.exclude_pat);
+    stop_phase(monitor, 'find');
+
+    use_cache = strcmp(obj.method, 'file') && ~isempty(obj.cache_dir);
+    if use_cache
+        mocov_util_mkdir_recursively(get_cache_filename(obj));
+        notify(monitor, '', sprintf('Using cache in %s', obj.cache_dir));
+    end
+
+    if obj.jobs > 1
+        notify(monitor, '', sprintf('Parsing m-files using %d jobs', ...
+                                    obj.jobs));
+    end
+    start_phase(monitor, 'parse');
+    [mfiles, content_hash] = run_jobs(obj, 'parse_mfiles', fns);
+    stop_phase(monitor, 'parse');
+
+    obj.mfiles = mfiles;
+    obj.rel_fns = get_relative_filenames(obj.root_dir, mfiles);
+    obj.mfile_index = get_mfile_index(obj.rel_fns);
+
+    if use_cache || obj.hash_content
+        obj.content_hash = content_hash;
+    end
+
+    add_mfile_counts(monitor, mfiles);
+
+function add_mfile_counts(monitor, mfiles)
+    n = numel(mfiles);
+    n_lines = 0;
+    n_executable = 0;
+    for k = 1:n
+        executable = get_lines_executable(mfiles{k});
+        n_lines = n_lines + numel(executable);
+        n_executable = n_executable + sum(executable);
+    end
+
+    add_count(monitor, 'files', n);
+    add_count(monitor, 'lines', n_lines);
+    add_count(monitor, 'executable_lines', n_executable);
+
+function rel_fns = get_relative_filenames(root_dir, mfiles)
+    % filenames of MOcovMFile instances are already absolute and clean, so
+    % only the root directory has to be made absolute
+    abs_root_dir = mocov_get_absolute_path(root_dir);
+    prefix = [abs_root_dir filesep()];
+    n_prefix = numel(prefix);
+
+    n = numel(mfiles);
+    rel_fns = cell(n, 1);
+    for k = 1:n
+        fn = get_filename(mfiles{k});
+        if strncmp(fn, prefix, n_prefix)
+            rel_fns{k} = fn((n_prefix + 1):end);
+        else
+            % let mocov_get_relative_path deal with (or complain about)
+            % anything unusual
+            rel_fns{k} = mocov_get_relative_path(abs_root_dir, fn);
+        end
+    end
+
+function mfile_index = get_mfile_index(rel_fns)
+    mfile_index = containers.Map('KeyType', 'char', 'ValueType', 'double');
+    n = numel(rel_fns);
+    for k = 1:n
+        mfile_index(rel_fns{k}) = k;
+    end
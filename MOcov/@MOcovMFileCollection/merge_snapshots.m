@@ -0,0 +1,57 @@
+function obj = merge_snapshots(obj, snapshot_fns)
+    % add line counts from coverage snapshots of other runs
+    %
+    % obj=merge_snapshots(obj, snapshot_fns)
+    %
+    % Inputs:
+    %   obj                 MOcovMFileCollection instance
+    %   snapshot_fns        cellstr with names of snapshot files written by
+    %                       mocov_snapshot_save, for example by test shards
+    %                       run in separate processes
+    %
+    % Output:
+    %   obj                 MOcovMFileCollection instance; m-files are
+    %                       found and parsed if that was not done before.
+    %
+    % Notes:
+    %   - the counts are added to the state of mocov_line_covered, and
+    %     are taken into account by add_lines_executed_count.
+    %   - snapshots are merged one after the other, so only a single
+    %     snapshot is in memory at any time.
+    %   - if the content hash of a file is known both in a snapshot and in
+    %     obj (see the hash_content option), they must be equal.
+    %   - the granularity stored in each snapshot, if any, must be equal
+    %     to that of obj.
+    %
+    % See also: mocov_snapshot_save, mocov_snapshot_merge
+
+    monitor = obj.monitor;
+
+    if ~iscell(obj.mfiles)
+        obj = load_mfiles(obj);
+    end
+
+    % register all files, so that counts in the snapshots are added to
+    % the files at the same position and hashes can be checked
+    rel_fns = obj.rel_fns;
+    n = numel(rel_fns);
+
+    if iscellstr(obj.content_hash)
+        mocov_line_covered('register', rel_fns, zeros(n, 1), ...
+                           obj.content_hash);
+    else
+        mocov_line_covered('register', rel_fns);
+    end
+
+    % snapshots recorded with another granularity cannot be merged
+    mocov_line_covered('granularity', obj.granularity);
+
+    n_snapshots = numel(snapshot_fns);
+    for k = 1:n_snapshots
+        snapshot_fn = snapshot_fns{k};
+        if is_notifying(monitor)
+            notify(monitor, '.', sprintf('Merging snapshot %d/%d: %s', ...
+                                         k, n_snapshots, snapshot_fn));
+        end
+        mocov_line_covered('merge', snapshot_fn);
+    end
@@ -0,0 +1,69 @@
+function [mfiles, content_hash] = parse_mfiles(obj, fns)
+    % parse m-files, reusing parsed files from the cache if possible
+    %
+    % [mfiles,content_hash]=parse_mfiles(obj, fns)
+    %
+    % Inputs:
+    %   obj                 MOcovMFileCollection instance
+    %   fns                 Nx1 cell with names of m-files
+    %
+    % Outputs:
+    %   mfiles              Nx1 cell with a MOcovMFile instance for each
+    %                       file in fns
+    %   content_hash        Nx1 cell with the md5 checksum of each file in
+    %                       fns if the cache is used or the hash_content
+    %                       option was set; with empty elements otherwise
+    %
+    % Notes:
+    %   - this function is used by prepare, possibly in several processes
+    %     at once (see run_jobs); each process writes to the cache safely.
+
+    use_cache = strcmp(obj.method, 'file') && ~isempty(obj.cache_dir);
+
+    n = numel(fns);
+    mfiles = cell(n, 1);
+    content_hash = cell(n, 1);
+    for k = 1:n
+        fn = fns{k};
+        if use_cache
+            [mfiles{k}, content_hash{k}] = get_cached_mfile(obj, fn);
+        else
+            mfiles{k} = MOcovMFile(fn);
+            if obj.hash_content
+                content_hash{k} = get_content_hash(mfiles{k});
+            end
+        end
+    end
+
+function [mfile, content_hash] = get_cached_mfile(obj, fn)
+    % parse fn, unless a file with the same contents was parsed before
+    content_hash = mocov_util_md5(fn);
+    cache_fn = get_cache_filename(obj, [content_hash '.mat']);
+
+    if exist(cache_fn, 'file')
+        try
+            cached = load(cache_fn, '-mat');
+            parse_info = cached.parse_info;
+            parse_info.content_hash = content_hash;
+            mfile = MOcovMFile(fn, parse_info);
+            if is_notifying(obj.monitor)
+                notify(obj.monitor, '', sprintf('Using cached %s', fn));
+            end
+            return
+        catch
+            % the cached file is incomplete or was stored in another
+            % format; parse the file again and overwrite it
+        end
+    end
+
+    mfile = MOcovMFile(fn);
+    parse_info = get_parse_info(mfile);
+
+    % writing to a temporary file first means that other processes using
+    % the same cache never read a partially written file
+    tmp_fn = [cache_fn '.' get_unique_suffix()];
+    save(tmp_fn, 'parse_info', '-mat');
+    movefile(tmp_fn, cache_fn, 'f');
+
+function suffix = get_unique_suffix()
+    [unused, suffix] = fileparts(tempname());
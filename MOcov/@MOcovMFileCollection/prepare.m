@@ -14,16 +14,7 @@ function obj = prepare(obj)
 
     monitor = obj.monitor;
 
-    fns = mocov_find_files(obj.root_dir, '*.m', monitor, obj.exclude_pat);
-    n = numel(fns);
-
-    mfiles = cell(n, 1);
-    for k = 1:n
-        fn = fns{k};
-        mfiles{k} = MOcovMFile(fn);
-    end
-
-    obj.mfiles = mfiles;
+    obj = load_mfiles(obj);
 
     if ~ischar(obj.method)
         error('method must be char, found %s', class(obj.method));
@@ -39,15 +30,74 @@ function obj = prepare(obj)
             obj.orig_path = path();
             notify(monitor, sprintf('Preserving original path\n'));
 
+            if obj.timing
+                % measured before registering the m-files, as measuring
+                % resets the state of mocov_line_covered afterwards
+                obj.probe_overhead = mocov_timing_probe_overhead();
+                notify(monitor, sprintf('Probe overhead is %.3g s\n', ...
+                                        obj.probe_overhead));
+            end
+
             temp_dir = tempname();
             notify(monitor, sprintf('Rewriting m-files\n'));
+            start_phase(monitor, 'rewrite');
             obj = rewrite_mfiles(obj, temp_dir);
+            stop_phase(monitor, 'rewrite');
+
+            % only the directories of the rewritten tree that correspond
+            % to directories in the original path are added, rather than
+            % all its subdirectories
+            start_phase(monitor, 'addpath');
+            path_dirs = get_rewritten_path(obj, obj.orig_path);
+            if ~isempty(path_dirs)
+                addpath(path_dirs{:});
+            end
+            stop_phase(monitor, 'addpath');
+            add_count(monitor, 'path_dirs', numel(path_dirs));
+            if is_notifying(monitor)
+                notify(monitor, '', sprintf('Path is: %s\n', path()));
+            end
+
+            if obj.timing
+                mocov_line_covered('timing', true);
+            end
 
-            addpath(genpath(temp_dir));
-            notify(monitor, '', sprintf('Path is: %s\n', path()));
+            if strcmp(obj.mode, 'hit')
+                mocov_line_covered('boolean', true);
+                init_deinstrument(obj);
+            end
 
         otherwise
             error('illegal method %s', obj.method);
     end
 
     notify(monitor, sprintf('Coverage preparation complete\n'));
+
+function init_deinstrument(obj)
+    % allow mocov_deinstrument to replace the rewritten m-files by their
+    % originals once all lines that record coverage have been hit
+    mfiles = obj.mfiles;
+    n = numel(mfiles);
+    orig_fns = cell(n, 1);
+    recorded_lines = cell(n, 1);
+    can_replace = true(n, 1);
+    for k = 1:n
+        mfile = mfiles{k};
+        orig_fns{k} = get_filename(mfile);
+
+        % as in write_lines_with_prefix
+        if strcmp(obj.granularity, 'block')
+            leader = get_lines_block_leader(mfile);
+            recorded_lines{k} = find(leader(:) == (1:numel(leader))');
+        else
+            recorded_lines{k} = find(get_lines_executable(mfile));
+        end
+
+        % clearing these would change their behaviour
+        matches = regexp(get_lines(mfile), ...
+                         '^\s*(persistent|mlock)(\W|$)', 'once');
+        can_replace(k) = all(cellfun(@isempty, matches));
+    end
+
+    mocov_deinstrument('init', obj.temp_dir, obj.rel_fns, orig_fns, ...
+                       recorded_lines, can_replace);
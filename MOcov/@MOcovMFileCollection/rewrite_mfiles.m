@@ -21,24 +21,34 @@ function obj = rewrite_mfiles(obj, temp_dir)
         error('No mfiles - did you call ''prepare''?');
     end
 
-    root_dir = obj.root_dir;
+    rel_fns = obj.rel_fns;
 
     n = numel(mfiles);
+    n_lines = zeros(n, 1);
     for k = 1:n
         mfile = mfiles{k};
 
-        fn = get_filename(mfile);
-
-        rel_fn = mocov_get_relative_path(root_dir, fn);
-        tmp_fn = fullfile(temp_dir, rel_fn);
+        % only lines up to the last executable line can be covered
+        last_executable = find(get_lines_executable(mfile), 1, 'last');
+        if ~isempty(last_executable)
+            n_lines(k) = last_executable;
+        end
+    end
 
-        % on Windows the path may contain backslashes, which sprintf
-        % interprets as escape characters. Therefore we construct the
-        % decorator using string concatenation.
-        prefix = sprintf('mocov_line_covered(%d,''%s'',', k, rel_fn);
-        suffix = ');';
-        decorator = @(line_number) [prefix sprintf('%d', line_number) suffix];
+    % register all files once, so that the rewritten files only have to
+    % pass the index of a file when one of its lines is covered. Passing
+    % the number of lines allows for allocating space for all line counts
+    % at once. Content hashes, if known, are stored in coverage snapshots.
+    if iscellstr(obj.content_hash)
+        mocov_line_covered('register', rel_fns, n_lines, obj.content_hash);
+    else
+        mocov_line_covered('register', rel_fns, n_lines);
+    end
+    mocov_line_covered('granularity', obj.granularity);
 
-        write_lines_with_prefix(mfile, tmp_fn, decorator);
-        notify(obj.monitor, '.', sprintf('Rewrote %s', rel_fn));
+    if strcmp(obj.probe, 'buffer')
+        mocov_line_buffer('init', n_lines);
     end
+
+    % rewritten files are written independently, possibly in parallel
+    run_jobs(obj, 'write_rewritten_mfiles', (1:n)');
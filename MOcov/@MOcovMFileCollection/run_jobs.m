@@ -0,0 +1,58 @@
+function varargout = run_jobs(obj, method_name, items, varargin)
+    % run a method for subsets of items, possibly in parallel
+    %
+    % [out1,...]=run_jobs(obj, method_name, items, arg1, ...)
+    %
+    % Inputs:
+    %   obj                 MOcovMFileCollection instance
+    %   method_name         name of a method of MOcovMFileCollection that
+    %                       processes each item independently. It is
+    %                       called as [out1,...]=method_name(obj, arg1, ...,
+    %                       items_subset)
+    %   items               Nx1 cell or numeric array
+    %   arg*                additional arguments for method_name
+    %
+    % Output:
+    %   out*                Nx1 array, the concatenation of the outputs for
+    %                       all subsets of items. Each output of method_name
+    %                       must have one row for each of its items.
+    %
+    % Notes:
+    %   - if obj was constructed with the 'jobs' option set to a value
+    %     greater than one, items are split in that many subsets which are
+    %     processed in parallel (see mocov_run_jobs). Otherwise method_name
+    %     is called once with all items.
+
+    items = items(:);
+    n_items = numel(items);
+    n_jobs = min(obj.jobs, n_items);
+
+    if n_jobs <= 1
+        [varargout{1:nargout}] = feval(method_name, obj, varargin{:}, items);
+        return
+    end
+
+    % workers should not show progress
+    obj.monitor = MOcovProgressMonitor(0);
+
+    % workers only access m-files by index, and a containers.Map cannot
+    % be stored in the files passed to worker processes
+    obj.mfile_index = [];
+
+    % consecutive items are processed by the same job
+    job_idx = ceil((1:n_items)' * n_jobs / n_items);
+    job_args = cell(n_jobs, 1);
+    for j = 1:n_jobs
+        job_args{j} = [varargin, {items(job_idx == j)}];
+    end
+
+    outputs = mocov_run_jobs(n_jobs, method_name, {obj}, job_args, nargout);
+
+    varargout = cell(1, nargout);
+    for i = 1:nargout
+        parts = cell(n_jobs, 1);
+        for j = 1:n_jobs
+            parts{j} = outputs{j}{i};
+        end
+        varargout{i} = vertcat(parts{:});
+    end
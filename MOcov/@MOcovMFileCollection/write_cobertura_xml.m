@@ -18,36 +18,34 @@ function write_cobertura_xml(obj, output_fn)
                               'branch-rate="1.0">\n'...
                               '<classes>'], overall_coverage);
 
+    package_footer = '</classes></package></packages>';
+    footer = '</coverage>';
+
+    % write the report one m-file at a time
+    fid = fopen(output_fn, 'w');
+    cleaner = onCleanup(@()fclose(fid));
+    fprintf(fid, '%s\n', header, sources, package_header);
+
     mfiles = obj.mfiles;
     n = numel(mfiles);
 
-    body_cell = cell(n, 1);
-
+    do_notify = is_notifying(monitor);
     for k = 1:n
         mfile = mfiles{k};
 
-        body_cell{k} = get_coverage_xml(mfile, root_dir);
+        fprintf(fid, '%s\n', get_coverage_xml(mfile, root_dir));
 
-        msg = sprintf('Written for %s', get_filename(mfile));
-        notify(monitor, '.', msg);
+        if do_notify
+            msg = sprintf('Written for %s', get_filename(mfile));
+            notify(monitor, '.', msg);
+        end
     end
 
-    package_footer = '</classes></package></packages>';
-    footer = '</coverage>';
-
-    full_report = sprintf('%s\n', header, sources, package_header, ...
-                          body_cell{:}, ...
-                          package_footer, footer);
+    fprintf(fid, '%s\n', package_footer, footer);
 
-    write_to_file(output_fn, full_report);
     msg = sprintf('written to %s', output_fn);
     notify(monitor, msg);
 
-function write_to_file(fn, s)
-    fid = fopen(fn, 'w');
-    cleaner = onCleanup(@()fclose(fid));
-    fprintf(fid, '%s', s);
-
 function coverage = compute_coverage(obj)
 
     numerator = 0;
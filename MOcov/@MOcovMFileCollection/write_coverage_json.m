@@ -0,0 +1,72 @@
+function write_coverage_json(obj, fid)
+    % Write JSON coverage representation to a file, one m-file at a time
+    %
+    % write_coverage_json(obj, fid)
+    %
+    % Inputs:
+    %   obj                 MOcovMFileCollection instance
+    %   fid                 file identifier of a file opened for writing
+    %
+    % Notes:
+    %   - the JSON representation has elements:
+    %       'service_job_id' Travis job id
+    %       'service_name'   'travis-ci' when running on Travis
+    %       'source_files'   Array with JSON representation of MOcovMFile
+    %                        instances (see MOcovMFile/get_coverage_json)
+    %   - only the JSON representation of a single m-file is kept in memory
+    %     at any time
+    %
+    % See also: get_coverage_json, write_json_file
+
+    abs_root_dir = mocov_get_absolute_path(obj.root_dir);
+    git_root_dir = mocov_util_get_root_path_containing('.git', abs_root_dir);
+
+    service = get_service_params();
+    misc_data = get_misc_data(service);
+
+    fprintf(fid, ['{ \n', ...
+                  '"service_job_id": "%s",\n', ...
+                  '"service_name": "%s",\n', ...
+                  '%s', ...
+                  '"source_files": [\n'], ...
+            service.job_id, ...
+            service.service_name, ...
+            misc_data);
+
+    n = numel(obj.mfiles);
+    for k = 1:n
+        if k > 1
+            fprintf(fid, ',');
+        end
+        fprintf(fid, '%s', get_coverage_json(obj.mfiles{k}, git_root_dir));
+    end
+
+    fprintf(fid, '\n]\n}\n');
+
+function params = get_service_params()
+    params = struct();
+    if ~isequal(getenv('CI'), 'true')
+        % run locally
+        params.job_id = 'none';
+        params.service_name = 'none';
+        return
+    end
+
+    if isequal(getenv('TRAVIS'), 'true')
+        params.service_name = 'travis-ci';
+        params.job_id = getenv('TRAVIS_JOB_ID');
+        params.parallel = getenv('COVERALLS_PARALLEL');
+        return
+    end
+
+    params.job_id = 'job id unknown';
+    params.service_name = 'service name unknown';
+
+function misc_data = get_misc_data(params)
+    misc_data_cell = cell(0);
+    if isfield(params, 'parallel') && ~isempty(params.parallel)
+        % attempt to support parallel
+        misc_data_cell{end + 1} = sprintf('"parallel": %s,\n', ...
+                                          lower(params.parallel));
+    end
+    misc_data = sprintf('%s', misc_data_cell{:});
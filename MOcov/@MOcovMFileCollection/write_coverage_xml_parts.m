@@ -0,0 +1,42 @@
+function part_fns = write_coverage_xml_parts(obj, output_dir, idxs)
+    % Write XML coverage representation of individual m-files to a file
+    %
+    % part_fns=write_coverage_xml_parts(obj, output_dir, idxs)
+    %
+    % Inputs:
+    %   obj                 MOcovMFileCollection instance
+    %   output_dir          directory in which the file is written
+    %   idxs                Nx1 vector with indices of m-files
+    %
+    % Output:
+    %   part_fns            Nx1 cell, with each element the name of the file
+    %                       with the XML coverage representation of all
+    %                       m-files in idxs (see get_coverage_xml), in the
+    %                       order of idxs
+    %
+    % Notes:
+    %   - this function is used by write_xml_file, possibly in several
+    %     processes at once (see run_jobs). Each process writes its own
+    %     file, named after the first index in idxs.
+
+    n = numel(idxs);
+    part_fn = fullfile(output_dir, sprintf('part%d.xml', idxs(1)));
+
+    fid = fopen(part_fn, 'w');
+    cleaner = onCleanup(@()fclose(fid));
+
+    % messages are only built if they are printed
+    do_notify = is_notifying(obj.monitor);
+
+    for j = 1:n
+        mfile = obj.mfiles{idxs(j)};
+
+        fprintf(fid, '%s\n', get_coverage_xml(mfile, obj.root_dir));
+
+        if do_notify
+            msg = sprintf('Written for %s', get_filename(mfile));
+            notify(obj.monitor, '.', msg);
+        end
+    end
+
+    part_fns = repmat({part_fn}, n, 1);
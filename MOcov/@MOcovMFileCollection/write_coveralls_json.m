@@ -2,9 +2,11 @@ function write_coveralls_json(obj, output_fn)
     monitor = obj.monitor;
     notify(monitor, sprintf('Writing JSON file to %s', output_fn));
 
-    json = get_coverage_json(obj);
     fid = fopen(output_fn, 'w');
+    if fid == -1
+        error('Unable to open %s for writing', output_fn);
+    end
     cleaner = onCleanup(@()fclose(fid));
-    fprintf(fid, '%s', json);
+    write_coverage_json(obj, fid);
 
     notify(monitor, sprintf('Completed writing JSON file to %s', output_fn));
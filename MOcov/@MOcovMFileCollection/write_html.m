@@ -10,20 +10,20 @@ function write_html(obj, output_dir)
 
     mfiles = obj.mfiles;
     n = numel(mfiles);
-    mfile_node_fns = cell(n, 1);
+    mfile_node_fns = get_html_page_names(obj);
 
     notify(monitor, sprintf('Writing html files in %s', output_dir));
+    do_notify = is_notifying(monitor);
 
     for k = 1:n
-        node_rel_fn = sprintf('node%d.html', k);
-        mfile_node_fns{k} = node_rel_fn;
-
         mfile = mfiles{k};
-        node_fn = fullfile(output_dir, node_rel_fn);
+        node_fn = fullfile(output_dir, mfile_node_fns{k});
         write_html(mfile, node_fn, index_rel_fn);
 
-        msg = sprintf('Written to %s', node_fn);
-        notify(monitor, '.', msg);
+        if do_notify
+            msg = sprintf('Written to %s', node_fn);
+            notify(monitor, '.', msg);
+        end
     end
 
     write_index_html(index_fn, mfiles, mfile_node_fns);
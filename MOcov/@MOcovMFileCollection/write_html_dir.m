@@ -8,8 +8,13 @@ function write_html_dir(obj, output_dir)
     %   output_dir          HTML output directory
     %
     % Notes:
-    %   - this function writes a file index.html, as well as node*.html files
-    %     for each individual MOcovMFile.
+    %   - this function writes a file index.html, as well as an HTML file
+    %     for each individual MOcovMFile (see get_html_page_names).
+    %   - a manifest file in output_dir records, for each page, the
+    %     checksum of the m-file and of its coverage. When the report is
+    %     written again to the same directory, only pages for which either
+    %     changed are written, and pages of m-files that are no longer in
+    %     the collection are deleted. The index is always written.
 
     if ~mocov_util_isfolder(output_dir)
         mkdir(output_dir);
@@ -19,31 +24,105 @@ function write_html_dir(obj, output_dir)
 
     index_rel_fn = 'index.html';
     index_fn = fullfile(output_dir, index_rel_fn);
+    manifest_fn = fullfile(output_dir, 'mocov_manifest.mat');
 
     mfiles = obj.mfiles;
     n = numel(mfiles);
-    mfile_node_fns = cell(n, 1);
 
-    % write single HTML file for each m-file
-    notify(monitor, sprintf('Writing html files in %s', output_dir));
+    mfile_node_fns = get_html_page_names(obj);
+    manifest = get_manifest(mfiles, mfile_node_fns);
+    old_manifest = load_manifest(manifest_fn);
 
-    for k = 1:n
-        node_rel_fn = sprintf('node%d.html', k);
-        mfile_node_fns{k} = node_rel_fn;
+    % write single HTML file for each m-file that changed
+    is_changed = get_changed_pages(manifest, old_manifest, output_dir);
+    notify(monitor, sprintf('Writing html files in %s (%d of %d changed)', ...
+                            output_dir, sum(is_changed), n));
+    run_jobs(obj, 'write_html_nodes', find(is_changed), ...
+             output_dir, index_rel_fn);
+    delete_stale_pages(manifest, old_manifest, output_dir);
 
-        mfile = mfiles{k};
-        node_fn = fullfile(output_dir, node_rel_fn);
-        write_html(mfile, node_fn, index_rel_fn);
+    add_count(monitor, 'html_pages_written', sum(is_changed));
+    add_count(monitor, 'html_pages_unchanged', n - sum(is_changed));
 
-        msg = sprintf('Written to %s', node_fn);
-        notify(monitor, '.', msg);
-    end
+    % the manifest is written last, so that pages that were not written
+    % because of an error are written next time
+    save(manifest_fn, 'manifest', '-mat');
 
     % write index HTML file
     write_index_html(index_fn, mfiles, mfile_node_fns);
     msg = sprintf('Index written to %s\n', index_fn);
     notify(monitor, msg);
 
+function manifest = get_manifest(mfiles, page_names)
+    n = numel(mfiles);
+
+    manifest = struct();
+    manifest.version = mocov_util_version();
+    manifest.page_names = page_names;
+    manifest.filenames = cell(n, 1);
+    manifest.content_hashes = cell(n, 1);
+    manifest.coverage_hashes = cell(n, 1);
+
+    for k = 1:n
+        mfile = mfiles{k};
+        missed = get_lines_executable(mfile) & ~get_lines_executed(mfile);
+
+        manifest.filenames{k} = get_filename(mfile);
+        manifest.content_hashes{k} = get_content_hash(mfile);
+        manifest.coverage_hashes{k} = mocov_md5(char('0' + missed(:)'));
+    end
+
+function manifest = load_manifest(manifest_fn)
+    manifest = [];
+    if ~exist(manifest_fn, 'file')
+        return
+    end
+
+    try
+        loaded = load(manifest_fn, '-mat');
+        if strcmp(loaded.manifest.version, mocov_util_version())
+            manifest = loaded.manifest;
+        end
+    catch
+        % the manifest is incomplete or was stored in another format;
+        % all pages are written again
+    end
+
+function is_changed = get_changed_pages(manifest, old_manifest, output_dir)
+    n = numel(manifest.page_names);
+    is_changed = true(n, 1);
+    if isempty(old_manifest)
+        return
+    end
+
+    [is_old, old_idxs] = ismember(manifest.page_names, ...
+                                  old_manifest.page_names);
+    for k = find(is_old(:))'
+        j = old_idxs(k);
+        is_changed(k) = ~(strcmp(manifest.filenames{k}, ...
+                                 old_manifest.filenames{j}) && ...
+                          strcmp(manifest.content_hashes{k}, ...
+                                 old_manifest.content_hashes{j}) && ...
+                          strcmp(manifest.coverage_hashes{k}, ...
+                                 old_manifest.coverage_hashes{j}) && ...
+                          exist(fullfile(output_dir, ...
+                                         manifest.page_names{k}), 'file'));
+    end
+
+function delete_stale_pages(manifest, old_manifest, output_dir)
+    if isempty(old_manifest)
+        return
+    end
+
+    % only pages listed in the manifest are deleted, never other files
+    stale = setdiff(old_manifest.page_names, manifest.page_names);
+    for k = 1:numel(stale)
+        fn = fullfile(output_dir, stale{k});
+        if exist(fn, 'file')
+            delete(fn);
+        end
+    end
+
 function write_index_html(output_fn, mfiles, mfile_node_fns)
     % build an index html file
 
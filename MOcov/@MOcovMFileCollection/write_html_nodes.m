@@ -0,0 +1,36 @@
+function node_rel_fns = write_html_nodes(obj, output_dir, index_rel_fn, idxs)
+    % Write HTML coverage report for individual m-files
+    %
+    % node_rel_fns=write_html_nodes(obj, output_dir, index_rel_fn, idxs)
+    %
+    % Inputs:
+    %   obj                 MOcovMFileCollection instance
+    %   output_dir          HTML output directory
+    %   index_rel_fn        name of the index file, relative to output_dir
+    %   idxs                Nx1 vector with indices of the m-files to write
+    %
+    % Output:
+    %   node_rel_fns        Nx1 cell with the names of the files written,
+    %                       relative to output_dir
+    %
+    % Notes:
+    %   - this function is used by write_html_dir, possibly in several
+    %     processes at once (see run_jobs).
+    %   - the names of the files written are given by get_html_page_names.
+
+    n = numel(idxs);
+    node_rel_fns = get_html_page_names(obj, idxs);
+
+    % messages are only built if they are printed
+    do_notify = is_notifying(obj.monitor);
+
+    for j = 1:n
+        k = idxs(j);
+        node_fn = fullfile(output_dir, node_rel_fns{j});
+        write_html(obj.mfiles{k}, node_fn, index_rel_fn);
+
+        if do_notify
+            msg = sprintf('Written to %s', node_fn);
+            notify(obj.monitor, '.', msg);
+        end
+    end
@@ -9,16 +9,18 @@ function write_json_file(obj, output_fn)
     %
     % Notes:
     %   - this function writes a JSON file with the contents from
-    %   get_coverage_json
+    %     get_coverage_json, one m-file at a time
     %
-    % See also: get_coverage_json
+    % See also: get_coverage_json, write_coverage_json
 
     monitor = obj.monitor;
     notify(monitor, sprintf('Writing JSON file to %s', output_fn));
 
-    json = get_coverage_json(obj);
     fid = fopen(output_fn, 'w');
+    if fid == -1
+        error('Unable to open %s for writing', output_fn);
+    end
     cleaner = onCleanup(@()fclose(fid));
-    fprintf(fid, '%s', json);
+    write_coverage_json(obj, fid);
 
     notify(monitor, sprintf('Completed writing JSON file to %s', output_fn));
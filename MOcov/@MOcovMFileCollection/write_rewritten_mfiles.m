@@ -0,0 +1,193 @@
+function write_rewritten_mfiles(obj, idxs)
+    % write m-files decorated with statements that record coverage
+    %
+    % write_rewritten_mfiles(obj, idxs)
+    %
+    % Inputs:
+    %   obj                 MOcovMFileCollection instance, for which
+    %                       rewrite_mfiles has set the temporary directory
+    %                       and registered all m-files
+    %   idxs                vector with indices of the m-files to write
+    %
+    % Notes:
+    %   - this function is used by rewrite_mfiles, possibly in several
+    %     processes at once (see run_jobs).
+
+    % content hashes are also set without a cache, for snapshots
+    use_cache = strcmp(obj.method, 'file') && ~isempty(obj.cache_dir);
+
+    % messages are only built if they are printed
+    do_notify = is_notifying(obj.monitor);
+
+    for k = idxs(:)'
+        mfile = obj.mfiles{k};
+
+        rel_fn = obj.rel_fns{k};
+        tmp_fn = fullfile(obj.temp_dir, rel_fn);
+
+        if ~use_cache
+            decorator = get_decorator(obj, mfile, sprintf('%d', k));
+            write_lines_with_prefix(mfile, tmp_fn, decorator, ...
+                                    obj.granularity);
+        else
+            write_cached_lines_with_prefix(obj, k, tmp_fn);
+        end
+        if do_notify
+            notify(obj.monitor, '.', sprintf('Rewrote %s', rel_fn));
+        end
+    end
+
+function decorator = get_decorator(obj, mfile, idx_str)
+    if strcmp(obj.probe, 'buffer')
+        decorator = get_buffer_decorator(mfile, idx_str);
+    else
+        decorator = get_call_decorator(idx_str);
+    end
+
+function write_cached_lines_with_prefix(obj, idx, tmp_fn)
+    % the rewritten file depends not only on the contents of the original
+    % file, but also on how coverage is recorded
+    content_hash = obj.content_hash{idx};
+    name = sprintf('%s_%s_%s.m', content_hash, obj.probe, obj.granularity);
+    cache_fn = get_cache_filename(obj, name);
+
+    % the cached file does not depend on the index of the file either,
+    % so that it is still used when other files are added or removed.
+    % Instead of the index it has the content hash as a placeholder,
+    % which cannot occur in the original file.
+    if ~exist(cache_fn, 'file')
+        % as in parse_mfiles, write to a temporary file first
+        [unused, suffix] = fileparts(tempname());
+        cache_tmp_fn = [cache_fn '.' suffix];
+        mfile = obj.mfiles{idx};
+        decorator = get_decorator(obj, mfile, content_hash);
+        write_lines_with_prefix(mfile, cache_tmp_fn, decorator, ...
+                                obj.granularity);
+        movefile(cache_tmp_fn, cache_fn, 'f');
+    end
+
+    text = mocov_util_read_text(cache_fn);
+    text = strrep(text, content_hash, sprintf('%d', idx));
+
+    mocov_util_mkdir_recursively(fileparts(tmp_fn));
+    fid = fopen(tmp_fn, 'w');
+    cleaner = onCleanup(@()fclose(fid));
+    fprintf(fid, '%s', text);
+
+function decorator = get_call_decorator(idx_str)
+    prefix = sprintf('mocov_line_covered(%s,', idx_str);
+    suffix = ');';
+    decorator = @(line_number) [prefix sprintf('%d', line_number) suffix];
+
+function decorator = get_buffer_decorator(mfile, idx_str)
+    % Lines inside a function increase their count in the global line
+    % buffer, which must be declared in the first executable line of each
+    % function. Lines outside functions (in scripts) cannot declare a
+    % global variable without affecting the caller's workspace, and
+    % therefore call mocov_line_covered instead. Nested functions cannot
+    % declare global variables either, so that all lines of a file with
+    % nested functions call mocov_line_covered.
+    call_decorator = get_call_decorator(idx_str);
+    if has_nested_functions(mfile)
+        decorator = call_decorator;
+        return
+    end
+
+    name = mocov_line_buffer('name', idx_str);
+
+    executable = get_lines_executable(mfile);
+    function_start = get_lines_function_start(mfile);
+
+    n = numel(executable);
+    prefixes = cell(n, 1);
+    inside_function = false;
+    needs_global = false;
+    for k = 1:n
+        if function_start(k)
+            inside_function = true;
+            needs_global = true;
+        end
+
+        if ~executable(k)
+            continue
+        end
+
+        if ~inside_function
+            prefixes{k} = call_decorator(k);
+            continue
+        end
+
+        counter = sprintf('%s(%d)', name, k);
+        prefix = sprintf('%s=%s+1;', counter, counter);
+        if needs_global
+            prefix = sprintf('global %s;%s', name, prefix);
+            needs_global = false;
+        end
+        prefixes{k} = prefix;
+    end
+
+    decorator = @(line_number) prefixes{line_number};
+
+function tf = has_nested_functions(mfile)
+    % Keywords that open a block are matched with the keywords that close
+    % it. Because either all functions in a file are closed with 'end' or
+    % none are, a function that starts while another one is open is only
+    % nested if all functions are closed at the end of the file.
+    openers = {'if', 'for', 'parfor', 'while', 'switch', 'try', 'spmd', ...
+               'function', 'classdef', 'unwind_protect'};
+    class_openers = {'properties', 'methods', 'events', 'enumeration'};
+    closers = {'end', 'endif', 'endfor', 'endparfor', 'endwhile', ...
+               'endswitch', 'end_try_catch', 'endspmd', 'endfunction', ...
+               'endclassdef', 'end_unwind_protect', 'endproperties', ...
+               'endmethods', 'endevents', 'endenumeration'};
+
+    lines = get_lines(mfile);
+
+    open_blocks = {};
+    inside_class = false;
+    inside_block_comment = false;
+    starts_inside_function = false;
+    for k = 1:numel(lines)
+        line = lines{k};
+        line_trimmed = strtrim(line);
+        if inside_block_comment
+            inside_block_comment = ~strcmp(line_trimmed, '%}');
+            continue
+        elseif strcmp(line_trimmed, '%{')
+            inside_block_comment = true;
+            continue
+        end
+
+        % as in mocov_scan_mfile, strings and comments are removed
+        code = regexprep(line, '''.*''|".*"', '');
+        comment_start = find(code == '%' | code == '#', 1);
+        if ~isempty(comment_start)
+            code = code(1:(comment_start - 1));
+        end
+
+        % 'end' used as an index is not a keyword
+        prev_code = '';
+        while ~strcmp(code, prev_code)
+            prev_code = code;
+            code = regexprep(code, '\([^()]*\)|\{[^{}]*\}', '');
+        end
+
+        words = regexp(code, '(?<![\.\w])[a-z_]+(?!\w)', 'match');
+        for j = 1:numel(words)
+            word = words{j};
+            if any(strcmp(word, openers)) || ...
+                        (inside_class && j == 1 && ...
+                         any(strcmp(word, class_openers)))
+                if strcmp(word, 'function')
+                    starts_inside_function = starts_inside_function || ...
+                                    any(strcmp(open_blocks, 'function'));
+                end
+                inside_class = inside_class || strcmp(word, 'classdef');
+                open_blocks{end + 1} = word;
+            elseif any(strcmp(word, closers)) && ~isempty(open_blocks)
+                open_blocks(end) = [];
+            end
+        end
+    end
+
+    tf = starts_inside_function && ~any(strcmp(open_blocks, 'function'));
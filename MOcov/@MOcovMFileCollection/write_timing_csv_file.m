@@ -0,0 +1,42 @@
+function write_timing_csv_file(obj, output_fn)
+    % Write the time spent on each line of an m-file collection as CSV
+    %
+    % write_timing_csv_file(obj, output_fn)
+    %
+    % Inputs:
+    %   obj                 MOcovMFileCollection instance, for which
+    %                       coverage was collected with timing
+    %   output_fn           CSV output file
+    %
+    % Notes:
+    %   - the file has a header row, followed by one row for each line
+    %     with time spent on it, with columns file, function, line,
+    %     count, time and self_time (see get_hotspots). Rows are sorted by
+    %     decreasing self time; times are in seconds.
+    %
+    % See also: get_hotspots, write_timing_html_file
+
+    monitor = obj.monitor;
+    notify(monitor, sprintf('Writing timing csv file %s', output_fn));
+
+    spots = get_hotspots(obj);
+
+    fid = fopen(output_fn, 'w');
+    if fid == -1
+        error('Unable to open %s for writing', output_fn);
+    end
+    cleaner = onCleanup(@()fclose(fid));
+
+    fprintf(fid, 'file,function,line,count,time,self_time\n');
+    for k = 1:numel(spots.line)
+        fprintf(fid, '%s,%s,%d,%d,%.9g,%.9g\n', ...
+                quote_csv(spots.filename{k}), quote_csv(spots.name{k}), ...
+                spots.line(k), spots.count(k), spots.time(k), ...
+                spots.self_time(k));
+    end
+
+    msg = sprintf('written to %s', output_fn);
+    notify(monitor, msg);
+
+function s = quote_csv(s)
+    s = ['"' strrep(s, '"', '""') '"'];
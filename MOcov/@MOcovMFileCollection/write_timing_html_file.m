@@ -0,0 +1,88 @@
+function write_timing_html_file(obj, output_fn)
+    % Write HTML report of the functions and lines with the most time
+    %
+    % write_timing_html_file(obj, output_fn)
+    %
+    % Inputs:
+    %   obj                 MOcovMFileCollection instance, for which
+    %                       coverage was collected with timing
+    %   output_fn           HTML output file
+    %
+    % Notes:
+    %   - the report has a table with all functions, and a table with all
+    %     lines with time spent on them, both sorted by decreasing self
+    %     time (see get_hotspots).
+    %
+    % See also: get_hotspots, write_timing_csv_file
+
+    monitor = obj.monitor;
+    notify(monitor, sprintf('Writing timing html file %s', output_fn));
+
+    [line_spots, function_spots] = get_hotspots(obj);
+
+    fid = fopen(output_fn, 'w');
+    if fid == -1
+        error('Unable to open %s for writing', output_fn);
+    end
+    cleaner = onCleanup(@()fclose(fid));
+
+    fprintf(fid, ['<!DOCTYPE html>\n'...
+                  '<html><head><title>Timing</title>'...
+                  '<STYLE TYPE="text/css"><!--'...
+                  'TD{font-family: "Courier New", '...
+                  'Courier, monospace; font-size: 10pt;}'...
+                  '---></STYLE>'...
+                  '</head>'...
+                  '<body>'...
+                  '<p>Probe overhead of %.3g s subtracted from each '...
+                  'count to compute self time</p>\n'], ...
+            obj.probe_overhead);
+
+    fprintf(fid, '<h1>Functions</h1><table>\n');
+    fprintf(fid, ['<tr><th>Self time (s)</th><th>Time (s)</th>'...
+                  '<th>Calls</th><th>File</th><th>Line</th>'...
+                  '<th>Function</th></tr>\n']);
+    for k = 1:numel(function_spots.line)
+        fprintf(fid, ['<tr><td align="right">%.6f</td>'...
+                      '<td align="right">%.6f</td>'...
+                      '<td align="right">%d</td><td>%s</td>'...
+                      '<td align="right">%d</td><td>%s</td></tr>\n'], ...
+                function_spots.self_time(k), function_spots.time(k), ...
+                function_spots.count(k), ...
+                convert_raw_to_html(function_spots.filename{k}), ...
+                function_spots.line(k), ...
+                convert_raw_to_html(function_spots.name{k}));
+    end
+    fprintf(fid, '</table>\n');
+
+    fprintf(fid, '<h1>Lines</h1><table>\n');
+    fprintf(fid, ['<tr><th>Self time (s)</th><th>Time (s)</th>'...
+                  '<th>Count</th><th>File</th><th>Line</th>'...
+                  '<th>Code</th></tr>\n']);
+    for k = 1:numel(line_spots.line)
+        fprintf(fid, ['<tr><td align="right">%.6f</td>'...
+                      '<td align="right">%.6f</td>'...
+                      '<td align="right">%d</td><td>%s</td>'...
+                      '<td align="right">%d</td><td>%s</td></tr>\n'], ...
+                line_spots.self_time(k), line_spots.time(k), ...
+                line_spots.count(k), ...
+                convert_raw_to_html(line_spots.filename{k}), ...
+                line_spots.line(k), ...
+                convert_raw_to_html(line_spots.code{k}));
+    end
+    fprintf(fid, '</table></body></html>');
+
+    msg = sprintf('written to %s', output_fn);
+    notify(monitor, msg);
+
+function line = convert_raw_to_html(line)
+    orig_new = {'&', '&amp;'; ...
+                ' ', '&nbsp;'; ...
+                '<', '&lt;'; ...
+                '>', '&gt;' ...
+               };
+
+    n_replacements = size(orig_new, 1);
+    for k = 1:n_replacements
+        line = strrep(line, orig_new{k, 1}, orig_new{k, 2});
+    end
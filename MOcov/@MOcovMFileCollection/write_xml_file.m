@@ -37,37 +37,77 @@ function write_xml_file(obj, output_fn)
                               'branch-rate="%.3f">\n'...
                               '<classes>'], overall_coverage, branch_rate);
 
+    package_footer = '</classes></package></packages>';
+    footer = '</coverage>';
+
+    % write the report one m-file at a time, so that the full report is
+    % never in memory
+    fid = fopen(output_fn, 'w');
+    if fid == -1
+        error('Unable to open %s for writing', output_fn);
+    end
+    cleaner = onCleanup(@()fclose(fid));
+
+    fprintf(fid, '%s\n', header, sources, package_header);
+
     % add for each m-file
-    mfiles = obj.mfiles;
-    n = numel(mfiles);
+    n = count_mfiles(obj);
+    if obj.jobs > 1 && n > 1
+        write_mfiles_in_parallel(obj, fid, n);
+    else
+        write_mfiles(obj, fid, n);
+    end
 
-    body_cell = cell(n, 1);
+    fprintf(fid, '%s\n', package_footer, footer);
 
-    for k = 1:n
-        mfile = mfiles{k};
+    msg = sprintf('written to %s', output_fn);
+    notify(monitor, msg);
 
-        body_cell{k} = get_coverage_xml(mfile, root_dir);
+function write_mfiles(obj, fid, n)
+    % messages are only built if they are printed
+    do_notify = is_notifying(obj.monitor);
 
-        msg = sprintf('Written for %s', get_filename(mfile));
-        notify(monitor, '.', msg);
+    for k = 1:n
+        mfile = get_mfile(obj, k);
+        fprintf(fid, '%s\n', get_coverage_xml(mfile, obj.root_dir));
+
+        if do_notify
+            msg = sprintf('Written for %s', get_filename(mfile));
+            notify(obj.monitor, '.', msg);
+        end
     end
 
-    package_footer = '</classes></package></packages>';
-    footer = '</coverage>';
+function write_mfiles_in_parallel(obj, fid, n)
+    % each job writes the XML of its m-files to a separate file, which are
+    % then appended to the report in order
+    temp_dir = tempname();
+    mkdir(temp_dir);
+    cleaner = onCleanup(@()mocov_util_rmdir_recursively(temp_dir));
 
-    % combine all parts
-    full_report = sprintf('%s\n', header, sources, package_header, ...
-                          body_cell{:}, ...
-                          package_footer, footer);
+    part_fns = run_jobs(obj, 'write_coverage_xml_parts', (1:n)', temp_dir);
 
-    write_to_file(output_fn, full_report);
-    msg = sprintf('written to %s', output_fn);
-    notify(monitor, msg);
+    % consecutive m-files are written to the same file
+    is_first = [true; ~strcmp(part_fns(2:end), part_fns(1:(end - 1)))];
+    part_fns = part_fns(is_first);
 
-function write_to_file(fn, s)
-    fid = fopen(fn, 'w');
-    cleaner = onCleanup(@()fclose(fid));
-    fprintf(fid, '%s', s);
+    for k = 1:numel(part_fns)
+        append_file(fid, part_fns{k});
+    end
+
+function append_file(fid, fn)
+    % copy in blocks, so that memory use does not depend on the file size
+    block_size = 2^20;
+
+    src_fid = fopen(fn, 'r');
+    cleaner = onCleanup(@()fclose(src_fid));
+
+    while true
+        data = fread(src_fid, block_size, '*uint8');
+        if isempty(data)
+            break
+        end
+        fwrite(fid, data, 'uint8');
+    end
 
 function [coverage, lines_covered, lines_valid] = compute_coverage(obj)
     % compute overall coverage across all files
@@ -12,6 +12,10 @@ function obj = MOcovProgressMonitor(verbosity)
     %   when called as notify(obj, s1, s2, ..., sN) prints the string sK to
     %   standard output, where K is the verbosity level (if the verbosity level
     %   is higher than N, K=N)
+    % - the methods start_phase, stop_phase and add_count record the time
+    %   spent on each phase of a coverage run and counts of files, lines
+    %   and bytes; these are returned by mocov_metrics. Phases are timed as
+    %   a whole, so that recording costs nothing per file.
 
     if nargin < 1
         verbosity = 1;
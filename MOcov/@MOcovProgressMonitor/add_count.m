@@ -0,0 +1,13 @@
+function add_count(obj, counter, value)
+    % increase a counter of a coverage run
+    %
+    % add_count(obj, counter, value)
+    %
+    % Inputs:
+    %   obj                 MOcovProgressMonitor instance
+    %   counter             name of the counter, such as 'files'
+    %   value               amount to add to the counter
+    %
+    % See also: mocov_metrics
+
+    mocov_metrics('add', counter, value);
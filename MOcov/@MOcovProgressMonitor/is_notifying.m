@@ -0,0 +1,17 @@
+function tf = is_notifying(obj)
+    % return whether notify prints anything
+    %
+    % tf=is_notifying(obj)
+    %
+    % Input:
+    %   obj                 MOcovProgressMonitor instance
+    %
+    % Output:
+    %   tf                  true if the verbosity is positive, false
+    %                       otherwise
+    %
+    % Notes:
+    %   - callers that notify for every file can use this to avoid
+    %     building messages that are not printed.
+
+    tf = obj.verbosity > 0;
@@ -1,3 +1,8 @@
 function notify(obj, varargin)
+    if obj.verbosity <= 0
+        % nothing is printed, so the strings do not have to be considered
+        return
+    end
+
     s = get_notify_str(obj, varargin{:});
     fprintf('%s', s);
@@ -0,0 +1,12 @@
+function start_phase(obj, phase)
+    % start timing a phase of a coverage run
+    %
+    % start_phase(obj, phase)
+    %
+    % Inputs:
+    %   obj                 MOcovProgressMonitor instance
+    %   phase               name of the phase, such as 'parse'
+    %
+    % See also: stop_phase, mocov_metrics
+
+    mocov_metrics('start', phase);
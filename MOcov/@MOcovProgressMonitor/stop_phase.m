@@ -0,0 +1,16 @@
+function stop_phase(obj, phase)
+    % stop timing a phase of a coverage run
+    %
+    % stop_phase(obj, phase)
+    %
+    % Inputs:
+    %   obj                 MOcovProgressMonitor instance
+    %   phase               name of the phase, as used with start_phase
+    %
+    % Notes:
+    %   - the time since start_phase was called is added to the time of
+    %     the phase, which is returned by mocov_metrics.
+    %
+    % See also: start_phase, mocov_metrics
+
+    mocov_metrics('stop', phase);
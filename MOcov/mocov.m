@@ -22,12 +22,21 @@ function varargout = mocov(varargin)
     %                               which match this pattern, even if they are
     %                               in covd. Can be used multiple times to
     %                               specify multiple patterns to match.
+    %                               Patterns that contain a '/' are matched
+    %                               against the path relative to covd (for
+    %                               example 'external/*' or '*/private'),
+    %                               other patterns against the name of a
+    %                               file or directory. Excluded directories
+    %                               are not searched.
     %   '-cover_json_file', cj      (optional) Store coverage information in
     % `                             file cj in JSON format [use with coveralls]
     %   '-cover_xml_file', xc       (optional) Store coverage information in
     % `                             file xc [for shippable.com]
     %   '-cover_html_dir', h        (optional) Store coverage information in
-    % `                             directory h
+    % `                             directory h. If h has a report from
+    %                               an earlier run, only pages of files
+    %                               whose contents or coverage changed are
+    %                               written again.
     %   '-verbose'                  (optional) Show verbose output
     %   '-cover_method', m          (optional) Use method m to determine
     %                               coverage, one of:
@@ -40,7 +49,133 @@ function varargout = mocov(varargin)
     %                               'profile' use profiler to determine
     %                                         coverage. Does not work on Octave
     %                                         4.0 (and possibly later versions)
+    %                               'timing'  as 'file', but also record the
+    %                                         time spent on each line, for
+    %                                         use with '-timing_csv_file' and
+    %                                         '-timing_html_file'. Requires
+    %                                         '-cover_probe call'.
     %                               Default: 'file'
+    %   '-cover_granularity', g     (optional) When using the 'file' method,
+    %                               record coverage with granularity g, one
+    %                               of:
+    %                               'line'    record every executable line
+    %                               'block'   only record the first line of
+    %                                         each block of consecutive
+    %                                         executable lines without
+    %                                         control flow statements, and
+    %                                         consider the other lines in the
+    %                                         block executed as often. This
+    %                                         runs faster, but lines after a
+    %                                         line that raised an error are
+    %                                         also considered executed.
+    %                               Default: 'line'
+    %   '-cover_probe', p           (optional) When using the 'file' method,
+    %                               record covered lines with probe p, one
+    %                               of:
+    %                               'call'    call mocov_line_covered for
+    %                                         every executed line
+    %                               'buffer'  in functions, increase a line
+    %                                         count in a global variable for
+    %                                         each executed line, and add
+    %                                         these counts after evaluating
+    %                                         expr. This runs faster, but
+    %                                         counts are lost if expr clears
+    %                                         global variables (for example
+    %                                         with 'clear all', 'clear
+    %                                         global' or 'clearvars
+    %                                         -global'), in which case a
+    %                                         warning is shown; rewritten
+    %                                         functions that run afterwards
+    %                                         raise an error.
+    %                               Default: 'call'
+    %   '-cover_mode', md           (optional) When using the 'file' method,
+    %                               record coverage in mode md, one of:
+    %                               'count'   count how often each line is
+    %                                         executed
+    %                               'hit'     only record whether each line
+    %                                         is executed (reports show a
+    %                                         count of one for executed
+    %                                         lines). This allows for
+    %                                         calling mocov_deinstrument
+    %                                         in expr (for example, after
+    %                                         each test file), which
+    %                                         replaces fully covered files
+    %                                         by their originals, so that
+    %                                         they run at full speed
+    %                                         afterwards. Cannot be used
+    %                                         with '-cover_contexts_file'
+    %                                         or the 'timing' method.
+    %                               Default: 'count'
+    %   '-cover_cache_dir', d       (optional) When using the 'file' method,
+    %                               store parsed and rewritten files in
+    %                               directory d, and reuse them in later
+    %                               runs for files with the same contents
+    %                               (based on their md5 checksum). Files in
+    %                               d are never removed by MOcov.
+    %   '-jobs', n                  (optional) Parse, rewrite and report
+    %                               files using n jobs in parallel: separate
+    %                               processes on GNU Octave (on unix-like
+    %                               platforms), or parfor on Matlab.
+    %                               Default: 1
+    %   '-cover_snapshot_file', sf  (optional) Store the coverage counts in
+    %                               binary snapshot file sf, which can be
+    %                               merged with those of other runs using
+    %                               '-merge_snapshot'.
+    %   '-merge_snapshot', ms       (optional) Add the coverage counts in
+    %                               snapshot file ms, written by another run
+    %                               with '-cover_snapshot_file' for the same
+    %                               covd. Can be used multiple times, and ms
+    %                               can also be a cellstr with several
+    %                               files. If neither '-expression' nor
+    %                               '-profile_info' is used, files in covd
+    %                               are only parsed, and the reports contain
+    %                               the merged coverage of the snapshots.
+    %                               The content hash of each file must match
+    %                               that in the snapshots, and the same
+    %                               '-cover_granularity' must be used as in
+    %                               the runs that stored them (which is
+    %                               stored in the snapshots, and checked).
+    %                               Not supported with the 'profile'
+    %                               method.
+    %   '-cover_contexts_file', cf  (optional) When using the 'file' method,
+    %                               store in file cf which lines were hit
+    %                               in each context set with
+    %                               mocov_set_context while evaluating
+    %                               expr (for example, one context for
+    %                               each test). The file can be used with
+    %                               mocov_contexts_select to find the tests
+    %                               that hit changed lines.
+    %   '-cover_shared_file', sf    (optional) When using the 'file' method
+    %                               with the 'call' probe, store the line
+    %                               counts in file sf (which is created
+    %                               anew), shared with all processes on
+    %                               this machine that are started while
+    %                               evaluating expr, such as workers of the
+    %                               Octave 'parallel' package. Their
+    %                               coverage is then included without a
+    %                               merge step. Processes started with a
+    %                               fresh path must add the rewritten
+    %                               files to their path. Requires the
+    %                               compiled mex file of
+    %                               mocov_line_covered.
+    %   '-timing_csv_file', tc      (optional) When using the 'timing'
+    %                               method, store the time spent on each
+    %                               line in file tc in CSV format, sorted
+    %                               by decreasing self time (the time
+    %                               minus the measured time of recording
+    %                               the line).
+    %   '-timing_html_file', th     (optional) When using the 'timing'
+    %                               method, store tables of the functions
+    %                               and lines with the most self time in
+    %                               file th in HTML format.
+    %   '-metrics_json_file', mj    (optional) Store the wall time of each
+    %                               phase of the run (such as 'find',
+    %                               'parse', 'rewrite', 'run', 'collect'
+    %                               and 'write_cover_xml_file'), and counts
+    %                               of files, lines, probe hits and bytes
+    %                               written, in file mj in JSON format.
+    %                               These metrics are also returned by
+    %                               mocov_metrics after the run.
     %
     % Examples:
     %   % evaluate 'expr' while monitoring coverage of files in directory
@@ -53,6 +188,26 @@ function varargout = mocov(varargin)
     %   % (not usable on GNU Octave)
     %   mocov -cover cover_dir -cover_html_dir output -e expr -v -m profile
     %
+    %   % Run test shards in separate processes, each storing a snapshot,
+    %   % and merge the snapshots into a single report afterwards
+    %   mocov -cover covd -cover_snapshot_file shard1.mocov -e expr1
+    %   mocov -cover covd -cover_snapshot_file shard2.mocov -e expr2
+    %   mocov -cover covd -cover_xml_file coverage.xml ...
+    %         -merge_snapshot shard1.mocov -merge_snapshot shard2.mocov
+    %
+    %   % Record which lines each test hits (the expression calls
+    %   % mocov_set_context before each test), and select the tests that
+    %   % hit lines 10 to 20 of foo.m
+    %   mocov -cover covd -cover_contexts_file contexts.mat -e expr
+    %   names = mocov_contexts_select('contexts.mat', {'foo.m', [10 20]})
+    %
+    %   % Only record which lines are hit; the expression calls
+    %   % mocov_deinstrument after each test file, so that files that are
+    %   % fully covered no longer record coverage
+    %   mocov -cover covd -cover_mode hit -cover_xml_file cov.xml -e expr
+    %
+    %   % Find the slowest lines and functions while measuring coverage
+    %   mocov -cover covd -m timing -timing_html_file timing.html -e expr
     %
     %
     % Notes:
@@ -61,7 +216,11 @@ function varargout = mocov(varargin)
     % - when using the 'file' method, all .m files in the covd directory are
     %   parsed, changed to call mocov_line_covered on every executable line,
     %   and written to a temporary directory. The search path is updated
-    %   temporarily to include the temporary directory/
+    %   temporarily to include, for each directory under covd in the
+    %   search path, the corresponding directory in the temporary
+    %   directory. If no directory under covd is in the search path, all
+    %   directories with .m files (except private, @class and +package
+    %   directories) are included.
     % - coverage may not be supported for new-style object-oriented class
     %   files.
     %
@@ -83,42 +242,110 @@ function varargout = mocov(varargin)
     % reset lines covered to empty
     mocov_line_covered([]);
 
+    % metrics are kept after the run, so that they can be queried
+    mocov_metrics('reset');
+
     monitor = MOcovProgressMonitor(opt.verbose);
     mfile_collection = MOcovMFileCollection(opt.cover, ...
                                             opt.method, ...
                                             monitor, ...
-                                            opt.excludes);
-    mfile_collection = prepare(mfile_collection);
-    cleaner_collection = onCleanup(@()cleanup(mfile_collection));
+                                            opt.excludes, ...
+                                            get_collection_options(opt));
+    % when only merging snapshots, files are not rewritten
+    is_merge_only = isempty(opt.expression) && ~opt.info_from_profile;
+    if ~is_merge_only
+        mfile_collection = prepare(mfile_collection);
+        cleaner_collection = onCleanup(@()cleanup(mfile_collection));
+    end
+
+    if ~isempty(opt.shared_file)
+        % processes started from now on record into the same counts
+        cleaner_shared = share_line_counts(opt.shared_file);
+    end
 
     if ~isempty(opt.expression)
         % rewrite m-files (if method='file') and ensure that they are cleaned
         % up afterwards
 
         % evaluate expression, and assign output variables
+        start_phase(monitor, 'run');
         argout = evaluate_expression(opt.expression);
+        stop_phase(monitor, 'run');
         n = numel(argout);
         varargout = cell(1, n);
         [varargout{:}] = argout{:};
     end
 
+    if ~isempty(opt.shared_file)
+        % keep the counts of all processes up to now
+        mocov_line_covered('unshare');
+        clear cleaner_shared;
+    end
+
+    if ~isempty(opt.merge_snapshots)
+        % add coverage of other runs, one snapshot at a time
+        start_phase(monitor, 'merge');
+        mfile_collection = merge_snapshots(mfile_collection, ...
+                                           opt.merge_snapshots);
+        stop_phase(monitor, 'merge');
+    end
+
     % see which lines were executed
+    start_phase(monitor, 'collect');
     mfile_collection = add_lines_executed_count(mfile_collection);
+    stop_phase(monitor, 'collect');
+
+    if ~isempty(opt.snapshot_file)
+        start_phase(monitor, 'write_snapshot_file');
+        snapshot_fn = mocov_get_absolute_path(opt.snapshot_file);
+        mocov_snapshot_save(snapshot_fn);
+        stop_phase(monitor, 'write_snapshot_file');
+        add_bytes_written(monitor, 'snapshot_file', snapshot_fn);
+    end
+
+    if ~isempty(opt.contexts_file)
+        start_phase(monitor, 'write_contexts_file');
+        contexts_fn = mocov_get_absolute_path(opt.contexts_file);
+        mocov_contexts_save(contexts_fn, get_contexts(mfile_collection));
+        stop_phase(monitor, 'write_contexts_file');
+        add_bytes_written(monitor, 'contexts_file', contexts_fn);
+    end
 
     % reset pwd
     clear cleaner_pwd;
 
     % write coverage
     coverage_writers = get_coverage_writers_collection();
-    write_coverage_results(coverage_writers, mfile_collection, opt);
+    write_coverage_results(coverage_writers, mfile_collection, opt, ...
+                           monitor);
+
+    if ~isempty(opt.metrics_json_file)
+        write_metrics_json_file(mocov_get_absolute_path( ...
+                                                opt.metrics_json_file));
+    end
+
+function options = get_collection_options(opt)
+    options = struct();
+    options.granularity = opt.granularity;
+    options.probe = opt.probe;
+    options.cache_dir = opt.cache_dir;
+    options.jobs = opt.jobs;
+    options.timing = opt.timing;
+    options.mode = opt.mode;
+
+    % content hashes are stored in snapshots and checked when merging
+    options.hash_content = ~isempty(opt.snapshot_file) || ...
+                           ~isempty(opt.merge_snapshots);
 
 function coverage_writers = get_coverage_writers_collection()
     coverage_writers = struct();
     coverage_writers.cover_html_dir = @write_html_dir;
     coverage_writers.cover_xml_file = @write_xml_file;
     coverage_writers.cover_json_file = @write_json_file;
+    coverage_writers.timing_csv_file = @write_timing_csv_file;
+    coverage_writers.timing_html_file = @write_timing_html_file;
 
-function write_coverage_results(writers, mfile_collection, opt)
+function write_coverage_results(writers, mfile_collection, opt, monitor)
     keys = intersect(fieldnames(writers), fieldnames(opt));
 
     for k = 1:numel(keys)
@@ -130,9 +357,61 @@ function write_coverage_results(writers, mfile_collection, opt)
         abs_file_arg = mocov_get_absolute_path(file_arg);
 
         writer = writers.(key);
+        start_phase(monitor, ['write_' key]);
         writer(mfile_collection, abs_file_arg);
+        stop_phase(monitor, ['write_' key]);
+        add_bytes_written(monitor, key, abs_file_arg);
     end
 
+function cleaner = share_line_counts(shared_file)
+    shared_fn = mocov_get_absolute_path(shared_file);
+    if exist(shared_fn, 'file')
+        delete(shared_fn);
+    end
+    mocov_line_covered('share', shared_fn);
+
+    % processes started later attach to the shared counts when they
+    % first record a line (see mocov_line_covered.c)
+    env_name = 'MOCOV_SHARED_COUNTERS_FILE';
+    orig_env_value = getenv(env_name);
+    setenv(env_name, shared_fn);
+    cleaner = onCleanup(@()setenv(env_name, orig_env_value));
+
+function add_bytes_written(monitor, key, fn)
+    % count the bytes of an output file, or of the files in an output
+    % directory (such as for the HTML report)
+    d = dir(fn);
+    n_bytes = sum([d(~[d.isdir]).bytes]);
+    add_count(monitor, ['bytes_' key], n_bytes);
+
+function write_metrics_json_file(fn)
+    metrics = mocov_metrics();
+
+    fid = fopen(fn, 'w');
+    if fid == -1
+        error('Unable to open %s for writing', fn);
+    end
+    cleaner = onCleanup(@()fclose(fid));
+
+    fprintf(fid, '{\n');
+    write_metrics_json_fields(fid, 'phases', metrics.phases, '%.6f');
+    fprintf(fid, ',\n');
+    write_metrics_json_fields(fid, 'counters', metrics.counters, '%d');
+    fprintf(fid, '\n}\n');
+
+function write_metrics_json_fields(fid, name, values, value_pat)
+    keys = fieldnames(values);
+    n = numel(keys);
+
+    fprintf(fid, '  "%s": {', name);
+    for k = 1:n
+        if k > 1
+            fprintf(fid, ',');
+        end
+        fprintf(fid, ['\n    "%s": ' value_pat], keys{k}, values.(keys{k}));
+    end
+    fprintf(fid, '\n  }');
+
 function argout = evaluate_expression(the_expression___)
     if isa(the_expression___, 'function_handle')
         the_expression_nout___ = nargout(the_expression___);
@@ -160,6 +439,17 @@ function opt = parse_inputs(varargin)
     defaults.coveralls_json = [];
     defaults.verbose = 0;
     defaults.method = [];
+    defaults.granularity = 'line';
+    defaults.probe = 'call';
+    defaults.mode = 'count';
+    defaults.cache_dir = [];
+    defaults.jobs = 1;
+    defaults.snapshot_file = [];
+    defaults.merge_snapshots = {};
+    defaults.contexts_file = [];
+    defaults.timing = false;
+    defaults.metrics_json_file = [];
+    defaults.shared_file = [];
     defaults.expression = [];
     defaults.info_from_profile = false;
 
@@ -204,6 +494,63 @@ function opt = parse_inputs(varargin)
                     k = k + 1;
                     opt.method = varargin{k};
 
+                case '-cover_granularity'
+                    k = k + 1;
+                    opt.granularity = varargin{k};
+
+                case '-cover_probe'
+                    k = k + 1;
+                    opt.probe = varargin{k};
+
+                case '-cover_mode'
+                    k = k + 1;
+                    opt.mode = varargin{k};
+
+                case '-cover_cache_dir'
+                    k = k + 1;
+                    opt.cache_dir = varargin{k};
+
+                case '-jobs'
+                    k = k + 1;
+                    opt.jobs = varargin{k};
+                    if ischar(opt.jobs)
+                        % allow for 'mocov -jobs 4 ...' syntax
+                        opt.jobs = str2double(opt.jobs);
+                    end
+
+                case '-cover_snapshot_file'
+                    k = k + 1;
+                    opt.snapshot_file = varargin{k};
+
+                case '-merge_snapshot'
+                    k = k + 1;
+                    snapshot_fns = varargin{k};
+                    if ischar(snapshot_fns)
+                        snapshot_fns = {snapshot_fns};
+                    end
+                    opt.merge_snapshots = [opt.merge_snapshots; ...
+                                           snapshot_fns(:)];
+
+                case '-cover_contexts_file'
+                    k = k + 1;
+                    opt.contexts_file = varargin{k};
+
+                case '-timing_csv_file'
+                    k = k + 1;
+                    opt.timing_csv_file = varargin{k};
+
+                case '-timing_html_file'
+                    k = k + 1;
+                    opt.timing_html_file = varargin{k};
+
+                case '-cover_shared_file'
+                    k = k + 1;
+                    opt.shared_file = varargin{k};
+
+                case '-metrics_json_file'
+                    k = k + 1;
+                    opt.metrics_json_file = varargin{k};
+
                 case '-profile_info'
                     opt.info_from_profile = true;
 
@@ -223,6 +570,10 @@ function opt = parse_inputs(varargin)
         else
             opt.method = 'file';
         end
+    elseif strcmp(opt.method, 'timing')
+        % rewritten files record the time of each line as well
+        opt.method = 'file';
+        opt.timing = true;
     end
 
     check_inputs(opt);
@@ -232,13 +583,72 @@ function check_inputs(opt)
         error('input dir ''%s'' does not exist', opt.coverage_dir);
     end
 
+    if ~any(strcmp(opt.granularity, {'line', 'block'}))
+        error('illegal granularity ''%s''', opt.granularity);
+    end
+
+    if ~any(strcmp(opt.probe, {'call', 'buffer'}))
+        error('illegal probe ''%s''', opt.probe);
+    end
+
+    if ~any(strcmp(opt.mode, {'count', 'hit'}))
+        error('illegal mode ''%s''', opt.mode);
+    end
+
+    if strcmp(opt.mode, 'hit')
+        if ~strcmp(opt.method, 'file')
+            error('Option ''-cover_mode hit'' requires ''-m file''');
+        end
+
+        % lines of replaced files are no longer attributed or timed
+        if opt.timing || ~isempty(opt.contexts_file)
+            error(['Option ''-cover_mode hit'' cannot be used with '...
+                   '''-m timing'' or ''-cover_contexts_file''']);
+        end
+    end
+
+    if ~isnumeric(opt.jobs) || ~isscalar(opt.jobs) || ...
+            opt.jobs < 1 || round(opt.jobs) ~= opt.jobs
+        error('number of jobs must be a positive integer');
+    end
+
+    if ~iscellstr(opt.merge_snapshots)
+        error('snapshots to merge must be strings');
+    end
+
+    if ~isempty(opt.merge_snapshots) && strcmp(opt.method, 'profile')
+        error('Option ''-merge_snapshot'' requires ''-m file''');
+    end
+
+    if ~isempty(opt.contexts_file) && ~strcmp(opt.method, 'file')
+        error('Option ''-cover_contexts_file'' requires ''-m file''');
+    end
+
+    if ~isempty(opt.shared_file) && ...
+            ~(strcmp(opt.method, 'file') && strcmp(opt.probe, 'call') && ...
+              ~isempty(opt.expression))
+        error(['Option ''-cover_shared_file'' requires ''-e'', '...
+               '''-m file'' and ''-cover_probe call''']);
+    end
+
+    if opt.timing && ~strcmp(opt.probe, 'call')
+        error('Method ''timing'' requires ''-cover_probe call''');
+    end
+
+    timing_keys = {'timing_csv_file', 'timing_html_file'};
+    if ~opt.timing && any(isfield(opt, timing_keys))
+        error(['Options ''-timing_csv_file'' and '...
+               '''-timing_html_file'' require ''-m timing''']);
+    end
+
     if isempty(opt.expression)
         if opt.info_from_profile
             if ~strcmp(opt.method, 'profile')
                 error('Option ''-i'' requires ''-m profile''');
             end
-        else
-            error('Either option ''-e'' or ''i'' must be used');
+        elseif isempty(opt.merge_snapshots)
+            error(['Either option ''-e'', ''-i'' or '...
+                   '''-merge_snapshot'' must be used']);
         end
     elseif opt.info_from_profile
         error('Options ''-e'' or ''i'' are mutually exclusive');
@@ -0,0 +1,25 @@
+function contexts = mocov_contexts_load(fn)
+    % read which lines were hit by each context from a file
+    %
+    % contexts=mocov_contexts_load(fn)
+    %
+    % Input:
+    %   fn                  name of a file written by mocov_contexts_save
+    %
+    % Output:
+    %   contexts            struct with fields:
+    %     .names            Cx1 cell with the name of each context
+    %     .keys             Nx1 cell with filenames
+    %     .ranges           Mx4 array, where each row
+    %                       [context, file, first_line, last_line]
+    %                       indicates that lines first_line to last_line
+    %                       of file keys{file} were hit by context
+    %                       names{context}
+    %
+    % See also: mocov_contexts_save, mocov_contexts_select
+
+    data = load(fn, '-mat');
+    if ~isfield(data, 'contexts')
+        error('File %s does not contain contexts', fn);
+    end
+    contexts = data.contexts;
@@ -0,0 +1,37 @@
+function mocov_contexts_save(fn, contexts)
+    % store which lines were hit by each context in a file
+    %
+    % mocov_contexts_save(fn[, contexts])
+    %
+    % Inputs:
+    %   fn                  name of the file to write
+    %   contexts            optional struct with fields .names, .keys and
+    %                       .ranges, as returned by
+    %                       mocov_line_covered('get_contexts') or by the
+    %                       get_contexts method of MOcovMFileCollection.
+    %                       Default: the contexts in the current state of
+    %                       mocov_line_covered
+    %
+    % Notes:
+    %   - the file is written in MAT format, and can be read with
+    %     mocov_contexts_load on both Matlab and GNU Octave.
+    %   - each context only stores runs of consecutive lines it hit, so
+    %     the file remains small even for thousands of tests.
+    %
+    % See also: mocov_contexts_load, mocov_contexts_select,
+    %           mocov_set_context
+
+    if nargin < 2
+        contexts = mocov_line_covered('get_contexts');
+    end
+
+    check_contexts(contexts);
+    save(fn, 'contexts', '-mat');
+
+function check_contexts(contexts)
+    if ~isstruct(contexts) || ...
+            ~all(isfield(contexts, {'names', 'keys', 'ranges'})) || ...
+            size(contexts.ranges, 2) ~= 4
+        error(['contexts must be a struct with fields .names, .keys '...
+               'and .ranges']);
+    end
@@ -0,0 +1,79 @@
+function names = mocov_contexts_select(contexts, changes)
+    % select the contexts (such as tests) that hit changed lines
+    %
+    % names=mocov_contexts_select(contexts, changes)
+    %
+    % Inputs:
+    %   contexts            struct with fields .names, .keys and .ranges,
+    %                       as returned by mocov_contexts_load, or the name
+    %                       of a file written by mocov_contexts_save
+    %   changes             Nx2 cell, where changes{k,1} is the name of a
+    %                       changed file (as in contexts.keys, i.e.
+    %                       relative to the covered directory) and
+    %                       changes{k,2} a Px2 array with ranges
+    %                       [first_line, last_line] of changed lines in
+    %                       that file, or empty if the whole file changed
+    %
+    % Output:
+    %   names               Qx1 cell with the names of the contexts that hit
+    %                       at least one changed line, in the order in
+    %                       which the contexts were first set
+    %
+    % Notes:
+    %   - only contexts that hit a changed line are selected; for a test
+    %     suite with a context for each test, these are the tests that
+    %     have to be run again after the change.
+    %   - changes in files that no context hit (such as new files) do not
+    %     select any context; such changes may require running all tests.
+    %   - line numbers refer to the files as they were when the contexts
+    %     were recorded.
+    %
+    % Example:
+    %   % tests that hit lines 10 to 12 of sub/foo.m, or any line of bar.m
+    %   names = mocov_contexts_select('contexts.mat', ...
+    %                                 {'sub/foo.m', [10 12]; 'bar.m', []})
+    %
+    % See also: mocov_contexts_save, mocov_contexts_load, mocov_set_context
+
+    if ischar(contexts)
+        contexts = mocov_contexts_load(contexts);
+    end
+
+    if ~iscell(changes) || size(changes, 2) ~= 2
+        error('changes must be a cell with two columns');
+    end
+
+    ranges = contexts.ranges;
+    is_selected = false(numel(contexts.names), 1);
+
+    for k = 1:size(changes, 1)
+        file_idx = find(strcmp(contexts.keys, changes{k, 1}));
+        if isempty(file_idx)
+            continue
+        end
+
+        in_file = ismember(ranges(:, 2), file_idx);
+        changed_lines = changes{k, 2};
+        if isempty(changed_lines)
+            hits_change = in_file;
+        else
+            if size(changed_lines, 2) ~= 2
+                error('Changed lines for %s must be a Px2 array', ...
+                      changes{k, 1});
+            end
+
+            hits_change = false(size(in_file));
+            for j = 1:size(changed_lines, 1)
+                % runs and changed ranges overlap
+                hits_change = hits_change | ...
+                              (in_file & ...
+                               ranges(:, 3) <= changed_lines(j, 2) & ...
+                               ranges(:, 4) >= changed_lines(j, 1));
+            end
+        end
+
+        is_selected(ranges(hits_change, 1)) = true;
+    end
+
+    names = contexts.names(is_selected);
+    names = names(:);
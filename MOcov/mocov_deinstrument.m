@@ -0,0 +1,160 @@
+function rel_fns = mocov_deinstrument(command, varargin)
+    % replace rewritten m-files that are fully covered by their originals
+    %
+    % Usages:
+    %   1) rel_fns=mocov_deinstrument()
+    %
+    %      For each rewritten m-file of which all recorded lines have been
+    %      hit (according to mocov_line_covered), writes the original
+    %      m-file over the rewritten one, so that it no longer records
+    %      coverage and runs at the speed of the original. Returns a cell
+    %      with the relative filenames of the m-files replaced by this
+    %      call.
+    %
+    %   2) mocov_deinstrument('init', temp_dir, rel_fns, orig_fns, ...
+    %                         recorded_lines, can_replace)
+    %
+    %      Sets the m-files that can be replaced: for the k-th file, which
+    %      is registered at position k with mocov_line_covered, rel_fns{k}
+    %      is its filename relative to temp_dir (where the rewritten file
+    %      is stored), orig_fns{k} the filename of the original,
+    %      recorded_lines{k} a vector with the lines that record coverage,
+    %      and can_replace(k) false if the file must never be replaced.
+    %
+    %   3) mocov_deinstrument('clear')
+    %
+    %      Removes all m-files set with 'init'.
+    %
+    % Notes:
+    %   - this function is meant for coverage runs with mocov with
+    %     '-cover_mode hit', where only whether a line was hit is recorded.
+    %     In long test suites most m-files are fully covered early on;
+    %     calling this function between test files means that later tests
+    %     spend less and less time recording coverage. Counts of lines of
+    %     replaced m-files no longer increase.
+    %   - replaced m-files are cleared from memory, so that the original
+    %     is used when they are called next. M-files that declare
+    %     persistent variables or call mlock are never replaced, as
+    %     clearing them would change their behaviour.
+    %   - counts in the line buffers of the 'buffer' probe are added
+    %     before it is determined which m-files are fully covered.
+    %   - the number of replaced m-files is added to the
+    %     'deinstrumented_files' counter of mocov_metrics.
+    %
+    % Example:
+    %   % in the expression evaluated by mocov, run each test file and
+    %   % stop recording coverage for fully covered m-files in between
+    %   for k = 1:numel(test_files)
+    %       moxunit_runtests(test_files{k});
+    %       mocov_deinstrument();
+    %   end
+    %
+    % See also: mocov, mocov_line_covered
+
+    persistent files
+
+    if isempty(files)
+        files = init_files();
+    end
+
+    if nargin == 0
+        mocov_line_buffer('flush');
+        [files, rel_fns] = replace_covered_files(files);
+        return
+    end
+
+    switch command
+        case 'init'
+            if nargin ~= 6
+                error(['Usage: mocov_deinstrument(''init'', temp_dir, '...
+                       'rel_fns, orig_fns, recorded_lines, can_replace)']);
+            end
+            files = init_files(varargin{:});
+
+        case 'clear'
+            files = init_files();
+
+        otherwise
+            error('illegal command ''%s''', command);
+    end
+
+    rel_fns = [];
+
+function files = init_files(temp_dir, rel_fns, orig_fns, recorded_lines, ...
+                            can_replace)
+    files = struct();
+    if nargin == 0
+        files.temp_dir = '';
+        files.rel_fns = cell(0, 1);
+        files.orig_fns = cell(0, 1);
+        files.recorded_lines = cell(0, 1);
+        files.is_pending = false(0, 1);
+        return
+    end
+
+    n = numel(rel_fns);
+    if numel(orig_fns) ~= n || numel(recorded_lines) ~= n || ...
+            numel(can_replace) ~= n
+        error('all inputs must have one element for each m-file');
+    end
+
+    files.temp_dir = temp_dir;
+    files.rel_fns = rel_fns(:);
+    files.orig_fns = orig_fns(:);
+    files.recorded_lines = recorded_lines(:);
+    files.is_pending = logical(can_replace(:));
+
+function [files, replaced_fns] = replace_covered_files(files)
+    s = mocov_line_covered();
+    line_count = s.line_count;
+
+    n = min(numel(files.rel_fns), numel(line_count));
+    is_replaced = false(n, 1);
+    for k = find(files.is_pending(1:n))'
+        counts = line_count{k};
+        lines = files.recorded_lines{k};
+        is_covered = isempty(lines) || ...
+                        (max(lines) <= numel(counts) && all(counts(lines)));
+        if ~is_covered
+            continue
+        end
+
+        tmp_fn = fullfile(files.temp_dir, files.rel_fns{k});
+        copy_contents(files.orig_fns{k}, tmp_fn);
+
+        % the rewritten version may already have been loaded
+        [unused, name] = fileparts(tmp_fn);
+        clear_function(name);
+        is_replaced(k) = true;
+    end
+
+    files.is_pending(is_replaced) = false;
+    replaced_fns = files.rel_fns(is_replaced);
+
+    if ~isempty(replaced_fns)
+        % private functions and class methods are not cleared by name
+        rehash();
+    end
+    mocov_metrics('add', 'deinstrumented_files', numel(replaced_fns));
+
+function clear_function(name___)
+    % a separate function, so that no variables with the same name as the
+    % m-file are cleared instead
+    clear(name___);
+
+function copy_contents(src_fn, trg_fn)
+    % the contents are written (rather than the file copied), so that the
+    % modification time changes and the file is seen as changed
+    fid = fopen(src_fn);
+    if fid == -1
+        error('Unable to open %s for reading', src_fn);
+    end
+    bytes = fread(fid, inf, 'uint8=>uint8');
+    fclose(fid);
+
+    fid = fopen(trg_fn, 'w');
+    if fid == -1
+        error('Unable to open %s for writing', trg_fn);
+    end
+    cleaner = onCleanup(@()fclose(fid));
+    fwrite(fid, bytes, 'uint8');
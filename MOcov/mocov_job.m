@@ -0,0 +1,51 @@
+function mocov_job(job_fn)
+    % run a single job in a separate process
+    %
+    % mocov_job(job_fn)
+    %
+    % Input:
+    %   job_fn              file with a variable job, a struct with fields
+    %                       .func       name of the function to run
+    %                       .args       cell with arguments for this job
+    %                       .n_outputs  number of outputs of .func
+    %                       .shared_fn  file with a variable shared_args,
+    %                                   a cell with arguments used by all
+    %                                   jobs, which come before .args
+    %                       .output_fn  file to which the result is
+    %                                   written. If the job succeeded, it
+    %                                   contains a variable output, a cell
+    %                                   with the outputs of .func, and a
+    %                                   variable metrics with the metrics
+    %                                   recorded by the job (see
+    %                                   mocov_metrics); otherwise it
+    %                                   contains a variable error_message.
+    %
+    % Notes:
+    %   - this function is used by mocov_run_jobs, and is not intended to
+    %     be used directly.
+    %   - all filenames except job_fn are read from the job file, so that
+    %     they do not have to be quoted on the command line of the process.
+    %
+    % See also: mocov_run_jobs, mocov_metrics
+
+    loaded = load(job_fn);
+    job = loaded.job;
+
+    try
+        shared = load(job.shared_fn);
+
+        mocov_metrics('reset');
+        args = [shared.shared_args, job.args];
+        output = cell(1, job.n_outputs);
+        if job.n_outputs == 0
+            feval(job.func, args{:});
+        else
+            [output{:}] = feval(job.func, args{:});
+        end
+        metrics = mocov_metrics();
+
+        save(job.output_fn, '-binary', 'output', 'metrics');
+    catch
+        error_message = lasterr();
+        save(job.output_fn, '-binary', 'error_message');
+    end
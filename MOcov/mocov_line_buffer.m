@@ -0,0 +1,119 @@
+function varargout = mocov_line_buffer(command, varargin)
+    % manage line buffers used by rewritten files to count covered lines
+    %
+    % Usages:
+    %   1) name=mocov_line_buffer('name', idx)
+    %
+    %      Returns the name of the global variable that counts how often
+    %      each line was executed in the file registered at position idx
+    %      with mocov_line_covered. If idx is a string, it is used instead
+    %      of the decimal representation of the index.
+    %
+    %   2) mocov_line_buffer('init', n_lines)
+    %
+    %      Creates a buffer for each of N files, where the k-th buffer has
+    %      space for n_lines(k) lines. Existing buffers are removed.
+    %
+    %   3) mocov_line_buffer('flush')
+    %
+    %      Adds the counts in all buffers to the state of
+    %      mocov_line_covered, using a single call for each file, and sets
+    %      all counts in the buffers to zero. A warning is shown if any
+    %      buffer no longer exists.
+    %
+    %   4) mocov_line_buffer('clear')
+    %
+    %      Removes all buffers.
+    %
+    % Notes:
+    %   - when files are rewritten with the 'buffer' probe, executable
+    %     lines inside functions increment a line count in a global
+    %     variable, instead of calling mocov_line_covered. This avoids a
+    %     function call for every executed line.
+    %   - buffers are removed by code that clears global variables, such
+    %     as 'clear all', 'clear global' or 'clearvars -global'. The counts
+    %     in these buffers are lost, and rewritten files that run
+    %     afterwards raise an error when they increment a line count.
+    %
+    % See also: mocov_line_covered
+
+    persistent n_buffers
+
+    if isempty(n_buffers)
+        n_buffers = 0;
+    end
+
+    switch command
+        case 'name'
+            varargout = {get_name(varargin{1})};
+
+        case 'init'
+            clear_buffers(n_buffers);
+            n_lines = varargin{1};
+            n_buffers = numel(n_lines);
+            for k = 1:n_buffers
+                set_buffer(k, zeros(max(n_lines(k), 1), 1));
+            end
+
+        case 'flush'
+            n_cleared = 0;
+            for k = 1:n_buffers
+                n_cleared = n_cleared + ~flush_buffer(k);
+            end
+
+            if n_cleared > 0
+                warning('mocov:line_buffer_cleared', ...
+                        ['Line buffers of %d of %d files were cleared '...
+                         'after they were created (for example by '...
+                         '''clear all'' or ''clear global''); coverage '...
+                         'recorded in these files is missing'], ...
+                        n_cleared, n_buffers);
+            end
+
+        case 'clear'
+            clear_buffers(n_buffers);
+            n_buffers = 0;
+
+        otherwise
+            error('illegal command ''%s''', command);
+    end
+
+function name = get_name(idx)
+    if ischar(idx)
+        name = ['mocov_buffer_' idx];
+    else
+        name = sprintf('mocov_buffer_%d', idx);
+    end
+
+function buffer = get_buffer(idx)
+    name = get_name(idx);
+    eval(sprintf('global %s', name));
+    buffer = eval(name);
+
+function set_buffer(idx, buffer)
+    name = get_name(idx);
+    eval(sprintf('global %s', name));
+    eval(sprintf('%s = buffer;', name));
+
+function is_present = flush_buffer(idx)
+    % a buffer that was cleared is declared again by get_buffer, and then
+    % empty, while buffers are created with at least one element
+    buffer = get_buffer(idx);
+    is_present = ~isempty(buffer);
+
+    lines = find(buffer);
+    if ~isempty(lines)
+        mocov_line_covered('add', idx, lines, buffer(lines));
+        set_buffer(idx, zeros(size(buffer)));
+    end
+
+function clear_buffers(n)
+    if mocov_util_platform_is_octave()
+        global_arg = '-global';
+    else
+        global_arg = 'global';
+    end
+
+    for k = 1:n
+        clear(global_arg, get_name(k));
+    end
@@ -12,18 +12,214 @@
 // `covered_file` structs (one for each file). There are helper functions
 // for allocating and freeing space for these structs when needed.
 //
+// Files can be registered up front using
+//     mocov_line_covered('register', keys)
+// after which lines are recorded by file index only, using
+//     mocov_line_covered(idx, line_number)
+// This avoids any string conversion or comparison when recording a line;
+// the older form mocov_line_covered(idx, filename, line_number) is still
+// supported for compatibility.
+//
+// Counts for many lines of a file can be added at once using
+//     mocov_line_covered('add', idx, line_numbers[, counts])
+// which is used to flush the line buffers of rewritten files (see
+// mocov_line_buffer.m). Instead of an index, a filename can be passed:
+//     mocov_line_covered('add', filename, line_numbers[, counts])
+// in which case the file is looked up (and added to the state if absent)
+// only once for all lines. This is used to import the line counts of the
+// profiler, one call for each file. Files are looked up by name using a
+// hash table of filenames, so that importing takes time linear in the
+// number of files.
+//
+// When registering, the number of lines of each file can be passed as well:
+//     mocov_line_covered('register', keys, n_lines)
+// In that case the line counts for all registered files are stored in a
+// single contiguous block of memory (the "arena"), with each file pointing
+// to its own offset in the arena. This requires only a single allocation,
+// and avoids growing the line counts of a file while lines are recorded.
+//
+// The state can be written to and read from a compact binary snapshot using
+//     mocov_line_covered('save', fn)
+//     mocov_line_covered('merge', fn)
+// where 'merge' adds the line counts in the snapshot to the current state,
+// matching files by name. This allows for combining coverage of test shards
+// run in separate processes, without writing or parsing text reports.
+// Files in a snapshot are found in the state using a hash table of
+// filenames, so that merging takes time linear in the size of the snapshot.
+// When registering, a content hash for each file can be passed as well:
+//     mocov_line_covered('register', keys, n_lines, hashes)
+// which is stored in snapshots, so that counts for a file that has changed
+// in the meantime are not merged. Likewise, the granularity with which the
+// counts were recorded (such as "line" or "block") can be set using
+//     mocov_line_covered('granularity', granularity)
+// which is stored in snapshots; merging a snapshot with a different
+// granularity raises an error, as block counts are only recorded for the
+// first line of each block. An empty granularity is unknown, and matches
+// any other; a state with unknown granularity takes that of the first
+// merged snapshot that has one. Setting the state makes it unknown.
+//
+// A snapshot (version 2) consists of, with varint denoting an unsigned
+// LEB128 integer (7 bits per byte, least significant byte first):
+//     magic               the 8 bytes "MOCOVSNP"
+//     version             varint
+//     granularity         varint length, followed by the characters
+//                         (empty if unknown; absent in version 1)
+//     n_files             varint
+//     for each file:
+//         filename        varint length, followed by the characters
+//         hash            varint length, followed by the characters
+//         n_counted       varint, number of lines with a non-zero count
+//         for each of these lines, in increasing order:
+//             line delta  varint, line number minus that of the previous
+//                         line (or minus 0 for the first line)
+//             count       varint
+//
+// Lines can be attributed to a "context", such as the name of a test,
+// using
+//     mocov_line_covered('set_context', name)
+// after which every recorded line is also marked as hit by that context,
+// until another context is set ('' sets no context). While a context is
+// active, its hits are stored in a bitset for each file it touched; when
+// the context is switched, the bitsets are compressed to runs of
+// consecutive hit lines, so that storing thousands of contexts remains
+// cheap. Setting a context that was used before continues it. The runs
+// for all contexts are returned by
+//     contexts = mocov_line_covered('get_contexts')
+// as a struct with fields .names (Cx1 cell with the name of each context),
+// .keys (as in the state) and .ranges, an Mx4 array where each row
+// [context, file, first_line, last_line] (all base 1) indicates that lines
+// first_line to last_line of the file were hit by the context. Contexts
+// are not stored in snapshots.
+//
+// For finding slow code, the time between consecutive probes can be
+// recorded as well, using
+//     mocov_line_covered('timing', true)
+// after which, for every recorded line, the time (using a monotonic clock)
+// since the previous recorded line is added to the time of the previous
+// line. Times, in seconds, are returned by
+//     times = mocov_line_covered('get_times')
+// as an Nx1 cell, with for each file the time for each line (as for
+// .line_count in the state). Timing is stopped using
+//     mocov_line_covered('timing', false)
+// which does not attribute the time since the last recorded line to any
+// line. Setting a context also starts a new interval, so that time spent
+// between tests is not attributed to the last line of the previous test.
+//
+// When only whether a line was hit matters, and not how often, use
+//     mocov_line_covered('boolean', true)
+// after which recording a line sets its count to 1 if it was 0, and leaves
+// it unchanged otherwise (also for counts added with 'add'). A line that
+// was hit before is only read, not written, which avoids writing to memory
+// (and, with shared counters, contention between processes) for lines that
+// are executed often. Counts that were already larger than 1 are kept.
+// Boolean mode is stopped using
+//     mocov_line_covered('boolean', false)
+// or when the state is set.
+//
+// Instead of the whole state, the line counts of a single file can be
+// queried using
+//     counts = mocov_line_covered('get_file', idx)
+// or, with filename the name of a file in the state,
+//     counts = mocov_line_covered('get_file', filename)
+// which returns a column vector as for the file in .line_count of the
+// state. Lines whose count changed since the previous query are returned by
+//     delta = mocov_line_covered('get_delta')
+// as an Mx3 array where each row [file, line, delta] (file and line base
+// 1) indicates that the count of the line increased by delta. The first
+// query (and the first after setting the state) returns all lines with a
+// non-zero count. Counts at the time of the query are kept for each file
+// that has changed lines, so that recording lines is not slowed down.
+// Both queries write directly into the output array, so that they can be
+// called often while coverage is recorded (for example, to show progress).
+//
+// Several processes on the same machine can record into a single set of
+// line counts, using
+//     mocov_line_covered('share', fn)
+// which maps the file fn into memory, and stores the line counts of all
+// files in the state there. If fn does not exist (or is empty), it is
+// created with a layout taken from the files in the state (which must
+// have been registered with their number of lines), and the counts in the
+// state are moved into it. Otherwise the layout in fn must match the files
+// in the state, which are registered from fn if the state is empty, and
+// the counts in the state are added to those in fn. While shared, lines
+// are counted using atomic increments, so that no counts are lost, and
+// the state returns the counts of all processes. All processes must use
+// the same LINE_COUNT_BITS. A process that calls
+// this function for the first time attaches to the file named by the
+// environment variable MOCOV_SHARED_COUNTERS_FILE, if set. Sharing stops,
+// keeping a copy of the counts at that moment, using
+//     mocov_line_covered('unshare')
+// or when the state is set. Shared counters require POSIX shared memory
+// mappings and a compiler with atomic builtins (GCC or clang); the layout
+// is native to the machine, so fn should not be copied between machines.
+// A shared counter file consists of, as native 64 bit unsigned integers
+// unless indicated otherwise:
+//     magic               the 8 bytes "MOCOVSHM"
+//     version             2
+//     n_files
+//     n_counts            total number of lines of all files
+//     counts_offset       position of the counts in the file, in bytes
+//     count_bits          LINE_COUNT_BITS of the process that created it
+//     for each file:
+//         n_lines
+//         name_length
+//         name            the characters, padded with zeros to a multiple
+//                         of 8 bytes
+//     counts              n_counts line counts (of count_bits bits each),
+//                         with the lines of each file following those of
+//                         the previous file
+//
+// Line counts are stored as unsigned integers of LINE_COUNT_BITS bits
+// (8, 32 or 64), set at compile time, for example using
+//     mex -DLINE_COUNT_BITS=64 mocov_line_covered.c
+// (see the compile-mex-octave target in the Makefile). Counts saturate at
+// the largest value that fits, rather than wrapping around; 8 bits suffice
+// if only whether lines were hit matters (see 'boolean' above), and use a
+// quarter of the memory of the default of 32 bits, while 64 bits are for
+// runs with lines executed more than four billion times. Counts above
+// 2^53 are returned with the precision of a double. The width, and how
+// much memory line counts use, are returned by
+//     info = mocov_line_covered('info')
+// as a struct with fields .line_count_bits, .bytes_per_line, .n_files,
+// .n_lines (the number of lines with space for a count) and .line_bytes
+// (the memory used for these counts, in bytes).
+//
 // To help with debugging, the code defines and uses `debug()` en
 // `debug_print_state()` calls. When enabled (not by default), this prints
 // extensive output that might help debugging.
 
+// clock_gettime requires POSIX, which is not part of standard C
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "mex.h"
 #include <assert.h>
+#include <limits.h>
 #include <math.h> // For isnan()
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Shared counters require mapping a file into memory, and atomic increments
+#if !defined(_WIN32) && (defined(__GNUC__) || defined(__clang__))
+#define HAS_SHARED_COUNTERS 1
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define HAS_SHARED_COUNTERS 0
+#endif
 
 // 0 -> no debugging messages; 1 -> print (lots of) debugging messages
 #ifndef IS_DEBUG
@@ -40,7 +236,23 @@
 #define CACHE_FILENAME_POINTERS 0
 #endif
 
-typedef int line_count_t;
+// 8 -> uint8, 32 -> uint32, 64 -> uint64 line counts (see above)
+#ifndef LINE_COUNT_BITS
+#define LINE_COUNT_BITS 32
+#endif
+
+#if LINE_COUNT_BITS == 8
+typedef uint8_t line_count_t;
+#define LINE_COUNT_MAX UINT8_MAX
+#elif LINE_COUNT_BITS == 32
+typedef uint32_t line_count_t;
+#define LINE_COUNT_MAX UINT32_MAX
+#elif LINE_COUNT_BITS == 64
+typedef uint64_t line_count_t;
+#define LINE_COUNT_MAX UINT64_MAX
+#else
+#error "LINE_COUNT_BITS must be 8, 32 or 64"
+#endif
 
 // Define helper that computes the maximum of two values
 int max(int a, int b) { return (a > b) ? a : b; }
@@ -55,16 +267,88 @@ typedef struct {
 // Structure to store covered lines for a single .m file
 typedef struct {
     char *filename;      // Dynamically allocated string for the filename
+    char *hash;          // Content hash of the file, or NULL if unknown
     size_t capacity;     // Size of line_counts
     size_t n_lines;      // Largest line number encountered so far
     covered_line *lines; // For each line how often it was executed
+    bool in_arena;       // Whether lines points into the arena of the state
 } covered_file;
 
+// Lines hit by a context in a single file, one bit for each line
+typedef struct {
+    uint64_t *words; // bit j of word i is set if line 64*i+j was hit
+    size_t n_words;  // Number of elements in words
+} line_bitset;
+
+// Lines hit by a context, as runs of consecutive lines
+typedef struct {
+    char *name;      // Dynamically allocated name of the context
+    int *runs;       // (file, first line, last line) triples, base 0
+    size_t n_runs;   // Number of triples in runs
+    size_t capacity; // Number of triples that fit in runs
+} coverage_context;
+
+// Time spent on each line of a single file
+typedef struct {
+    double *seconds; // time for each line, or NULL
+    size_t capacity; // Number of elements in seconds
+} line_times;
+
+// Line counts of a single file at the time of the previous 'get_delta'
+typedef struct {
+    line_count_t *counts; // count for each line, or NULL
+    size_t capacity;      // Number of elements in counts
+} line_checkpoint;
+
+// Open addressing hash table from names to (base 0) indices of items with
+// that name, such as files or contexts in the state, so that items are
+// found by name in constant time (rather than time linear in the number of
+// items)
+typedef struct {
+    int *slots;      // item index + 1 for each slot, or 0 if the slot is empty
+    size_t capacity; // number of slots, always a power of two
+    size_t n_items;  // number of slots that are not empty
+    const char *(*get_name)(int idx); // name of the item at index idx
+} name_index;
+
 // Structure to store covered lines for a list of .m files
 typedef struct {
     size_t n_files;      // Number of files
     size_t capacity;     // Size of files
     covered_file *files; // Array of covered_file structs (one for each file)
+    covered_line *arena; // Line counts of registered files, or NULL
+    size_t arena_size;   // Number of elements in arena
+
+    coverage_context *contexts; // All contexts that were set
+    size_t n_contexts;          // Number of contexts
+    size_t contexts_capacity;   // Size of contexts
+    int active_context;         // Index in contexts, or -1 if none is set
+    line_bitset *active_bits;   // For each file, lines hit by the active
+                                // context
+    size_t n_active_bits;       // Size of active_bits
+
+    bool boolean;          // Whether lines are only recorded as hit (1)
+    bool timing;           // Whether time between probes is recorded
+    line_times *times;     // For each file, time spent on each line
+    size_t n_times;        // Size of times
+    int last_idx;          // File of the previous recorded line, or -1
+    int last_line_number;  // Line of the previous recorded line
+    double last_clock;     // Time at which the previous line was recorded
+
+    line_checkpoint *checkpoints; // For each file, counts at the previous
+                                  // 'get_delta' query
+    size_t n_checkpoints;         // Size of checkpoints
+
+    name_index names;         // Files by name; built on the first lookup
+                              // by name (slots is NULL until then)
+    name_index context_names; // Contexts by name; built when the first
+                              // context is set
+
+    char *granularity; // Granularity of the counts, stored in snapshots;
+                       // NULL if unknown
+
+    void *shared_region;   // Mapped shared counter file, or NULL
+    size_t shared_size;    // Size of shared_region in bytes
 } covered_files;
 
 // Declare constants
@@ -73,6 +357,16 @@ typedef struct {
 #define MAX_ERROR_ID_LENGTH 200
 #define MAX_ERROR_MESSAGE_LENGTH GENERAL_STRING_BUFFER_LENGTH
 
+#define SNAPSHOT_MAGIC "MOCOVSNP"
+#define SNAPSHOT_MAGIC_LENGTH 8
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_MIN_VERSION 1 // oldest version that can be merged
+
+#define SHARED_MAGIC "MOCOVSHM"
+#define SHARED_MAGIC_LENGTH 8
+#define SHARED_VERSION 2
+#define SHARED_COUNTERS_ENV "MOCOV_SHARED_COUNTERS_FILE"
+
 const char *ERROR_ID_PREFIX = "mocov_line_covered:";
 const char *MALLOC_ERROR_MESSAGE_PREFIX = "memory allocation failed: ";
 
@@ -164,7 +458,8 @@ void debug_print_state() {
                 } else {
                     mexPrintf(".lines=[ "); // Print size first
                     for (size_t j = 0; j < n_lines; j++) {
-                        mexPrintf("%i ", cf->lines[j].count);
+                        mexPrintf("%llu ",
+                                  (unsigned long long)cf->lines[j].count);
                     }
                     mexPrintf("]\n");
                 }
@@ -236,9 +531,11 @@ void raise_mex_error_if_null_pointer(void *ptr,
 // Function to initialize file_covered_lines with empty values
 void init_covered_file(covered_file *file) {
     file->filename = NULL;
+    file->hash = NULL;
     file->n_lines = 0;
     file->capacity = 0;
     file->lines = NULL;
+    file->in_arena = false;
 }
 
 // Function to extend the file_covered_lines struct
@@ -247,11 +544,27 @@ void extend_covered_file(covered_file *file, size_t new_capacity) {
         return; // Exit early if the current capacity is sufficient
     }
 
-    // Reallocate memory for the line_counts array
-    covered_line *new_lines =
-        realloc(file->lines, new_capacity * sizeof(covered_line));
-    raise_mex_error_if_null_pointer(
-        new_lines, "Failed to resize line_counts in covered_file");
+    // Shared lines must stay in the shared counter file, which cannot grow
+    if (file->in_arena && state != NULL && state->shared_region != NULL) {
+        raise_mex_error("SharedLayoutExceeded",
+                        "Line is beyond the lines of the file in the shared "
+                        "counters");
+    }
+
+    // Reallocate memory for the line_counts array. Lines in the arena
+    // cannot be reallocated, so they are moved out of the arena instead.
+    covered_line *new_lines;
+    if (file->in_arena) {
+        new_lines = malloc(new_capacity * sizeof(covered_line));
+        raise_mex_error_if_null_pointer(
+            new_lines, "Failed to move line_counts out of arena");
+        memcpy(new_lines, file->lines, file->capacity * sizeof(covered_line));
+        file->in_arena = false;
+    } else {
+        new_lines = realloc(file->lines, new_capacity * sizeof(covered_line));
+        raise_mex_error_if_null_pointer(
+            new_lines, "Failed to resize line_counts in covered_file");
+    }
 
     for (size_t i = file->capacity; i < new_capacity; i++) {
         new_lines[i].count = 0;
@@ -283,26 +596,33 @@ void extend_to_fit_covered_file(covered_file *file, int index) {
 void free_covered_file(covered_file *file) {
     free(file->filename);
     file->filename = NULL;
+    free(file->hash);
+    file->hash = NULL;
 
-    free(file->lines);
+    if (!file->in_arena) {
+        free(file->lines);
+    }
     file->lines = NULL;
+    file->in_arena = false;
 
     file->n_lines = 0;
     file->capacity = 0;
 }
 
-// Function to extend the covered_files struct
-void extend_covered_files(covered_files *cfs, size_t new_capacity) {
+// Extend the covered_files struct; returns false, leaving it unchanged, if
+// memory could not be allocated
+bool try_extend_covered_files(covered_files *cfs, size_t new_capacity) {
     if (new_capacity <= cfs->capacity) {
-        return; // Exit early if the new size is less than or equal to the
-                // current size
+        return true; // Exit early if the new size is less than or equal to
+                     // the current size
     }
 
     // Reallocate memory for the array of covered_file structs
     covered_file *new_files =
         realloc(cfs->files, new_capacity * sizeof(covered_file));
-    raise_mex_error_if_null_pointer(
-        new_files, "Failed to resize covered_file array in covered_files");
+    if (new_files == NULL) {
+        return false;
+    }
 
     // Initialize the newly added covered_file structs
     for (size_t i = cfs->capacity; i < new_capacity; i++) {
@@ -312,20 +632,170 @@ void extend_covered_files(covered_files *cfs, size_t new_capacity) {
     // Update the structure with the new size and covered_file array
     cfs->files = new_files;
     cfs->capacity = new_capacity;
+    return true;
+}
+
+// Function to extend the covered_files struct
+void extend_covered_files(covered_files *cfs, size_t new_capacity) {
+    if (!try_extend_covered_files(cfs, new_capacity)) {
+        raise_mex_error_if_null_pointer(
+            NULL, "Failed to resize covered_file array in covered_files");
+    }
 }
 
 // Function to extend the covered_files struct if index does not fit
 void extend_to_fit_covered_files(covered_files *cfs, int index) {
-    if (index < cfs->capacity) {
-        return;
+    if (index >= cfs->capacity) {
+        size_t new_capacity =
+            (size_t)index * 2 +
+            1; // Ensuring the new capacity is at least twice the index + 1
+        extend_covered_files(cfs, new_capacity);
     }
-    size_t new_capacity =
-        (size_t)index * 2 +
-        1; // Ensuring the new capacity is at least twice the index + 1
-    extend_covered_files(cfs, new_capacity);
     cfs->n_files = max(cfs->n_files, index + 1);
 }
 
+////////////
+// Finding files by name
+
+// Copy n characters of s to a newly allocated, null-terminated string
+char *copy_string(const char *s, size_t n) {
+    char *copy = malloc(n + 1);
+    raise_mex_error_if_null_pointer(copy, "copy of string");
+    memcpy(copy, s, n);
+    copy[n] = '\0';
+    return copy;
+}
+
+// Whether the null-terminated string s equals the n characters in t
+bool string_equals(const char *s, const char *t, size_t n) {
+    return strlen(s) == n && memcmp(s, t, n) == 0;
+}
+
+// FNV-1a hash of the n characters in s
+uint64_t hash_string(const char *s, size_t n) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < n; i++) {
+        hash ^= (unsigned char)s[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Slot with the given name, or the empty slot where it can be added
+size_t find_name_slot(const name_index *index, const char *name, size_t n) {
+    size_t mask = index->capacity - 1;
+    size_t slot = (size_t)hash_string(name, n) & mask;
+    while (index->slots[slot] != 0) {
+        int idx = index->slots[slot] - 1;
+        if (string_equals(index->get_name(idx), name, n)) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Add the item at (base 0) position idx, which must have a name
+void add_to_name_index(name_index *index, int idx);
+
+// Set the number of slots, keeping all items in the index
+void resize_name_index(name_index *index, size_t capacity) {
+    int *old_slots = index->slots;
+    size_t old_capacity = index->capacity;
+
+    index->slots = calloc(capacity, sizeof(int));
+    raise_mex_error_if_null_pointer(index->slots, "name index");
+    index->capacity = capacity;
+    index->n_items = 0;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i] != 0) {
+            add_to_name_index(index, old_slots[i] - 1);
+        }
+    }
+    free(old_slots);
+}
+
+void add_to_name_index(name_index *index, int idx) {
+    // keep at least half of the slots empty, so that lookups are fast
+    if (2 * (index->n_items + 1) > index->capacity) {
+        resize_name_index(index, 2 * index->capacity);
+    }
+
+    const char *name = index->get_name(idx);
+    size_t slot = find_name_slot(index, name, strlen(name));
+    if (index->slots[slot] == 0) {
+        index->slots[slot] = idx + 1;
+        index->n_items++;
+    }
+}
+
+// Create an empty index with space for at least n_items items
+void init_name_index(name_index *index, const char *(*get_name)(int idx),
+                     size_t n_items) {
+    index->slots = NULL;
+    index->capacity = 0;
+    index->n_items = 0;
+    index->get_name = get_name;
+
+    size_t capacity = 16;
+    while (capacity < 2 * n_items) {
+        capacity *= 2;
+    }
+    resize_name_index(index, capacity);
+}
+
+void free_name_index(name_index *index) {
+    free(index->slots);
+    index->slots = NULL;
+    index->capacity = 0;
+    index->n_items = 0;
+}
+
+// Index of the item with the given name, or -1 if absent
+int find_in_name_index(const name_index *index, const char *name,
+                       size_t n) {
+    return index->slots[find_name_slot(index, name, n)] - 1;
+}
+
+const char *get_file_name(int idx) { return state->files[idx].filename; }
+
+// Create an index with all files in the state
+void init_filename_index(name_index *index) {
+    init_name_index(index, get_file_name, state->n_files);
+    for (size_t i = 0; i < state->n_files; i++) {
+        if (state->files[i].filename != NULL) {
+            add_to_name_index(index, (int)i);
+        }
+    }
+}
+
+// Index of all files in the state, which is built when first needed
+name_index *get_filename_index() {
+    if (state->names.slots == NULL) {
+        init_filename_index(&state->names);
+    }
+    return &state->names;
+}
+
+// Set the name of the file at (base 0) position idx, which has no name yet.
+// The index of filenames, if built, is kept up to date.
+void set_file_name(int idx, char *filename) {
+    state->files[idx].filename = filename;
+    if (state->names.slots != NULL) {
+        add_to_name_index(&state->names, idx);
+    }
+}
+
+////////////
+// Functions on contexts, timing and shared counters, defined below
+void free_contexts(covered_files *cfs);
+void mark_context_line(int idx, int line_number);
+void free_times(covered_files *cfs);
+void record_time(int idx, int line_number);
+void free_checkpoints(covered_files *cfs);
+void unmap_shared_region(covered_files *cfs);
+
 // Functions that operate on internal state
 void free_state() {
     debug("free state");
@@ -338,6 +808,13 @@ void free_state() {
         }
         free(state->files);
     }
+    free(state->arena);
+    free_contexts(state);
+    free_times(state);
+    free_checkpoints(state);
+    unmap_shared_region(state);
+    free_name_index(&state->names);
+    free(state->granularity);
     free(state);
 }
 
@@ -354,6 +831,32 @@ void init_state() {
     state->n_files = 0;
     state->capacity = 0;
     state->files = NULL;
+    state->arena = NULL;
+    state->arena_size = 0;
+    state->contexts = NULL;
+    state->n_contexts = 0;
+    state->contexts_capacity = 0;
+    state->active_context = -1;
+    state->active_bits = NULL;
+    state->n_active_bits = 0;
+    state->boolean = false;
+    state->timing = false;
+    state->times = NULL;
+    state->n_times = 0;
+    state->last_idx = -1;
+    state->last_line_number = 0;
+    state->last_clock = 0;
+    state->checkpoints = NULL;
+    state->n_checkpoints = 0;
+    state->names.slots = NULL;
+    state->names.capacity = 0;
+    state->names.n_items = 0;
+    state->context_names.slots = NULL;
+    state->context_names.capacity = 0;
+    state->context_names.n_items = 0;
+    state->granularity = NULL;
+    state->shared_region = NULL;
+    state->shared_size = 0;
 }
 
 // Convert double to int, raise error if not possible
@@ -374,6 +877,20 @@ int double_to_int(double double_value) {
     return int_value;
 }
 
+// Convert double to a line count, raise error if not possible. Counts that
+// do not fit are saturated.
+uint64_t double_to_count(double double_value) {
+    if (isnan(double_value) || double_value < 0 ||
+        double_value != floor(double_value)) {
+        raise_mex_error("InvalidInput",
+                        "count must be a non-negative integer");
+    }
+    if (double_value >= (double)LINE_COUNT_MAX) {
+        return LINE_COUNT_MAX;
+    }
+    return (uint64_t)double_value;
+}
+
 // Helper function to convert singular mx Double to integer
 int get_scalar_int_from_mx_double(const mxArray *mx_arr,
                                   char *message_on_failure) {
@@ -394,16 +911,115 @@ void cleanup() { free_state(); }
 // are terminated).
 void register_cleanup() { mexAtExit(cleanup); }
 
+// Raise an error if a (base 0) file index or line number is negative
+void check_index_and_line_number(int idx, int line_number) {
+    if (idx < 0) {
+        raise_mex_error("InvalidInput", "file index must be positive");
+    }
+    if (line_number < 0) {
+        raise_mex_error("InvalidInput", "line number must be positive");
+    }
+}
+
+// Sum of a line count and an increment, saturated at LINE_COUNT_MAX
+static line_count_t saturating_add(line_count_t count, uint64_t increment) {
+    if (increment > (uint64_t)(LINE_COUNT_MAX - count)) {
+        return LINE_COUNT_MAX;
+    }
+    return (line_count_t)(count + increment);
+}
+
+#if HAS_SHARED_COUNTERS
+// Add count to a shared line count. Other processes may change it at the
+// same time, so the sum is only stored if the count has not changed since
+// it was read.
+static void add_shared_line_count(line_count_t *target, uint64_t count) {
+    line_count_t current = __atomic_load_n(target, __ATOMIC_RELAXED);
+    line_count_t updated;
+    do {
+        if (count == 0 || current == LINE_COUNT_MAX) {
+            return;
+        }
+        updated = saturating_add(current, count);
+    } while (!__atomic_compare_exchange_n(target, &current, updated, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+#endif
+
+// Add count to the (base 0) line of a file. Shared lines are increased
+// atomically, as other processes may increase them at the same time.
+// In boolean mode, a line that was not hit is set to 1 instead.
+static void add_line_count(covered_file *cf, int line_number,
+                           uint64_t count) {
+    if (state->boolean) {
+        line_count_t *target = &cf->lines[line_number].count;
+#if HAS_SHARED_COUNTERS
+        if (state->shared_region != NULL && cf->in_arena) {
+            if (count > 0 && __atomic_load_n(target, __ATOMIC_RELAXED) == 0) {
+                __atomic_store_n(target, 1, __ATOMIC_RELAXED);
+            }
+            return;
+        }
+#endif
+        if (count > 0 && *target == 0) {
+            *target = 1;
+        }
+        return;
+    }
+
+#if HAS_SHARED_COUNTERS
+    if (state->shared_region != NULL && cf->in_arena) {
+        add_shared_line_count(&cf->lines[line_number].count, count);
+        return;
+    }
+#endif
+    line_count_t *target = &cf->lines[line_number].count;
+    *target = saturating_add(*target, count);
+}
+
+// Count of the (base 0) line of a file. Shared lines are read atomically,
+// as other processes may increase them at the same time.
+static line_count_t get_line_count(const covered_file *cf,
+                                   size_t line_number) {
+#if HAS_SHARED_COUNTERS
+    if (state->shared_region != NULL && cf->in_arena) {
+        return __atomic_load_n(&cf->lines[line_number].count,
+                               __ATOMIC_RELAXED);
+    }
+#endif
+    return cf->lines[line_number].count;
+}
+
+// Number of lines of a file for which a count is returned
+static size_t get_n_counted_lines(const covered_file *cf) {
+    return cf->lines != NULL ? cf->n_lines : 0;
+}
+
+// Write the counts of the first n lines of a file to target, which is
+// usually the data of an output array
+void copy_line_counts(const covered_file *cf, double *target, size_t n) {
+    for (size_t j = 0; j < n; j++) {
+        target[j] = (double)get_line_count(cf, j);
+    }
+}
+
 // Helper function to add a line state count
 void add_line_covered(int idx, const mxArray *fn_mx, int line_number) {
 
     debug("add line covered idx=%i, line_number (base 0)=%i", idx, line_number);
     debug_print_state();
 
+    check_index_and_line_number(idx, line_number);
     extend_to_fit_covered_files(state, idx);
     covered_file *cf = &state->files[idx];
     extend_to_fit_covered_file(cf, line_number);
-    cf->lines[line_number].count++;
+    add_line_count(cf, line_number, 1);
+    if (state->active_context >= 0) {
+        mark_context_line(idx, line_number);
+    }
+    if (state->timing) {
+        record_time(idx, line_number);
+    }
 
     const bool needs_to_set_filename = cf->filename == NULL;
 
@@ -416,7 +1032,7 @@ void add_line_covered(int idx, const mxArray *fn_mx, int line_number) {
         raise_mex_error_if_null_pointer(fn, "fn in update_state");
 
         if (needs_to_set_filename) {
-            cf->filename = fn;
+            set_file_name(idx, fn);
         } else {
             const bool is_filename_mismatch = strcmp(cf->filename, fn) != 0;
             // make sure memory is freed before raising exception
@@ -436,136 +1052,1672 @@ void add_line_covered(int idx, const mxArray *fn_mx, int line_number) {
     debug_print_state();
 }
 
-// Function to return the state
-void return_state(const mxArray *prhs[], int nlhs, mxArray *plhs[]) {
-    if (nlhs > 1) {
-        raise_mex_error("TooManyOutputs",
-                        "This function accepts at most one output.");
+// Helper function to add a line state count for a registered file.
+// Unlike add_line_covered, no strings are involved.
+void add_line_covered_by_index(int idx, int line_number) {
+    debug("add line covered by index idx=%i, line_number (base 0)=%i", idx,
+          line_number);
+
+    check_index_and_line_number(idx, line_number);
+    if (idx >= state->n_files || state->files[idx].filename == NULL) {
+        raise_mex_error("UnregisteredFile",
+                        "File index was not registered, this should not "
+                        "happen");
+    }
 
-    } else if (nlhs == 0) {
-        // No output, nothing to do, we can exit this function early.
-        return;
+    covered_file *cf = &state->files[idx];
+    if (line_number >= cf->n_lines) {
+        // Only happens for files registered without number of lines, or
+        // if a file has changed since it was registered.
+        extend_to_fit_covered_file(cf, line_number);
+    }
+    add_line_count(cf, line_number, 1);
+    if (state->active_context >= 0) {
+        mark_context_line(idx, line_number);
     }
+    if (state->timing) {
+        record_time(idx, line_number);
+    }
+}
 
-    debug("Return state, which is:");
-    debug_print_state();
+// Add counts for several lines of a registered file at once. If counts is
+// NULL, each line number counts once (line numbers may occur multiple times).
+void add_lines_covered_by_index(int idx, const double *line_numbers,
+                                const double *counts, size_t n) {
+    check_index_and_line_number(idx, 0);
+    if (idx >= state->n_files || state->files[idx].filename == NULL) {
+        raise_mex_error("UnregisteredFile",
+                        "File index was not registered, this should not "
+                        "happen");
+    }
 
-    // Cast size_t to mwSize for correct compatibility with mx functions
-    int n_files = state->n_files;
-    mwSize mw_n_files = (mwSize)n_files;
+    // check all line numbers first, so that the state is not changed
+    // if any of them is invalid
+    int max_line_number = -1;
+    for (size_t i = 0; i < n; i++) {
+        int line_number = double_to_int(line_numbers[i]) - 1;
+        check_index_and_line_number(idx, line_number);
+        if (line_number > max_line_number) {
+            max_line_number = line_number;
+        }
+    }
 
-    mxArray *mx_keys_cell = mxCreateCellArray(1, &mw_n_files);
-    raise_mex_error_if_null_pointer(mx_keys_cell, "mx_keys_cell");
+    covered_file *cf = &state->files[idx];
+    if (max_line_number >= cf->n_lines) {
+        extend_to_fit_covered_file(cf, max_line_number);
+    }
 
-    mxArray *mx_line_counts_cell = mxCreateCellArray(1, &mw_n_files);
-    raise_mex_error_if_null_pointer(mx_line_counts_cell, "mx_line_counts_cell");
+    for (size_t i = 0; i < n; i++) {
+        int line_number = double_to_int(line_numbers[i]) - 1;
+        uint64_t count = counts == NULL ? 1 : double_to_count(counts[i]);
+        add_line_count(cf, line_number, count);
+        if (count > 0 && state->active_context >= 0) {
+            mark_context_line(idx, line_number);
+        }
+    }
+}
 
-    for (size_t i = 0; i < n_files; i++) {
-        covered_file *cf = &state->files[i];
-        bool has_cf = cf != NULL;
+// Move the line counts of the first n_files files into a single newly
+// allocated arena, where file i gets (at least) n_lines[i] lines.
+// Line counts already in the state are preserved.
+void allocate_arena(size_t n_files, const double *n_lines) {
+    if (state->shared_region != NULL) {
+        // the layout of the shared counters cannot change
+        raise_mex_error("AlreadyShared",
+                        "Cannot register the number of lines while the "
+                        "line counts are shared");
+    }
 
-        // cached filenames (keys)
-        bool has_filename = has_cf && cf->filename != NULL;
-        char *cached_key = has_filename ? cf->filename : "";
-        mxArray *mx_cached_key = mxCreateString(cached_key);
-        raise_mex_error_if_null_pointer(mx_cached_key, "mx_cached_key");
-        mxSetCell(mx_keys_cell, i, mx_cached_key);
-        debug("file %i: has_filename=%i, key=%s", i, has_filename, cached_key);
+    size_t *sizes = malloc((n_files + 1) * sizeof(size_t));
+    raise_mex_error_if_null_pointer(sizes, "arena sizes");
 
-        // cached line counts
-        bool has_line_count = has_cf && cf->lines != NULL;
+    size_t arena_size = 0;
+    for (size_t i = 0; i < n_files; i++) {
+        int n = double_to_int(n_lines[i]);
+        if (n < 0) {
+            free(sizes);
+            raise_mex_error("InvalidInput",
+                            "number of lines must be non-negative");
+        }
+        sizes[i] = max(n, state->files[i].n_lines);
+        arena_size += sizes[i];
+    }
 
-        // Return a row vector for each file (when debugging it's more
-        // readable).
-        size_t n_rows = has_line_count ? cf->n_lines : 0;
-        size_t n_columns = 1;
-        size_t n_items = n_columns * n_rows;
+    // allocate at least one element, so that NULL means failure
+    covered_line *arena = calloc(arena_size + 1, sizeof(covered_line));
+    if (arena == NULL) {
+        free(sizes);
+        raise_mex_error_if_null_pointer(arena, "arena");
+    }
 
-        mxArray *mx_line_count =
-            mxCreateNumericMatrix(n_rows, n_columns, mxDOUBLE_CLASS, mxREAL);
-        raise_mex_error_if_null_pointer(mx_line_count, "mx_line_count");
+    size_t offset = 0;
+    for (size_t i = 0; i < n_files; i++) {
+        covered_file *cf = &state->files[i];
+        covered_line *lines = arena + offset;
 
-        mxDouble *arr_line_count = calloc(n_items, sizeof(mxDouble));
-        raise_mex_error_if_null_pointer(mx_line_count, "arr_line_count");
+        for (size_t j = 0; j < sizes[i]; j++) {
+            lines[j].count = j < cf->n_lines ? cf->lines[j].count : 0;
+#if CACHE_FILENAME_POINTERS
+            lines[j].filename_mx = NULL;
+#endif
+        }
 
-        for (size_t j = 0; j < n_items; j++) {
-            // copy line counts one-by-one
-            arr_line_count[j] = (mxDouble)cf->lines[j].count;
+        if (!cf->in_arena) {
+            free(cf->lines);
         }
+        cf->lines = lines;
+        cf->in_arena = true;
+        cf->capacity = sizes[i];
+        cf->n_lines = sizes[i];
+        offset += sizes[i];
+    }
+    free(sizes);
 
-        memcpy(mxGetData(mx_line_count), arr_line_count,
-               n_items * sizeof(double));
-        free(arr_line_count);
-        mxSetCell(mx_line_counts_cell, i, mx_line_count);
+    // files not part of the new arena may still use the old one
+    for (size_t i = n_files; i < state->n_files; i++) {
+        covered_file *cf = &state->files[i];
+        if (cf->in_arena) {
+            covered_line *lines = malloc((cf->capacity + 1) *
+                                         sizeof(covered_line));
+            raise_mex_error_if_null_pointer(lines, "lines out of arena");
+            memcpy(lines, cf->lines, cf->capacity * sizeof(covered_line));
+            cf->lines = lines;
+            cf->in_arena = false;
+        }
     }
 
-    plhs[0] =
-        mxCreateStructMatrix(1, 1, 2, (const char *[]){"keys", "line_count"});
-    mxSetField(plhs[0], 0, "keys", mx_keys_cell);
-    mxSetField(plhs[0], 0, "line_count", mx_line_counts_cell);
+    free(state->arena);
+    state->arena = arena;
+    state->arena_size = arena_size;
+    debug("allocated arena with %i lines for %i files", arena_size, n_files);
 }
 
-// Function to handle nrhs == 1 case (setting the state)
-void set_state(const mxArray *prhs[], int nlhs, mxArray *plhs[]) {
-    if (nlhs > 1) {
-        mexErrMsgIdAndTxt("mocov_line_covered:TooManyOutputs",
-                          "This function accepts only one output.");
+// Register filenames, so that afterwards files can be referred to by index
+// If mx_n_lines is not NULL, it must contain the number of lines for each
+// file; the line counts are then stored in the arena.
+// If mx_hashes is not NULL, it must contain the content hash of each file
+// (or an empty string if unknown), which is stored in snapshots.
+void register_files(const mxArray *mx_keys, const mxArray *mx_n_lines,
+                    const mxArray *mx_hashes) {
+    if (!mxIsCell(mx_keys)) {
+        raise_mex_error("InvalidInput", "keys must be a cell");
     }
-    debug("Setting state, original value was:");
-    debug_print_state();
-
-    // always clear the cache and start from fresh
-    init_state();
-
-    debug("... state has been initialized.");
 
-    // Set default values in case of empty input
-    mwSize n_keys = 0;
-    mwSize n_line_counts = 0;
-    size_t n_files = 0;
+    size_t n_keys = mxGetNumberOfElements(mx_keys);
+    if (mx_n_lines != NULL &&
+        (!mxIsDouble(mx_n_lines) ||
+         mxGetNumberOfElements(mx_n_lines) != n_keys)) {
+        raise_mex_error("InvalidInput",
+                        "number of lines must be a numeric vector with one "
+                        "element for each key");
+    }
+    if (mx_hashes != NULL &&
+        (!mxIsCell(mx_hashes) || mxGetNumberOfElements(mx_hashes) != n_keys)) {
+        raise_mex_error("InvalidInput",
+                        "hashes must be a cell with one element for each "
+                        "key");
+    }
 
-    mxArray *keys_array = NULL;
-    mxArray *line_count_array = NULL;
+    if (n_keys == 0) {
+        return;
+    }
 
-    // Special case: support empty input [] (the empty array)
-    bool has_empty_input =
-        (mxIsDouble(prhs[0]) && mxGetNumberOfElements(prhs[0]) == 0);
+    extend_to_fit_covered_files(state, (int)n_keys - 1);
 
-    if (!has_empty_input) {
-        // The usual case: state is set using a struct with fields
-        // .keys and .line_count. This means extra checks need to be done.
-        if (!mxIsStruct(prhs[0])) {
-            raise_mex_error("InvalidInput", "Input must be a struct.");
+    for (size_t i = 0; i < n_keys; i++) {
+        const mxArray *mx_key = mxGetCell(mx_keys, i);
+        if (mx_key == NULL || !mxIsChar(mx_key)) {
+            raise_mex_error("InvalidInput", "keys must be a cell with strings");
         }
 
-        if (mxGetNumberOfElements(prhs[0]) != 1) {
-            raise_mex_error("InvalidInput", "Input struct must have size 1x1");
-        };
-
-        keys_array = mxGetField(prhs[0], 0, "keys");
-        line_count_array = mxGetField(prhs[0], 0, "line_count");
+        char *filename = mxArrayToString(mx_key);
+        raise_mex_error_if_null_pointer(filename, "filename in register");
 
-        if (keys_array == NULL || line_count_array == NULL) {
-            mexErrMsgIdAndTxt(
-                "mocov_line_covered:MissingFields",
-                "Input struct must have 'keys' and 'line_count' fields.");
-            return; // make static checker happy
+        covered_file *cf = &state->files[i];
+        if (cf->filename == NULL) {
+            set_file_name((int)i, filename);
+        } else {
+            const bool is_filename_mismatch =
+                strcmp(cf->filename, filename) != 0;
+            // make sure memory is freed before raising exception
+            free(filename);
+            if (is_filename_mismatch) {
+                raise_mex_error("FileNameMismatch",
+                                "Registered file name differs from file "
+                                "name already in state");
+            }
         }
 
-        // Set required space for state
-        n_keys = mxGetNumberOfElements(keys_array);
-        n_line_counts = mxGetNumberOfElements(line_count_array);
-
-        debug("n_keys=%i, n_line_counts=%i", n_keys, n_line_counts);
+        if (mx_hashes != NULL) {
+            const mxArray *mx_hash = mxGetCell(mx_hashes, i);
+            if (mx_hash == NULL || !mxIsChar(mx_hash)) {
+                raise_mex_error("InvalidInput",
+                                "hashes must be a cell with strings");
+            }
+            if (mxGetNumberOfElements(mx_hash) == 0) {
+                continue;
+            }
 
-        if (n_keys != n_line_counts) {
-            mexErrMsgIdAndTxt("mocov_line_covered:InvalidInput",
-                              "Input struct fields .keys and .line_count have "
-                              "different number of elements");
-            return; // make static checker happy
+            char *hash = mxArrayToString(mx_hash);
+            raise_mex_error_if_null_pointer(hash, "hash in register");
+            if (cf->hash == NULL) {
+                cf->hash = hash;
+            } else {
+                const bool is_hash_mismatch = strcmp(cf->hash, hash) != 0;
+                free(hash);
+                if (is_hash_mismatch) {
+                    raise_mex_error("ContentHashMismatch",
+                                    "Registered content hash differs from "
+                                    "hash already in state");
+                }
+            }
         }
-        n_files = (size_t)n_keys;
-        debug("cache size from input: %i", n_files);
+    }
+
+    if (mx_n_lines != NULL) {
+        allocate_arena(n_keys, mxGetPr(mx_n_lines));
+    }
+
+    debug("registered %i files, state is now", n_keys);
+    debug_print_state();
+}
+
+// Index of the file with name filename in the state, or -1 if it is not
+// there
+int find_file_index_by_name(const char *filename) {
+    return find_in_name_index(get_filename_index(), filename,
+                              strlen(filename));
+}
+
+// Index of the file with the name in mx_filename, which is added to the
+// state (after all other files) if it is not there yet
+int get_or_add_file_index(const mxArray *mx_filename) {
+    char *filename = mxArrayToString(mx_filename);
+    raise_mex_error_if_null_pointer(filename, "filename in add");
+
+    int found_idx = find_file_index_by_name(filename);
+    if (found_idx >= 0) {
+        free(filename);
+        return found_idx;
+    }
+
+    int idx = state->n_files;
+    extend_to_fit_covered_files(state, idx);
+    set_file_name(idx, filename);
+    return idx;
+}
+
+////////////
+// Coverage contexts
+
+// Set the bit for a (base 0) line in a bitset, growing it if necessary
+void set_bitset_line(line_bitset *bits, size_t line_number,
+                     size_t n_lines_hint) {
+    size_t word = line_number / 64;
+    if (word >= bits->n_words) {
+        size_t n_words = (n_lines_hint + 63) / 64;
+        if (n_words <= word) {
+            n_words = 2 * word + 1;
+        }
+        uint64_t *words = realloc(bits->words, n_words * sizeof(uint64_t));
+        raise_mex_error_if_null_pointer(words, "context bitset");
+        memset(words + bits->n_words, 0,
+               (n_words - bits->n_words) * sizeof(uint64_t));
+        bits->words = words;
+        bits->n_words = n_words;
+    }
+    bits->words[word] |= (uint64_t)1 << (line_number % 64);
+}
+
+// Mark a (base 0) line in the file at (base 0) position idx as hit by the
+// active context
+void mark_context_line(int idx, int line_number) {
+    if (idx >= state->n_active_bits) {
+        size_t n = state->n_files > (size_t)idx ? state->n_files
+                                                : (size_t)idx + 1;
+        line_bitset *active_bits =
+            realloc(state->active_bits, n * sizeof(line_bitset));
+        raise_mex_error_if_null_pointer(active_bits, "context bitsets");
+        for (size_t i = state->n_active_bits; i < n; i++) {
+            active_bits[i].words = NULL;
+            active_bits[i].n_words = 0;
+        }
+        state->active_bits = active_bits;
+        state->n_active_bits = n;
+    }
+
+    // space for all lines of the file is allocated at once
+    set_bitset_line(&state->active_bits[idx], (size_t)line_number,
+                    state->files[idx].n_lines);
+}
+
+// Append a run of hit lines (all base 0) to a context
+void add_context_run(coverage_context *context, int file, int first,
+                     int last) {
+    if (context->n_runs == context->capacity) {
+        size_t capacity = 2 * context->capacity + 4;
+        int *runs = realloc(context->runs, 3 * capacity * sizeof(int));
+        raise_mex_error_if_null_pointer(runs, "context runs");
+        context->runs = runs;
+        context->capacity = capacity;
+    }
+    int *run = context->runs + 3 * context->n_runs;
+    run[0] = file;
+    run[1] = first;
+    run[2] = last;
+    context->n_runs++;
+}
+
+// Move the bitsets of the active context into its runs, so that no
+// context is active afterwards. Files and lines are visited in increasing
+// order, so the runs are sorted.
+void compress_active_context() {
+    if (state->active_context < 0) {
+        return;
+    }
+    coverage_context *context = &state->contexts[state->active_context];
+
+    for (size_t i = 0; i < state->n_active_bits; i++) {
+        line_bitset *bits = &state->active_bits[i];
+        int first = -1;
+        for (size_t w = 0; w < bits->n_words; w++) {
+            uint64_t word = bits->words[w];
+            if (first < 0 && word == 0) {
+                // skip words without hit lines quickly
+                continue;
+            }
+            for (int b = 0; b < 64; b++) {
+                bool is_hit = (word >> b) & 1;
+                int line_number = (int)(64 * w) + b;
+                if (is_hit && first < 0) {
+                    first = line_number;
+                } else if (!is_hit && first >= 0) {
+                    add_context_run(context, (int)i, first, line_number - 1);
+                    first = -1;
+                }
+            }
+        }
+        if (first >= 0) {
+            add_context_run(context, (int)i, first,
+                            (int)(64 * bits->n_words) - 1);
+        }
+
+        free(bits->words);
+        bits->words = NULL;
+        bits->n_words = 0;
+    }
+    state->active_context = -1;
+}
+
+// Make a context active, moving its runs into bitsets
+void expand_context(int context_index) {
+    coverage_context *context = &state->contexts[context_index];
+    state->active_context = context_index;
+
+    for (size_t r = 0; r < context->n_runs; r++) {
+        const int *run = context->runs + 3 * r;
+        for (int line_number = run[1]; line_number <= run[2];
+             line_number++) {
+            mark_context_line(run[0], line_number);
+        }
+    }
+    context->n_runs = 0;
+}
+
+const char *get_context_name(int idx) { return state->contexts[idx].name; }
+
+// Index of the context with the given name, which is added if necessary
+int get_context_index(const char *name) {
+    name_index *index = &state->context_names;
+    if (index->slots == NULL) {
+        init_name_index(index, get_context_name, 0);
+    }
+    int found_idx = find_in_name_index(index, name, strlen(name));
+    if (found_idx >= 0) {
+        return found_idx;
+    }
+
+    if (state->n_contexts == state->contexts_capacity) {
+        size_t capacity = 2 * state->contexts_capacity + 4;
+        coverage_context *contexts =
+            realloc(state->contexts, capacity * sizeof(coverage_context));
+        raise_mex_error_if_null_pointer(contexts, "contexts");
+        state->contexts = contexts;
+        state->contexts_capacity = capacity;
+    }
+
+    coverage_context *context = &state->contexts[state->n_contexts];
+    context->name = copy_string(name, strlen(name));
+    context->runs = NULL;
+    context->n_runs = 0;
+    context->capacity = 0;
+    int idx = (int)state->n_contexts++;
+    add_to_name_index(index, idx);
+    return idx;
+}
+
+// Set the active context; an empty name means that no context is active
+void set_context(const char *name) {
+    // time between contexts (such as in a test framework) is not
+    // attributed to any line
+    state->last_idx = -1;
+
+    compress_active_context();
+    if (name[0] != '\0') {
+        expand_context(get_context_index(name));
+    }
+}
+
+void free_contexts(covered_files *cfs) {
+    for (size_t i = 0; i < cfs->n_contexts; i++) {
+        free(cfs->contexts[i].name);
+        free(cfs->contexts[i].runs);
+    }
+    free(cfs->contexts);
+    cfs->contexts = NULL;
+    cfs->n_contexts = 0;
+    cfs->contexts_capacity = 0;
+    free_name_index(&cfs->context_names);
+
+    for (size_t i = 0; i < cfs->n_active_bits; i++) {
+        free(cfs->active_bits[i].words);
+    }
+    free(cfs->active_bits);
+    cfs->active_bits = NULL;
+    cfs->n_active_bits = 0;
+    cfs->active_context = -1;
+}
+
+// Helper function for the 'set_context' command
+void run_set_context_command(const mxArray *prhs[], int nrhs) {
+    if (nrhs != 2 || !(mxIsChar(prhs[1]) || mxIsEmpty(prhs[1]))) {
+        raise_mex_error("InvalidInput",
+                        "Usage: mocov_line_covered('set_context', name)");
+    }
+
+    // memory allocated by mxArrayToString is freed automatically if an
+    // error is raised
+    char *name = mxIsChar(prhs[1]) ? mxArrayToString(prhs[1]) : NULL;
+    set_context(name == NULL ? "" : name);
+    mxFree(name);
+}
+
+// Return all contexts with their runs, as described at the top of this
+// file
+mxArray *get_contexts() {
+    // the active context is compressed temporarily, so that all runs are
+    // available
+    int active_context = state->active_context;
+    compress_active_context();
+
+    size_t n_runs = 0;
+    for (size_t i = 0; i < state->n_contexts; i++) {
+        n_runs += state->contexts[i].n_runs;
+    }
+
+    mxArray *mx_names = mxCreateCellMatrix(state->n_contexts, 1);
+    mxArray *mx_keys = mxCreateCellMatrix(state->n_files, 1);
+    mxArray *mx_ranges = mxCreateDoubleMatrix(n_runs, 4, mxREAL);
+    raise_mex_error_if_null_pointer(mx_ranges, "context ranges");
+    double *ranges = mxGetPr(mx_ranges);
+
+    size_t row = 0;
+    for (size_t i = 0; i < state->n_contexts; i++) {
+        coverage_context *context = &state->contexts[i];
+        mxSetCell(mx_names, i, mxCreateString(context->name));
+
+        for (size_t r = 0; r < context->n_runs; r++) {
+            const int *run = context->runs + 3 * r;
+            // column-major, all base 1
+            ranges[row] = (double)(i + 1);
+            ranges[row + n_runs] = (double)(run[0] + 1);
+            ranges[row + 2 * n_runs] = (double)(run[1] + 1);
+            ranges[row + 3 * n_runs] = (double)(run[2] + 1);
+            row++;
+        }
+    }
+
+    for (size_t i = 0; i < state->n_files; i++) {
+        const char *filename = state->files[i].filename;
+        mxSetCell(mx_keys, i, mxCreateString(filename == NULL ? ""
+                                                              : filename));
+    }
+
+    if (active_context >= 0) {
+        expand_context(active_context);
+    }
+
+    mxArray *result = mxCreateStructMatrix(
+        1, 1, 3, (const char *[]){"names", "keys", "ranges"});
+    mxSetField(result, 0, "names", mx_names);
+    mxSetField(result, 0, "keys", mx_keys);
+    mxSetField(result, 0, "ranges", mx_ranges);
+    return result;
+}
+
+////////////
+// Timing
+
+// Current time in seconds, using a monotonic clock
+double get_monotonic_clock() {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+#endif
+}
+
+// Add time to a (base 0) line of the file at (base 0) position idx
+void add_line_time(int idx, int line_number, double seconds) {
+    if (idx >= state->n_times) {
+        size_t n = state->n_files > (size_t)idx ? state->n_files
+                                                : (size_t)idx + 1;
+        line_times *times = realloc(state->times, n * sizeof(line_times));
+        raise_mex_error_if_null_pointer(times, "line times");
+        for (size_t i = state->n_times; i < n; i++) {
+            times[i].seconds = NULL;
+            times[i].capacity = 0;
+        }
+        state->times = times;
+        state->n_times = n;
+    }
+
+    line_times *file_times = &state->times[idx];
+    if (line_number >= file_times->capacity) {
+        // space for all lines of the file is allocated at once
+        size_t capacity = state->files[idx].n_lines;
+        if (capacity <= (size_t)line_number) {
+            capacity = 2 * (size_t)line_number + 1;
+        }
+        double *seconds =
+            realloc(file_times->seconds, capacity * sizeof(double));
+        raise_mex_error_if_null_pointer(seconds, "line times of file");
+        for (size_t i = file_times->capacity; i < capacity; i++) {
+            seconds[i] = 0;
+        }
+        file_times->seconds = seconds;
+        file_times->capacity = capacity;
+    }
+    file_times->seconds[line_number] += seconds;
+}
+
+// Attribute the time since the previous recorded line to that line, and
+// start a new interval for the (base 0) line just recorded
+void record_time(int idx, int line_number) {
+    double now = get_monotonic_clock();
+    if (state->last_idx >= 0) {
+        add_line_time(state->last_idx, state->last_line_number,
+                      now - state->last_clock);
+    }
+    state->last_idx = idx;
+    state->last_line_number = line_number;
+
+    // the time spent above is not attributed to the line
+    state->last_clock = get_monotonic_clock();
+}
+
+void free_times(covered_files *cfs) {
+    for (size_t i = 0; i < cfs->n_times; i++) {
+        free(cfs->times[i].seconds);
+    }
+    free(cfs->times);
+    cfs->times = NULL;
+    cfs->n_times = 0;
+    cfs->timing = false;
+    cfs->last_idx = -1;
+}
+
+// Helper function for the 'timing' command
+void run_timing_command(const mxArray *prhs[], int nrhs) {
+    if (nrhs != 2 || mxGetNumberOfElements(prhs[1]) != 1 ||
+        !(mxIsLogical(prhs[1]) || mxIsDouble(prhs[1]))) {
+        raise_mex_error("InvalidInput",
+                        "Usage: mocov_line_covered('timing', true|false)");
+    }
+
+    state->timing = mxGetScalar(prhs[1]) != 0;
+    state->last_idx = -1;
+}
+
+// Helper function for the 'boolean' command
+void run_boolean_command(const mxArray *prhs[], int nrhs) {
+    if (nrhs != 2 || mxGetNumberOfElements(prhs[1]) != 1 ||
+        !(mxIsLogical(prhs[1]) || mxIsDouble(prhs[1]))) {
+        raise_mex_error("InvalidInput",
+                        "Usage: mocov_line_covered('boolean', true|false)");
+    }
+
+    state->boolean = mxGetScalar(prhs[1]) != 0;
+}
+
+// Return the time spent on each line of each file
+mxArray *get_times() {
+    mxArray *mx_times = mxCreateCellMatrix(state->n_files, 1);
+    raise_mex_error_if_null_pointer(mx_times, "times");
+
+    for (size_t i = 0; i < state->n_files; i++) {
+        size_t n_lines = state->files[i].n_lines;
+        mxArray *mx_file_times = mxCreateDoubleMatrix(n_lines, 1, mxREAL);
+        raise_mex_error_if_null_pointer(mx_file_times, "times of file");
+
+        if (i < state->n_times && state->times[i].seconds != NULL) {
+            size_t n = state->times[i].capacity < n_lines
+                           ? state->times[i].capacity
+                           : n_lines;
+            memcpy(mxGetPr(mx_file_times), state->times[i].seconds,
+                   n * sizeof(double));
+        }
+        mxSetCell(mx_times, i, mx_file_times);
+    }
+    return mx_times;
+}
+
+////////////
+// Queries
+
+// Return the line counts of a single file, given by its (base 1) index
+// or its name
+mxArray *get_file_counts(const mxArray *mx_file) {
+    int idx;
+    if (mxIsChar(mx_file)) {
+        char *filename = mxArrayToString(mx_file);
+        raise_mex_error_if_null_pointer(filename, "filename in get_file");
+        idx = find_file_index_by_name(filename);
+        mxFree(filename);
+        if (idx < 0) {
+            raise_mex_error("InvalidInput", "File is not in the state");
+        }
+    } else {
+        idx = get_scalar_int_from_mx_double(mx_file, "arg 2 of get_file") -
+              1; // Convert to 0-base file index
+        if (idx < 0 || idx >= state->n_files) {
+            raise_mex_error("InvalidInput", "File index is out of range");
+        }
+    }
+
+    const covered_file *cf = &state->files[idx];
+    size_t n = get_n_counted_lines(cf);
+    mxArray *mx_counts = mxCreateDoubleMatrix(n, 1, mxREAL);
+    raise_mex_error_if_null_pointer(mx_counts, "counts of file");
+    copy_line_counts(cf, mxGetPr(mx_counts), n);
+    return mx_counts;
+}
+
+// Make sure the checkpoint of the file at (base 0) position idx has space
+// for n_lines lines
+void extend_checkpoint(size_t idx, size_t n_lines) {
+    if (idx >= state->n_checkpoints) {
+        size_t n = state->n_files > idx ? state->n_files : idx + 1;
+        line_checkpoint *checkpoints =
+            realloc(state->checkpoints, n * sizeof(line_checkpoint));
+        raise_mex_error_if_null_pointer(checkpoints, "checkpoints");
+        for (size_t i = state->n_checkpoints; i < n; i++) {
+            checkpoints[i].counts = NULL;
+            checkpoints[i].capacity = 0;
+        }
+        state->checkpoints = checkpoints;
+        state->n_checkpoints = n;
+    }
+
+    line_checkpoint *checkpoint = &state->checkpoints[idx];
+    if (n_lines > checkpoint->capacity) {
+        line_count_t *counts =
+            realloc(checkpoint->counts, n_lines * sizeof(line_count_t));
+        raise_mex_error_if_null_pointer(counts, "checkpoint of file");
+        memset(counts + checkpoint->capacity, 0,
+               (n_lines - checkpoint->capacity) * sizeof(line_count_t));
+        checkpoint->counts = counts;
+        checkpoint->capacity = n_lines;
+    }
+}
+
+// Count of a (base 0) line of the file at (base 0) position idx at the
+// previous 'get_delta' query
+static line_count_t get_checkpoint_count(size_t idx, size_t line_number) {
+    if (idx >= state->n_checkpoints) {
+        return 0;
+    }
+    const line_checkpoint *checkpoint = &state->checkpoints[idx];
+    return line_number < checkpoint->capacity
+               ? checkpoint->counts[line_number]
+               : 0;
+}
+
+// Return the lines whose count changed since the previous query, as rows
+// [file, line, delta], and keep the current counts for the next query
+mxArray *get_delta() {
+    // the number of changed lines is counted first, so that the output
+    // can be allocated once and written directly
+    size_t n_changed = 0;
+    for (size_t i = 0; i < state->n_files; i++) {
+        const covered_file *cf = &state->files[i];
+        size_t n = get_n_counted_lines(cf);
+        for (size_t j = 0; j < n; j++) {
+            if (get_line_count(cf, j) != get_checkpoint_count(i, j)) {
+                n_changed++;
+            }
+        }
+    }
+
+    mxArray *mx_delta = mxCreateDoubleMatrix(n_changed, 3, mxREAL);
+    raise_mex_error_if_null_pointer(mx_delta, "delta");
+    double *files = mxGetPr(mx_delta);
+    double *lines = files + n_changed;
+    double *deltas = lines + n_changed;
+
+    // Shared counts only increase, so at least n_changed lines have changed
+    // when they are read again. Lines that changed in the meantime, beyond
+    // the first n_changed, are returned by the next query.
+    size_t k = 0;
+    for (size_t i = 0; i < state->n_files && k < n_changed; i++) {
+        const covered_file *cf = &state->files[i];
+        size_t n = get_n_counted_lines(cf);
+        for (size_t j = 0; j < n && k < n_changed; j++) {
+            line_count_t count = get_line_count(cf, j);
+            line_count_t previous = get_checkpoint_count(i, j);
+            if (count == previous) {
+                continue;
+            }
+
+            extend_checkpoint(i, n);
+            state->checkpoints[i].counts[j] = count;
+
+            files[k] = (double)(i + 1);
+            lines[k] = (double)(j + 1);
+            deltas[k] = (double)count - (double)previous;
+            k++;
+        }
+    }
+    return mx_delta;
+}
+
+// Return the width of line counts and the memory used for them
+mxArray *get_info() {
+    size_t n_lines = 0;
+    for (size_t i = 0; i < state->n_files; i++) {
+        n_lines += state->files[i].capacity;
+    }
+
+    const char *fields[] = {"line_count_bits", "bytes_per_line", "n_files",
+                            "n_lines", "line_bytes"};
+    double values[] = {LINE_COUNT_BITS, sizeof(covered_line),
+                       (double)state->n_files, (double)n_lines,
+                       (double)(n_lines * sizeof(covered_line))};
+    const int n_fields = sizeof(values) / sizeof(values[0]);
+
+    mxArray *mx_info = mxCreateStructMatrix(1, 1, n_fields, fields);
+    raise_mex_error_if_null_pointer(mx_info, "info");
+    for (int i = 0; i < n_fields; i++) {
+        mxSetField(mx_info, 0, fields[i], mxCreateDoubleScalar(values[i]));
+    }
+    return mx_info;
+}
+
+void free_checkpoints(covered_files *cfs) {
+    for (size_t i = 0; i < cfs->n_checkpoints; i++) {
+        free(cfs->checkpoints[i].counts);
+    }
+    free(cfs->checkpoints);
+    cfs->checkpoints = NULL;
+    cfs->n_checkpoints = 0;
+}
+
+////////////
+// Shared counters
+
+// Size in bytes of the layout of a file in a shared counter file
+size_t get_shared_file_layout_size(size_t name_length) {
+    return 2 * sizeof(uint64_t) + (name_length + 7) / 8 * 8;
+}
+
+// Size of the header of a shared counter file
+#define SHARED_HEADER_SIZE (SHARED_MAGIC_LENGTH + 5 * sizeof(uint64_t))
+
+#if HAS_SHARED_COUNTERS
+
+// Lock or unlock the whole file, waiting until a lock is obtained
+void lock_shared_file(int fd, short lock_type) {
+    struct flock lock;
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = lock_type;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = 0;
+    lock.l_len = 0;
+    while (fcntl(fd, F_SETLKW, &lock) == -1) {
+        if (errno != EINTR) {
+            close(fd);
+            raise_mex_error("SharedFileError",
+                            "Unable to lock the shared counter file");
+        }
+    }
+}
+
+// Map a file into memory, closing the file descriptor on failure
+void *map_shared_file(int fd, size_t size) {
+    void *region =
+        mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (region == MAP_FAILED) {
+        close(fd);
+        raise_mex_error("SharedFileError",
+                        "Unable to map the shared counter file");
+    }
+    return region;
+}
+
+// Unmap a region and close its file before raising an error
+void raise_shared_error(int fd, void *region, size_t size,
+                        const char *error_id_label,
+                        const char *error_message) {
+    munmap(region, size);
+    close(fd);
+    raise_mex_error(error_id_label, error_message);
+}
+
+// Point the lines of the first n_files files into the counts of the
+// shared region, where file i has n_lines[i] lines, and free the memory
+// previously used for the line counts
+void use_shared_counts(void *region, size_t size, size_t counts_offset,
+                       size_t n_files, const uint64_t *n_lines) {
+    covered_line *counts =
+        (covered_line *)((unsigned char *)region + counts_offset);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < n_files; i++) {
+        covered_file *cf = &state->files[i];
+        if (!cf->in_arena) {
+            free(cf->lines);
+        }
+        cf->lines = counts + offset;
+        cf->in_arena = true;
+        cf->capacity = (size_t)n_lines[i];
+        cf->n_lines = (size_t)n_lines[i];
+        offset += (size_t)n_lines[i];
+    }
+
+    free(state->arena);
+    state->arena = NULL;
+    state->arena_size = 0;
+    state->shared_region = region;
+    state->shared_size = size;
+}
+
+// Create the shared counter file with the layout of the files in the state,
+// and move the line counts of the state into it
+void create_shared_region(int fd) {
+    size_t n_files = state->n_files;
+    size_t n_counts = 0;
+    size_t counts_offset = SHARED_HEADER_SIZE;
+    for (size_t i = 0; i < n_files; i++) {
+        covered_file *cf = &state->files[i];
+        if (cf->filename == NULL) {
+            close(fd);
+            raise_mex_error("UnregisteredFile",
+                            "All files must be registered before the line "
+                            "counts can be shared");
+        }
+        n_counts += cf->n_lines;
+        counts_offset += get_shared_file_layout_size(strlen(cf->filename));
+    }
+    size_t size = counts_offset + n_counts * sizeof(covered_line);
+
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        raise_mex_error("SharedFileError",
+                        "Unable to set the size of the shared counter file");
+    }
+    unsigned char *region = map_shared_file(fd, size);
+
+    uint64_t *n_lines = malloc((n_files + 1) * sizeof(uint64_t));
+    if (n_lines == NULL) {
+        raise_shared_error(fd, region, size, "memory_allocation_failed",
+                           "shared layout");
+    }
+
+    uint64_t header[5] = {SHARED_VERSION, n_files, n_counts, counts_offset,
+                          LINE_COUNT_BITS};
+    memcpy(region, SHARED_MAGIC, SHARED_MAGIC_LENGTH);
+    memcpy(region + SHARED_MAGIC_LENGTH, header, sizeof(header));
+
+    // layout of each file; ftruncate has already filled the file with zeros
+    unsigned char *pos = region + SHARED_HEADER_SIZE;
+    covered_line *counts = (covered_line *)(region + counts_offset);
+    size_t offset = 0;
+    for (size_t i = 0; i < n_files; i++) {
+        covered_file *cf = &state->files[i];
+        size_t name_length = strlen(cf->filename);
+        uint64_t file_header[2] = {cf->n_lines, name_length};
+        memcpy(pos, file_header, sizeof(file_header));
+        memcpy(pos + sizeof(file_header), cf->filename, name_length);
+        pos += get_shared_file_layout_size(name_length);
+
+        n_lines[i] = cf->n_lines;
+        for (size_t j = 0; j < cf->n_lines; j++) {
+            counts[offset + j].count = cf->lines[j].count;
+        }
+        offset += cf->n_lines;
+    }
+
+    close(fd);
+    use_shared_counts(region, size, counts_offset, n_files, n_lines);
+    free(n_lines);
+}
+
+// Attach to an existing shared counter file, registering its files if the
+// state has none, and add the line counts of the state to it
+void attach_shared_region(int fd, size_t size) {
+    if (size < SHARED_HEADER_SIZE) {
+        close(fd);
+        raise_mex_error("SharedFileError",
+                        "Shared counter file is too small");
+    }
+    unsigned char *region = map_shared_file(fd, size);
+
+    uint64_t header[5];
+    memcpy(header, region + SHARED_MAGIC_LENGTH, sizeof(header));
+    if (memcmp(region, SHARED_MAGIC, SHARED_MAGIC_LENGTH) != 0 ||
+        header[0] != SHARED_VERSION) {
+        raise_shared_error(fd, region, size, "SharedFileError",
+                           "Not a shared counter file, or an unsupported "
+                           "version");
+    }
+    if (header[4] != LINE_COUNT_BITS) {
+        raise_shared_error(fd, region, size, "LayoutMismatch",
+                           "Shared counters have a different "
+                           "LINE_COUNT_BITS");
+    }
+
+    size_t n_files = (size_t)header[1];
+    size_t n_counts = (size_t)header[2];
+    size_t counts_offset = (size_t)header[3];
+    if (counts_offset < SHARED_HEADER_SIZE || counts_offset > size ||
+        n_counts > (size - counts_offset) / sizeof(covered_line) ||
+        n_files > (counts_offset - SHARED_HEADER_SIZE) / 16) {
+        raise_shared_error(fd, region, size, "SharedFileError",
+                           "Shared counter file is truncated");
+    }
+    if (state->n_files > n_files) {
+        raise_shared_error(fd, region, size, "LayoutMismatch",
+                           "State has more files than the shared counters");
+    }
+
+    uint64_t *n_lines = malloc((n_files + 1) * sizeof(uint64_t));
+    if (n_lines == NULL) {
+        raise_shared_error(fd, region, size, "memory_allocation_failed",
+                           "shared layout");
+    }
+
+    // check the layout against the state before changing anything
+    unsigned char *pos = region + SHARED_HEADER_SIZE;
+    unsigned char *end = region + counts_offset;
+    size_t n_layout_counts = 0;
+    const char *mismatch = NULL;
+    for (size_t i = 0; i < n_files && mismatch == NULL; i++) {
+        uint64_t file_header[2];
+        if ((size_t)(end - pos) < sizeof(file_header)) {
+            mismatch = "Shared counter file is truncated";
+            break;
+        }
+        memcpy(file_header, pos, sizeof(file_header));
+        size_t name_length = (size_t)file_header[1];
+        if ((size_t)(end - pos) < get_shared_file_layout_size(name_length)) {
+            mismatch = "Shared counter file is truncated";
+            break;
+        }
+        const char *name = (const char *)(pos + sizeof(file_header));
+
+        n_lines[i] = file_header[0];
+        n_layout_counts += (size_t)n_lines[i];
+        if (i < state->n_files) {
+            covered_file *cf = &state->files[i];
+            if (cf->filename != NULL &&
+                !string_equals(cf->filename, name, name_length)) {
+                mismatch = "File name differs from the name in the shared "
+                           "counters";
+            } else if (cf->n_lines > n_lines[i]) {
+                mismatch = "File has more lines than in the shared "
+                           "counters";
+            }
+        }
+        pos += get_shared_file_layout_size(name_length);
+    }
+    if (mismatch == NULL && n_layout_counts != n_counts) {
+        mismatch = "Shared counter file is inconsistent";
+    }
+    if (mismatch != NULL) {
+        free(n_lines);
+        raise_shared_error(fd, region, size, "LayoutMismatch", mismatch);
+    }
+
+    // allocate everything that registering the files needs before changing
+    // the state, so that the region can still be unmapped if memory runs
+    // out
+    char **names = calloc(n_files + 1, sizeof(char *));
+    bool allocated = names != NULL && try_extend_covered_files(state, n_files);
+    pos = region + SHARED_HEADER_SIZE;
+    for (size_t i = 0; i < n_files && allocated; i++) {
+        uint64_t file_header[2];
+        memcpy(file_header, pos, sizeof(file_header));
+        size_t name_length = (size_t)file_header[1];
+
+        if (i >= state->n_files || state->files[i].filename == NULL) {
+            names[i] = malloc(name_length + 1);
+            allocated = names[i] != NULL;
+            if (allocated) {
+                memcpy(names[i], pos + sizeof(file_header), name_length);
+                names[i][name_length] = '\0';
+            }
+        }
+        pos += get_shared_file_layout_size(name_length);
+    }
+    if (!allocated) {
+        for (size_t i = 0; names != NULL && i < n_files; i++) {
+            free(names[i]);
+        }
+        free(names);
+        free(n_lines);
+        raise_shared_error(fd, region, size, "memory_allocation_failed",
+                           "shared layout");
+    }
+    close(fd);
+
+    // register files, and add the counts of the state. The index of
+    // filenames is rebuilt when next needed, as adding to it could require
+    // memory.
+    free_name_index(&state->names);
+    state->n_files = n_files; // the state has no more files, as checked
+    pos = region + SHARED_HEADER_SIZE;
+    covered_line *counts = (covered_line *)(region + counts_offset);
+    size_t offset = 0;
+    for (size_t i = 0; i < n_files; i++) {
+        uint64_t file_header[2];
+        memcpy(file_header, pos, sizeof(file_header));
+        size_t name_length = (size_t)file_header[1];
+
+        covered_file *cf = &state->files[i];
+        if (names[i] != NULL) {
+            set_file_name((int)i, names[i]);
+        }
+        for (size_t j = 0; j < cf->n_lines; j++) {
+            add_shared_line_count(&counts[offset + j].count,
+                                  cf->lines[j].count);
+        }
+
+        offset += (size_t)n_lines[i];
+        pos += get_shared_file_layout_size(name_length);
+    }
+
+    use_shared_counts(region, size, counts_offset, n_files, n_lines);
+    free(names);
+    free(n_lines);
+}
+
+// Create or attach to the shared counter file fn
+void share_counts(const char *fn) {
+#if CACHE_FILENAME_POINTERS
+    raise_mex_error("SharedCountersNotSupported",
+                    "Shared counters require CACHE_FILENAME_POINTERS=0");
+#endif
+    if (state->shared_region != NULL) {
+        raise_mex_error("AlreadyShared", "Line counts are already shared");
+    }
+
+    int fd = open(fn, O_RDWR | O_CREAT, 0666);
+    if (fd == -1) {
+        raise_mex_error("SharedFileError",
+                        "Unable to open the shared counter file");
+    }
+
+    // only one process at a time creates the file or attaches to it; the
+    // lock is released when the file is closed
+    lock_shared_file(fd, F_WRLCK);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        raise_mex_error("SharedFileError",
+                        "Unable to get the size of the shared counter file");
+    }
+
+    if (st.st_size == 0) {
+        create_shared_region(fd);
+    } else {
+        attach_shared_region(fd, (size_t)st.st_size);
+    }
+    debug("shared line counts in %s", fn);
+}
+
+#else
+
+void share_counts(const char *fn) {
+    raise_mex_error("SharedCountersNotSupported",
+                    "Shared counters are not supported on this platform");
+}
+
+#endif
+
+// Stop sharing; if keep_counts, the line counts at this moment are copied
+// into a newly allocated arena
+void unshare_counts(bool keep_counts) {
+    if (state->shared_region == NULL) {
+        return;
+    }
+
+    if (keep_counts) {
+        size_t arena_size = 0;
+        for (size_t i = 0; i < state->n_files; i++) {
+            if (state->files[i].in_arena) {
+                arena_size += state->files[i].capacity;
+            }
+        }
+
+        covered_line *arena = calloc(arena_size + 1, sizeof(covered_line));
+        raise_mex_error_if_null_pointer(arena, "arena");
+
+        size_t offset = 0;
+        for (size_t i = 0; i < state->n_files; i++) {
+            covered_file *cf = &state->files[i];
+            if (!cf->in_arena) {
+                continue;
+            }
+            memcpy(arena + offset, cf->lines,
+                   cf->capacity * sizeof(covered_line));
+            cf->lines = arena + offset;
+            offset += cf->capacity;
+        }
+        state->arena = arena;
+        state->arena_size = arena_size;
+    }
+
+    unmap_shared_region(state);
+}
+
+void unmap_shared_region(covered_files *cfs) {
+#if HAS_SHARED_COUNTERS
+    if (cfs->shared_region != NULL) {
+        munmap(cfs->shared_region, cfs->shared_size);
+    }
+#endif
+    cfs->shared_region = NULL;
+    cfs->shared_size = 0;
+}
+
+// Attach to the shared counter file named in the environment, if any
+void share_counts_from_environment() {
+    const char *fn = getenv(SHARED_COUNTERS_ENV);
+    if (fn != NULL && fn[0] != '\0') {
+        share_counts(fn);
+    }
+}
+
+// Helper function for the 'share' and 'unshare' commands
+void run_share_command(const char *command, const mxArray *prhs[],
+                       int nrhs) {
+    if (strcmp(command, "unshare") == 0) {
+        if (nrhs != 1) {
+            raise_mex_error("InvalidInput",
+                            "Usage: mocov_line_covered('unshare')");
+        }
+        unshare_counts(true);
+        return;
+    }
+
+    if (nrhs != 2 || !mxIsChar(prhs[1])) {
+        raise_mex_error("InvalidInput",
+                        "Usage: mocov_line_covered('share', fn)");
+    }
+
+    char *fn = mxArrayToString(prhs[1]);
+    raise_mex_error_if_null_pointer(fn, "shared counter filename");
+    share_counts(fn);
+    mxFree(fn);
+}
+
+////////////
+// Binary snapshots
+
+// Write value as an unsigned LEB128 integer
+void write_varint(FILE *fid, uint64_t value) {
+    do {
+        unsigned char byte = value & 0x7f;
+        value >>= 7;
+        if (value != 0) {
+            byte |= 0x80;
+        }
+        fputc(byte, fid);
+    } while (value != 0);
+}
+
+// Write the length of s followed by its characters; NULL is written as ""
+void write_string(FILE *fid, const char *s) {
+    size_t n = s == NULL ? 0 : strlen(s);
+    write_varint(fid, n);
+    if (n > 0) {
+        fwrite(s, 1, n, fid);
+    }
+}
+
+// Write the state to a snapshot file. Only lines with a positive count are
+// stored.
+void save_snapshot(const char *fn) {
+    // counts of each file are read once into a buffer, so that counts
+    // that other processes increase while saving (with shared counters)
+    // are written consistently
+    size_t max_n_lines = 0;
+    for (size_t i = 0; i < state->n_files; i++) {
+        size_t n_lines = get_n_counted_lines(&state->files[i]);
+        if (n_lines > max_n_lines) {
+            max_n_lines = n_lines;
+        }
+    }
+    line_count_t *counts = malloc((max_n_lines + 1) * sizeof(line_count_t));
+    raise_mex_error_if_null_pointer(counts, "counts in save");
+
+    FILE *fid = fopen(fn, "wb");
+    if (fid == NULL) {
+        free(counts);
+        raise_mex_error("FileError", "Unable to open snapshot for writing");
+    }
+
+    fwrite(SNAPSHOT_MAGIC, 1, SNAPSHOT_MAGIC_LENGTH, fid);
+    write_varint(fid, SNAPSHOT_VERSION);
+    write_string(fid, state->granularity);
+    write_varint(fid, state->n_files);
+
+    for (size_t i = 0; i < state->n_files; i++) {
+        covered_file *cf = &state->files[i];
+        write_string(fid, cf->filename);
+        write_string(fid, cf->hash);
+
+        size_t n_lines = get_n_counted_lines(cf);
+        size_t n_counted = 0;
+        for (size_t j = 0; j < n_lines; j++) {
+            counts[j] = get_line_count(cf, j);
+            n_counted += counts[j] > 0;
+        }
+        write_varint(fid, n_counted);
+
+        size_t prev_line_number = 0;
+        for (size_t j = 0; j < n_lines; j++) {
+            if (counts[j] > 0) {
+                write_varint(fid, j + 1 - prev_line_number);
+                write_varint(fid, (uint64_t)counts[j]);
+                prev_line_number = j + 1;
+            }
+        }
+    }
+    free(counts);
+
+    const bool has_write_error = ferror(fid) != 0;
+    if (fclose(fid) != 0 || has_write_error) {
+        raise_mex_error("FileError", "Unable to write snapshot");
+    }
+    debug("saved snapshot with %i files", state->n_files);
+}
+
+// Read a complete file into a buffer allocated with mxMalloc, which is
+// freed automatically if an error is raised before it is freed with
+// mxFree; returns NULL on failure
+unsigned char *read_file(const char *fn, size_t *size) {
+    FILE *fid = fopen(fn, "rb");
+    if (fid == NULL) {
+        return NULL;
+    }
+
+    unsigned char *data = NULL;
+    long n = -1;
+    if (fseek(fid, 0, SEEK_END) == 0) {
+        n = ftell(fid);
+    }
+    if (n >= 0 && fseek(fid, 0, SEEK_SET) == 0) {
+        // allocate at least one element, so that NULL means failure
+        data = mxMalloc((size_t)n + 1);
+        if (data != NULL && fread(data, 1, (size_t)n, fid) != (size_t)n) {
+            mxFree(data);
+            data = NULL;
+        }
+    }
+    fclose(fid);
+
+    *size = (size_t)n;
+    return data;
+}
+
+// Position in the contents of a snapshot that is being read
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+} snapshot_reader;
+
+// Read an unsigned LEB128 integer; returns false if it is not complete
+bool read_varint(snapshot_reader *reader, uint64_t *value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (reader->pos >= reader->size) {
+            return false;
+        }
+        unsigned char byte = reader->data[reader->pos++];
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Read a string written by write_string. s points into the data of the
+// reader, and is not null-terminated.
+bool read_string(snapshot_reader *reader, const char **s, size_t *n) {
+    uint64_t length;
+    if (!read_varint(reader, &length) ||
+        length > reader->size - reader->pos) {
+        return false;
+    }
+    *s = (const char *)reader->data + reader->pos;
+    *n = (size_t)length;
+    reader->pos += *n;
+    return true;
+}
+
+
+// Index in the state for a file not yet in the state, which was stored at
+// position i in the snapshot. That position is used if it is not taken,
+// so that merging into an empty state keeps all positions.
+int get_new_file_index(size_t i) {
+    if (i >= state->n_files || state->files[i].filename == NULL) {
+        return (int)i;
+    }
+    return (int)state->n_files;
+}
+
+// Error raised when merging a snapshot; id is NULL if there was no error
+typedef struct {
+    const char *id;
+    const char *message;
+} snapshot_error;
+
+// Parse the contents of a snapshot. If apply is false, only check that the
+// snapshot is valid, that its content hashes match those in the state, and
+// that its lines fit in the shared counters; otherwise add the line counts
+// in the snapshot to the state.
+snapshot_error merge_snapshot_data(const unsigned char *data, size_t size,
+                                   bool apply, name_index *index) {
+    const snapshot_error no_error = {NULL, NULL};
+    const snapshot_error invalid = {"InvalidSnapshot",
+                                    "Snapshot is truncated or corrupt"};
+    snapshot_reader reader = {data, size, 0};
+
+    if (size < SNAPSHOT_MAGIC_LENGTH ||
+        memcmp(data, SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LENGTH) != 0) {
+        return (snapshot_error){"InvalidSnapshot", "Not a MOcov snapshot"};
+    }
+    reader.pos = SNAPSHOT_MAGIC_LENGTH;
+
+    uint64_t version, n_files;
+    if (!read_varint(&reader, &version)) {
+        return invalid;
+    }
+    if (version < SNAPSHOT_MIN_VERSION || version > SNAPSHOT_VERSION) {
+        return (snapshot_error){"InvalidSnapshot",
+                                "Unsupported snapshot version"};
+    }
+
+    const char *granularity = NULL;
+    size_t n_granularity = 0;
+    if (version >= 2 &&
+        !read_string(&reader, &granularity, &n_granularity)) {
+        return invalid;
+    }
+    if (!read_varint(&reader, &n_files)) {
+        return invalid;
+    }
+
+    if (n_granularity > 0) {
+        if (!apply) {
+            if (state->granularity != NULL &&
+                !string_equals(state->granularity, granularity,
+                               n_granularity)) {
+                return (snapshot_error){
+                    "GranularityMismatch",
+                    "Granularity in snapshot differs from granularity in "
+                    "state"};
+            }
+        } else if (state->granularity == NULL) {
+            state->granularity = copy_string(granularity, n_granularity);
+        }
+    }
+
+    for (uint64_t i = 0; i < n_files; i++) {
+        const char *filename, *hash;
+        size_t n_filename, n_hash;
+        uint64_t n_counted;
+        if (!read_string(&reader, &filename, &n_filename) ||
+            !read_string(&reader, &hash, &n_hash) ||
+            !read_varint(&reader, &n_counted)) {
+            return invalid;
+        }
+
+        // a file without name has no counts that can be merged
+        covered_file *cf = NULL;
+        // number of lines the file can have; only shared lines are limited
+        uint64_t max_lines = UINT64_MAX;
+        if (n_filename > 0) {
+            int idx = find_in_name_index(index, filename, n_filename);
+            if (!apply) {
+                const covered_file *state_cf =
+                    idx < 0 ? NULL : &state->files[idx];
+                const char *state_hash =
+                    state_cf == NULL ? NULL : state_cf->hash;
+                if (state_hash != NULL && n_hash > 0 &&
+                    !string_equals(state_hash, hash, n_hash)) {
+                    return (snapshot_error){
+                        "ContentHashMismatch",
+                        "Content hash in snapshot differs from hash in "
+                        "state"};
+                }
+                if (state_cf != NULL && state_cf->in_arena &&
+                    state->shared_region != NULL) {
+                    max_lines = state_cf->capacity;
+                }
+            } else {
+                if (idx < 0) {
+                    idx = get_new_file_index((size_t)i);
+                }
+                extend_to_fit_covered_files(state, idx);
+                cf = &state->files[idx];
+                if (cf->filename == NULL) {
+                    set_file_name(idx, copy_string(filename, n_filename));
+                }
+                if (cf->hash == NULL && n_hash > 0) {
+                    cf->hash = copy_string(hash, n_hash);
+                }
+            }
+        }
+
+        uint64_t line_number = 0;
+        for (uint64_t j = 0; j < n_counted; j++) {
+            uint64_t delta, count;
+            if (!read_varint(&reader, &delta) ||
+                !read_varint(&reader, &count) || delta == 0 ||
+                delta > INT_MAX - line_number) {
+                return invalid;
+            }
+            line_number += delta;
+            if (line_number > max_lines) {
+                return (snapshot_error){
+                    "SharedLayoutExceeded",
+                    "Line is beyond the lines of the file in the shared "
+                    "counters"};
+            }
+
+            if (cf != NULL) {
+                // line numbers are increasing, so extending to fit
+                // happens at most once for each time the file grows
+                int line_index = (int)line_number - 1;
+                if (line_index >= cf->n_lines) {
+                    extend_to_fit_covered_file(cf, line_index);
+                }
+                add_line_count(cf, line_index, count);
+            }
+        }
+    }
+
+    if (reader.pos != size) {
+        return invalid;
+    }
+    return no_error;
+}
+
+// Add the line counts in a snapshot file to the state. The state is only
+// changed if the snapshot is valid.
+void merge_snapshot(const char *fn) {
+    size_t size;
+    unsigned char *data = read_file(fn, &size);
+    if (data == NULL) {
+        raise_mex_error("FileError", "Unable to read snapshot");
+    }
+
+    name_index *index = get_filename_index();
+
+    // the first pass finds all errors the second pass could raise, apart
+    // from running out of memory, in which case data is freed by mxMalloc
+    snapshot_error error = merge_snapshot_data(data, size, false, index);
+    if (error.id == NULL) {
+        error = merge_snapshot_data(data, size, true, index);
+    }
+    // make sure memory is freed before raising exception
+    mxFree(data);
+    if (error.id != NULL) {
+        raise_mex_error(error.id, error.message);
+    }
+
+    debug("merged snapshot, state is now");
+    debug_print_state();
+}
+
+// Helper function for the 'granularity' command
+void run_granularity_command(const mxArray *prhs[], int nrhs) {
+    if (nrhs != 2 || !(mxIsChar(prhs[1]) || mxIsEmpty(prhs[1]))) {
+        raise_mex_error("InvalidInput",
+                        "Usage: mocov_line_covered('granularity', "
+                        "granularity)");
+    }
+
+    char *granularity = NULL;
+    if (!mxIsEmpty(prhs[1])) {
+        char *mx_granularity = mxArrayToString(prhs[1]);
+        raise_mex_error_if_null_pointer(mx_granularity, "granularity");
+        granularity = copy_string(mx_granularity, strlen(mx_granularity));
+        mxFree(mx_granularity);
+    }
+
+    free(state->granularity);
+    state->granularity = granularity;
+}
+
+// Helper function for the 'save' and 'merge' commands
+void run_snapshot_command(const char *command, const mxArray *prhs[],
+                          int nrhs) {
+    if (nrhs != 2 || !mxIsChar(prhs[1])) {
+        raise_mex_error("InvalidInput",
+                        "Usage: mocov_line_covered('save'|'merge', fn)");
+    }
+
+    // memory allocated by mxArrayToString is freed automatically if an
+    // error is raised
+    char *fn = mxArrayToString(prhs[1]);
+    raise_mex_error_if_null_pointer(fn, "snapshot filename");
+
+    if (strcmp(command, "save") == 0) {
+        save_snapshot(fn);
+    } else {
+        merge_snapshot(fn);
+    }
+    mxFree(fn);
+}
+
+// Function to return the state
+void return_state(const mxArray *prhs[], int nlhs, mxArray *plhs[]) {
+    if (nlhs > 1) {
+        raise_mex_error("TooManyOutputs",
+                        "This function accepts at most one output.");
+
+    } else if (nlhs == 0) {
+        // No output, nothing to do, we can exit this function early.
+        return;
+    }
+
+    debug("Return state, which is:");
+    debug_print_state();
+
+    // Cast size_t to mwSize for correct compatibility with mx functions
+    int n_files = state->n_files;
+    mwSize mw_n_files = (mwSize)n_files;
+
+    mxArray *mx_keys_cell = mxCreateCellArray(1, &mw_n_files);
+    raise_mex_error_if_null_pointer(mx_keys_cell, "mx_keys_cell");
+
+    mxArray *mx_line_counts_cell = mxCreateCellArray(1, &mw_n_files);
+    raise_mex_error_if_null_pointer(mx_line_counts_cell, "mx_line_counts_cell");
+
+    for (size_t i = 0; i < n_files; i++) {
+        covered_file *cf = &state->files[i];
+        bool has_cf = cf != NULL;
+
+        // cached filenames (keys)
+        bool has_filename = has_cf && cf->filename != NULL;
+        char *cached_key = has_filename ? cf->filename : "";
+        mxArray *mx_cached_key = mxCreateString(cached_key);
+        raise_mex_error_if_null_pointer(mx_cached_key, "mx_cached_key");
+        mxSetCell(mx_keys_cell, i, mx_cached_key);
+        debug("file %i: has_filename=%i, key=%s", i, has_filename, cached_key);
+
+        // cached line counts
+        bool has_line_count = has_cf && cf->lines != NULL;
+
+        // Return a column vector for each file, with the counts written
+        // directly into its data
+        size_t n_rows = has_line_count ? cf->n_lines : 0;
+
+        mxArray *mx_line_count = mxCreateDoubleMatrix(n_rows, 1, mxREAL);
+        raise_mex_error_if_null_pointer(mx_line_count, "mx_line_count");
+        copy_line_counts(cf, mxGetPr(mx_line_count), n_rows);
+        mxSetCell(mx_line_counts_cell, i, mx_line_count);
+    }
+
+    plhs[0] =
+        mxCreateStructMatrix(1, 1, 2, (const char *[]){"keys", "line_count"});
+    mxSetField(plhs[0], 0, "keys", mx_keys_cell);
+    mxSetField(plhs[0], 0, "line_count", mx_line_counts_cell);
+}
+
+// Function to handle nrhs == 1 case (setting the state)
+void set_state(const mxArray *prhs[], int nlhs, mxArray *plhs[]) {
+    if (nlhs > 1) {
+        mexErrMsgIdAndTxt("mocov_line_covered:TooManyOutputs",
+                          "This function accepts only one output.");
+    }
+    debug("Setting state, original value was:");
+    debug_print_state();
+
+    // always clear the cache and start from fresh
+    init_state();
+
+    debug("... state has been initialized.");
+
+    // Set default values in case of empty input
+    mwSize n_keys = 0;
+    mwSize n_line_counts = 0;
+    size_t n_files = 0;
+
+    mxArray *keys_array = NULL;
+    mxArray *line_count_array = NULL;
+
+    // Special case: support empty input [] (the empty array)
+    bool has_empty_input =
+        (mxIsDouble(prhs[0]) && mxGetNumberOfElements(prhs[0]) == 0);
+
+    if (!has_empty_input) {
+        // The usual case: state is set using a struct with fields
+        // .keys and .line_count. This means extra checks need to be done.
+        if (!mxIsStruct(prhs[0])) {
+            raise_mex_error("InvalidInput", "Input must be a struct.");
+        }
+
+        if (mxGetNumberOfElements(prhs[0]) != 1) {
+            raise_mex_error("InvalidInput", "Input struct must have size 1x1");
+        };
+
+        keys_array = mxGetField(prhs[0], 0, "keys");
+        line_count_array = mxGetField(prhs[0], 0, "line_count");
+
+        if (keys_array == NULL || line_count_array == NULL) {
+            mexErrMsgIdAndTxt(
+                "mocov_line_covered:MissingFields",
+                "Input struct must have 'keys' and 'line_count' fields.");
+            return; // make static checker happy
+        }
+
+        // Set required space for state
+        n_keys = mxGetNumberOfElements(keys_array);
+        n_line_counts = mxGetNumberOfElements(line_count_array);
+
+        debug("n_keys=%i, n_line_counts=%i", n_keys, n_line_counts);
+
+        if (n_keys != n_line_counts) {
+            mexErrMsgIdAndTxt("mocov_line_covered:InvalidInput",
+                              "Input struct fields .keys and .line_count have "
+                              "different number of elements");
+            return; // make static checker happy
+        }
+        n_files = (size_t)n_keys;
+        debug("cache size from input: %i", n_files);
     }
 
     if (n_files == 0) {
@@ -608,11 +2760,11 @@ void set_state(const mxArray *prhs[], int nlhs, mxArray *plhs[]) {
 
         covered_file *cf = &state->files[i];
         init_covered_file(cf);
-        cf->filename = filename;
+        set_file_name((int)i, filename);
         cf->n_lines = n_lines;
         extend_covered_file(cf, n_lines);
         for (size_t j = 0; j < n_lines; j++) {
-            cf->lines[j].count = (line_count_t)double_to_int(line_count[j]);
+            cf->lines[j].count = (line_count_t)double_to_count(line_count[j]);
 #if CACHE_FILENAME_POINTERS
             cf->lines[j].filename_mx = NULL;
 #endif
@@ -647,26 +2799,165 @@ void update_state(const mxArray *prhs[], int nlhs, mxArray *plhs[]) {
     debug_print_state();
 }
 
+// Helper function to handle nrhs == 2 case (update the state for a line in a
+// registered file)
+void update_state_by_index(const mxArray *prhs[], int nlhs, mxArray *plhs[]) {
+    int idx = get_scalar_int_from_mx_double(prhs[0], "arg 1 of 2") -
+              1; // Convert to 0-base file index
+    int line_number = get_scalar_int_from_mx_double(prhs[1], "arg 2 of 2") -
+                      1; // Convert to 0-base line number
+
+    add_line_covered_by_index(idx, line_number);
+}
+
+// Helper function for the 'add' command
+void add_state(const mxArray *prhs[], int nrhs) {
+    if (nrhs != 3 && nrhs != 4) {
+        raise_mex_error("InvalidInput",
+                        "Usage: mocov_line_covered('add', idx, "
+                        "line_numbers[, counts]) or "
+                        "mocov_line_covered('add', filename, "
+                        "line_numbers[, counts])");
+    }
+
+    const mxArray *mx_line_numbers = prhs[2];
+    const mxArray *mx_counts = nrhs == 4 ? prhs[3] : NULL;
+    size_t n = mxGetNumberOfElements(mx_line_numbers);
+
+    if (!mxIsDouble(mx_line_numbers) ||
+        (mx_counts != NULL &&
+         (!mxIsDouble(mx_counts) || mxGetNumberOfElements(mx_counts) != n))) {
+        raise_mex_error("InvalidInput",
+                        "line numbers and counts must be double arrays "
+                        "with the same number of elements");
+    }
+
+    // a file is only added by name after the types of its inputs are checked
+    int idx;
+    if (mxIsChar(prhs[1])) {
+        idx = get_or_add_file_index(prhs[1]);
+    } else {
+        idx = get_scalar_int_from_mx_double(prhs[1], "arg 2 of add") - 1;
+    }
+
+    add_lines_covered_by_index(idx, mxGetPr(mx_line_numbers),
+                               mx_counts == NULL ? NULL : mxGetPr(mx_counts),
+                               n);
+}
+
+// Raise an error if a command is called with output arguments
+void check_no_outputs(int nlhs) {
+    if (nlhs > 0) {
+        raise_mex_error("TooManyOutputs",
+                        "This command does not return any output.");
+    }
+}
+
+// Helper function to handle commands, i.e. when the first input is a string
+void run_command(const mxArray *prhs[], int nrhs, int nlhs, mxArray *plhs[]) {
+    char command[GENERAL_STRING_BUFFER_LENGTH];
+    if (mxGetString(prhs[0], command, GENERAL_STRING_BUFFER_LENGTH) != 0) {
+        raise_mex_error("InvalidInput", "command name is too long");
+    }
+
+    if (strcmp(command, "register") == 0) {
+        check_no_outputs(nlhs);
+        if (nrhs < 2 || nrhs > 4) {
+            raise_mex_error("InvalidInput",
+                            "Usage: mocov_line_covered('register', keys[, "
+                            "n_lines[, hashes]])");
+        }
+        register_files(prhs[1], nrhs >= 3 ? prhs[2] : NULL,
+                       nrhs == 4 ? prhs[3] : NULL);
+    } else if (strcmp(command, "add") == 0) {
+        check_no_outputs(nlhs);
+        add_state(prhs, nrhs);
+    } else if (strcmp(command, "save") == 0 ||
+               strcmp(command, "merge") == 0) {
+        check_no_outputs(nlhs);
+        run_snapshot_command(command, prhs, nrhs);
+    } else if (strcmp(command, "granularity") == 0) {
+        check_no_outputs(nlhs);
+        run_granularity_command(prhs, nrhs);
+    } else if (strcmp(command, "set_context") == 0) {
+        check_no_outputs(nlhs);
+        run_set_context_command(prhs, nrhs);
+    } else if (strcmp(command, "get_contexts") == 0) {
+        if (nrhs != 1 || nlhs > 1) {
+            raise_mex_error("InvalidInput",
+                            "Usage: contexts=mocov_line_covered("
+                            "'get_contexts')");
+        }
+        plhs[0] = get_contexts();
+    } else if (strcmp(command, "timing") == 0) {
+        check_no_outputs(nlhs);
+        run_timing_command(prhs, nrhs);
+    } else if (strcmp(command, "boolean") == 0) {
+        check_no_outputs(nlhs);
+        run_boolean_command(prhs, nrhs);
+    } else if (strcmp(command, "get_times") == 0) {
+        if (nrhs != 1 || nlhs > 1) {
+            raise_mex_error("InvalidInput",
+                            "Usage: times=mocov_line_covered('get_times')");
+        }
+        plhs[0] = get_times();
+    } else if (strcmp(command, "get_file") == 0) {
+        if (nrhs != 2 || nlhs > 1) {
+            raise_mex_error("InvalidInput",
+                            "Usage: counts=mocov_line_covered('get_file', "
+                            "idx_or_filename)");
+        }
+        plhs[0] = get_file_counts(prhs[1]);
+    } else if (strcmp(command, "info") == 0) {
+        if (nrhs != 1 || nlhs > 1) {
+            raise_mex_error("InvalidInput",
+                            "Usage: info=mocov_line_covered('info')");
+        }
+        plhs[0] = get_info();
+    } else if (strcmp(command, "get_delta") == 0) {
+        if (nrhs != 1 || nlhs > 1) {
+            raise_mex_error("InvalidInput",
+                            "Usage: delta=mocov_line_covered('get_delta')");
+        }
+        plhs[0] = get_delta();
+    } else if (strcmp(command, "share") == 0 ||
+               strcmp(command, "unshare") == 0) {
+        check_no_outputs(nlhs);
+        run_share_command(command, prhs, nrhs);
+    } else {
+        raise_mex_error("InvalidInput", "Unknown command");
+    }
+}
+
 // The main mexFunction that calls set_state or update_state based on nrhs
 void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
     // Register the cleanup function to be called on exit
     register_cleanup();
 
-    // - first invocation:  make sure state is initialized
+    // - first invocation:  make sure state is initialized, and use shared
+    //                      counters if another process has set these up
     // - later invocations: keep (persistent) state
     if (state == NULL) {
         init_state();
+        share_counts_from_environment();
     }
 
-    if (nrhs == 3) {
-        // Most common case: update the state for a specific line in a file.
+    if (nrhs == 2 && !mxIsChar(prhs[0])) {
+        // Most common case: update the state for a line in a registered file.
+        update_state_by_index(prhs, nlhs, plhs);
+    } else if (nrhs >= 1 && mxIsChar(prhs[0])) {
+        // Commands, such as registering files
+        run_command(prhs, nrhs, nlhs, plhs);
+        return;
+    } else if (nrhs == 3) {
+        // Update the state for a specific line in a file given by name.
         update_state(prhs, nlhs, plhs);
     } else if (nrhs == 1) {
         // Set the state from a struct s with s.keys and s.line_count
         set_state(prhs, nlhs, plhs);
     } else if (nrhs != 0) {
         mexErrMsgIdAndTxt("mocov_line_covered:TooManyInputs",
-                          "This function accepts zero, one, or three inputs.");
+                          "This function accepts zero to three inputs.");
         return; // make static checker happy
     }
 
@@ -14,25 +14,319 @@ function state = mocov_line_covered(varargin)
     %      Sets the state; state must be a cell with fields .keys and
     %      .line_count
     %
-    %   3) mocov_line_covered(idx, fn, line_number, count)
+    %   3) mocov_line_covered(idx, fn, line_number)
     %
-    %      Add count times that line with line_mumber in file fn is covered.
+    %      Add once that line with line_number in file fn is covered.
     %      To avoid lookup time, it is required that in the internal state,
     %      .keys{index}==fn.
     %
+    %   4) mocov_line_covered('register', keys[, n_lines[, hashes]])
+    %
+    %      Registers the filenames in the cellstr keys, so that afterwards
+    %      .keys{k}==keys{k} for each k. Filenames that were already in the
+    %      internal state must match the registered ones. If n_lines is
+    %      provided, it must have the number of lines for each file, and
+    %      space for the line counts is allocated up front. If hashes is
+    %      provided, it must be a cellstr with the content hash of each
+    %      file (or an empty string if unknown), which is stored in
+    %      snapshots.
+    %
+    %   5) mocov_line_covered(idx, line_number)
+    %
+    %      Add once that line with line_number is covered in the file that
+    %      was registered at position idx. This avoids passing (and
+    %      comparing) the filename for every line.
+    %
+    %   6) mocov_line_covered('add', idx, line_numbers[, counts])
+    %
+    %      Add counts(k) times that line line_numbers(k) is covered in the
+    %      file that was registered at position idx, for each k. If counts
+    %      is omitted, each element in line_numbers is counted once.
+    %
+    %      mocov_line_covered('add', fn, line_numbers[, counts])
+    %
+    %      As above, but for the file with name fn, which is added to the
+    %      state if it is not there yet. The file is looked up only once
+    %      for all lines.
+    %
+    %   7) mocov_line_covered('save', fn)
+    %
+    %      Writes the state to the binary snapshot file fn.
+    %
+    %   8) mocov_line_covered('merge', fn)
+    %
+    %      Adds the line counts in the binary snapshot file fn to the
+    %      state, matching files by name. An error is raised, without
+    %      changing the state, if a file has a different content hash in
+    %      the snapshot than in the state, or if the snapshot has a
+    %      different granularity (see usage 19).
+    %
+    %   9) mocov_line_covered('set_context', name)
+    %
+    %      Sets the active context (such as the name of a test) to name;
+    %      afterwards each covered line is also marked as hit by that
+    %      context, until another context is set. If name is empty, no
+    %      context is active. Setting a context that was used before
+    %      continues it.
+    %
+    %   10) contexts=mocov_line_covered('get_contexts')
+    %
+    %      Returns a struct with fields:
+    %       .names          Cx1 cell with the name of each context
+    %       .keys           Nx1 cell with filenames, as in the state
+    %       .ranges         Mx4 array, where each row
+    %                       [context, file, first_line, last_line]
+    %                       indicates that lines first_line to last_line
+    %                       of the file were hit by the context
+    %
+    %   11) mocov_line_covered('timing', is_timing)
+    %
+    %      If is_timing is true, starts recording for each covered line
+    %      the time since the previous covered line, which is added to the
+    %      time of the previous line. If false, stops recording; the time
+    %      since the last covered line is not attributed to any line.
+    %      Setting a context also starts a new interval.
+    %
+    %   12) times=mocov_line_covered('get_times')
+    %
+    %      Returns an Nx1 cell with, for each file, the time in seconds
+    %      spent on each line (as .line_count in the state).
+    %
+    %   13) mocov_line_covered('boolean', is_boolean)
+    %
+    %      If is_boolean is true, only records whether lines were hit:
+    %      afterwards, a covered line with a count of zero gets a count of
+    %      one, and lines with a non-zero count are left unchanged (also
+    %      for counts added with 'add'). If false, lines are counted again.
+    %
+    %   14) mocov_line_covered('share', fn)
+    %   15) mocov_line_covered('unshare')
+    %
+    %      Stores the line counts in file fn, shared with other processes
+    %      that record coverage into the same file, or stops doing so.
+    %      Only supported by the compiled mex file (see
+    %      mocov_line_covered.c); this function raises an error.
+    %
+    %   16) counts=mocov_line_covered('get_file', idx_or_fn)
+    %
+    %      Returns the line counts of the file at position idx, or with
+    %      name fn, as .line_count{idx} in the state, without returning
+    %      the counts of all other files.
+    %
+    %   17) delta=mocov_line_covered('get_delta')
+    %
+    %      Returns an Mx3 array, where each row [file, line, delta]
+    %      indicates that the count of the line in the file at position
+    %      file increased by delta since the previous call. The first
+    %      call (and the first after setting the state) returns all lines
+    %      with a non-zero count.
+    %
+    %   18) info=mocov_line_covered('info')
+    %
+    %      Returns a struct with fields .line_count_bits and
+    %      .bytes_per_line (the size of a single line count), .n_files,
+    %      .n_lines (the number of lines with space for a count) and
+    %      .line_bytes (the memory used for these counts, in bytes). This
+    %      function stores counts as doubles, which count exactly up to
+    %      2^53; the compiled mex file can use other widths (see
+    %      mocov_line_covered.c).
+    %
+    %   19) mocov_line_covered('granularity', granularity)
+    %
+    %      Sets the granularity with which lines are recorded, such as
+    %      'line' or 'block', which is stored in snapshots. Snapshots with
+    %      a different granularity cannot be merged. If empty (as after
+    %      setting the state), the granularity is unknown, and the state
+    %      takes that of the first merged snapshot that has one.
+    %
     % Notes:
     %   - this function is used to keep track of which files have been executed
     %     across a set of .m files.
+    %   - the format of snapshot files is described in mocov_line_covered.c
+    %     and mocov_snapshot_save.m.
+    %   - contexts and times are not stored in snapshots, and are removed
+    %     (as are the counts at the previous 'get_delta') when the state is
+    %     set. Setting the state also stops timing and
+    %     boolean mode, and makes the granularity unknown.
     %
     % NNO May 2014
 
     persistent cached_keys
     persistent cached_line_count
+    persistent cached_hashes
+    persistent key_index
+    persistent context_names
+    persistent context_index
+    persistent context_runs
+    persistent active_context
+    persistent active_hits
+    persistent timing
+    persistent is_boolean
+    persistent granularity
+    persistent checkpoint
 
     % initialize persistent variables, if necessary
     if isnumeric(cached_keys)
         cached_keys = cell(0);
         cached_line_count = cell(0);
+        cached_hashes = cell(0);
+        key_index = [];
+        [context_names, context_index, context_runs, active_context, ...
+                                            active_hits] = init_contexts();
+        timing = init_timing();
+        is_boolean = false;
+        granularity = '';
+        checkpoint = cell(0);
+    end
+
+    if nargin >= 1 && ischar(varargin{1})
+        % run a command
+        command = varargin{1};
+        switch command
+            case 'register'
+                if nargin < 2 || nargin > 4
+                    error(['Usage: mocov_line_covered(''register'', '...
+                           'keys[, n_lines[, hashes]])']);
+                end
+                [cached_keys, cached_line_count, cached_hashes] = ...
+                                        register_keys(cached_keys, ...
+                                                      cached_line_count, ...
+                                                      cached_hashes, ...
+                                                      varargin{2:end});
+                key_index = [];
+
+            case 'add'
+                if nargin ~= 3 && nargin ~= 4
+                    error(['Usage: mocov_line_covered(''add'', '...
+                           'idx_or_fn, line_numbers[, counts])']);
+                end
+                index = varargin{2};
+                if ischar(index)
+                    [cached_keys, cached_line_count, key_index, index] = ...
+                                        get_or_add_key(cached_keys, ...
+                                                       cached_line_count, ...
+                                                       key_index, index);
+                end
+                cached_line_count = add_counts(cached_keys, ...
+                                               cached_line_count, ...
+                                               is_boolean, ...
+                                               index, varargin{3:end});
+                if active_context > 0
+                    active_hits = mark_added_hits(active_hits, index, ...
+                                                  varargin{3:end});
+                end
+
+            case 'save'
+                if nargin ~= 2 || ~ischar(varargin{2})
+                    error('Usage: mocov_line_covered(''save'', fn)');
+                end
+                save_snapshot(varargin{2}, cached_keys, ...
+                              cached_line_count, cached_hashes, ...
+                              granularity);
+
+            case 'merge'
+                if nargin ~= 2 || ~ischar(varargin{2})
+                    error('Usage: mocov_line_covered(''merge'', fn)');
+                end
+                [cached_keys, cached_line_count, cached_hashes, ...
+                        granularity] = merge_snapshot(varargin{2}, ...
+                                                      cached_keys, ...
+                                                      cached_line_count, ...
+                                                      cached_hashes, ...
+                                                      granularity);
+                key_index = [];
+
+            case 'granularity'
+                if nargin ~= 2 || ~(ischar(varargin{2}) || ...
+                                    isempty(varargin{2}))
+                    error(['Usage: mocov_line_covered(''granularity'', '...
+                           'granularity)']);
+                end
+                granularity = char(varargin{2});
+
+            case 'set_context'
+                if nargin ~= 2 || ~(ischar(varargin{2}) || ...
+                                    isempty(varargin{2}))
+                    error('Usage: mocov_line_covered(''set_context'', name)');
+                end
+                [context_names, context_runs, active_context, ...
+                        active_hits] = set_context(varargin{2}, ...
+                                                   context_names, ...
+                                                   context_index, ...
+                                                   context_runs, ...
+                                                   active_context, ...
+                                                   active_hits);
+
+                % time between contexts is not attributed to any line
+                timing.last_index = 0;
+
+            case 'get_contexts'
+                if nargin ~= 1
+                    error(['Usage: contexts=mocov_line_covered('...
+                           '''get_contexts'')']);
+                end
+                state = get_contexts(cached_keys, context_names, ...
+                                     context_runs, active_context, ...
+                                     active_hits);
+                return
+
+            case 'timing'
+                if nargin ~= 2 || numel(varargin{2}) ~= 1
+                    error(['Usage: mocov_line_covered(''timing'', '...
+                           'true|false)']);
+                end
+                timing.is_enabled = logical(varargin{2});
+                timing.last_index = 0;
+
+            case 'boolean'
+                if nargin ~= 2 || numel(varargin{2}) ~= 1
+                    error(['Usage: mocov_line_covered(''boolean'', '...
+                           'true|false)']);
+                end
+                is_boolean = logical(varargin{2});
+
+            case {'share', 'unshare'}
+                error('mocov_line_covered:SharedCountersNotSupported', ...
+                      ['Shared counters require compiling '...
+                       'mocov_line_covered.c with mex']);
+
+            case 'get_times'
+                if nargin ~= 1
+                    error('Usage: times=mocov_line_covered(''get_times'')');
+                end
+                state = get_times(cached_line_count, timing);
+                return
+
+            case 'get_file'
+                if nargin ~= 2
+                    error(['Usage: counts=mocov_line_covered('...
+                           '''get_file'', idx_or_fn)']);
+                end
+                state = get_file_counts(cached_keys, cached_line_count, ...
+                                        varargin{2});
+                return
+
+            case 'info'
+                if nargin ~= 1
+                    error('Usage: info=mocov_line_covered(''info'')');
+                end
+                state = get_info(cached_line_count);
+                return
+
+            case 'get_delta'
+                if nargin ~= 1
+                    error('Usage: delta=mocov_line_covered(''get_delta'')');
+                end
+                [state, checkpoint] = get_delta(cached_line_count, ...
+                                                checkpoint);
+                return
+
+            otherwise
+                error('illegal command ''%s''', command);
+        end
+
+        state = [];
+        return
     end
 
     switch nargin
@@ -54,6 +348,14 @@ function state = mocov_line_covered(varargin)
 
             cached_keys = state.keys;
             cached_line_count = state.line_count;
+            cached_hashes = cell(0);
+            key_index = [];
+            [context_names, context_index, context_runs, active_context, ...
+                                            active_hits] = init_contexts();
+            timing = init_timing();
+            is_boolean = false;
+            granularity = '';
+            checkpoint = cell(0);
             return
 
         case 3
@@ -71,6 +373,26 @@ function state = mocov_line_covered(varargin)
 
             state = [];
 
+        case 2
+            % add a line covered in a registered file
+            index = varargin{1};
+            line = varargin{2};
+            count = 1;
+
+            if ~isnumeric(index) || ~isnumeric(line) || ...
+                    numel(index) ~= 1 || round(index) ~= index || ...
+                    numel(line) ~= 1 || round(line) ~= line || line < 1
+                error('illegal argument');
+            end
+
+            if index < 1 || numel(cached_keys) < index || ...
+                    isempty(cached_keys{index})
+                error('File index %d was not registered', index);
+            end
+
+            key = cached_keys{index};
+            state = [];
+
         otherwise
             error('illegal input');
     end
@@ -84,6 +406,7 @@ function state = mocov_line_covered(varargin)
     if cached_keys_too_small || isempty(cached_keys{index})
         cached_keys{index} = key;
         cached_line_count{index} = zeros(10, 1);
+        key_index = [];
     elseif ~isequal(cached_keys{index}, key)
         error('Key mismatch, %s ~= %s', cached_keys{index}, key);
     end
@@ -91,4 +414,467 @@ function state = mocov_line_covered(varargin)
     if numel(cached_line_count{index}) < line
         cached_line_count{index}(2 * line) = 0;
     end
-    cached_line_count{index}(line) = cached_line_count{index}(line) + count;
+    if ~is_boolean
+        cached_line_count{index}(line) = cached_line_count{index}(line) + ...
+                                         count;
+    elseif cached_line_count{index}(line) == 0
+        cached_line_count{index}(line) = 1;
+    end
+
+    if active_context > 0
+        active_hits = mark_hits(active_hits, index, line);
+    end
+
+    if timing.is_enabled
+        timing = record_time(timing, index, line);
+    end
+
+function [keys, line_count, hashes] = register_keys(keys, line_count, ...
+                                                     hashes, new_keys, ...
+                                                     n_lines, new_hashes)
+    if ~iscellstr(new_keys)
+        error('keys must be a cell with strings');
+    end
+
+    n = numel(new_keys);
+    if nargin < 5
+        n_lines = zeros(n, 1);
+    elseif ~isnumeric(n_lines) || numel(n_lines) ~= n
+        error('n_lines must be numeric with one element for each key');
+    end
+
+    if nargin < 6
+        new_hashes = cell(n, 1);
+    elseif ~iscellstr(new_hashes) || numel(new_hashes) ~= n
+        error('hashes must be a cellstr with one element for each key');
+    end
+
+    if numel(keys) < n
+        keys{n} = [];
+        line_count{n} = [];
+    end
+
+    for k = 1:n
+        key = new_keys{k};
+        if isempty(keys{k})
+            keys{k} = key;
+            line_count{k} = zeros(10, 1);
+        elseif ~isequal(keys{k}, key)
+            error('Key mismatch, %s ~= %s', keys{k}, key);
+        end
+
+        if numel(line_count{k}) < n_lines(k)
+            line_count{k}(n_lines(k), 1) = 0;
+        end
+
+        new_hash = new_hashes{k};
+        if ~isempty(new_hash)
+            hash = get_hash(hashes, k);
+            if isempty(hash)
+                hashes{k} = new_hash;
+            elseif ~isequal(hash, new_hash)
+                error('Content hash mismatch for %s', key);
+            end
+        end
+    end
+
+function hash = get_hash(hashes, index)
+    % hashes has no elements for files registered without content hash
+    hash = '';
+    if index <= numel(hashes) && ~isempty(hashes{index})
+        hash = hashes{index};
+    end
+
+function save_snapshot(fn, keys, line_count, hashes, granularity)
+    n = numel(keys);
+    parts = cell(n, 1);
+    for k = 1:n
+        file_count = line_count{k}(:);
+        lines = find(file_count > 0);
+        counts = file_count(lines);
+        deltas = diff([0; lines]);
+
+        % interleave line deltas and counts
+        values = [deltas'; counts'];
+        parts{k} = [encode_string(keys{k}); ...
+                    encode_string(get_hash(hashes, k)); ...
+                    encode_varints(numel(lines)); ...
+                    encode_varints(values(:))];
+    end
+
+    header = [uint8('MOCOVSNP')'; encode_varints(2); ...
+              encode_string(granularity); encode_varints(n)];
+
+    fid = fopen(fn, 'w');
+    if fid == -1
+        error('Unable to open snapshot %s for writing', fn);
+    end
+    cleaner = onCleanup(@()fclose(fid));
+    fwrite(fid, vertcat(header, parts{:}), 'uint8');
+
+function bytes = encode_string(s)
+    bytes = [encode_varints(numel(s)); uint8(s(:))];
+
+function bytes = encode_varints(values)
+    % unsigned LEB128: 7 bits per byte, least significant byte first
+    values = double(values(:));
+
+    n_bytes = ones(size(values));
+    remainder = floor(values / 128);
+    while any(remainder > 0)
+        n_bytes = n_bytes + (remainder > 0);
+        remainder = floor(remainder / 128);
+    end
+    offsets = cumsum([0; n_bytes(1:(end - 1))]);
+
+    bytes = zeros(sum(n_bytes), 1, 'uint8');
+    for b = 1:max([0; n_bytes])
+        msk = n_bytes >= b;
+        group = mod(floor(values(msk) / 2^(7 * (b - 1))), 128);
+        has_more = n_bytes(msk) > b;
+        bytes(offsets(msk) + b) = group + 128 * has_more;
+    end
+
+function [keys, line_count, hashes, granularity] = merge_snapshot(fn, ...
+                                        keys, line_count, hashes, granularity)
+    snapshot = mocov_snapshot_load(fn);
+    key_index = get_key_index(keys);
+
+    % block counts are only recorded for the first line of each block, so
+    % they cannot be added to line counts
+    if ~isempty(snapshot.granularity)
+        if isempty(granularity)
+            granularity = snapshot.granularity;
+        elseif ~isequal(granularity, snapshot.granularity)
+            error('Granularity mismatch, %s ~= %s', granularity, ...
+                  snapshot.granularity);
+        end
+    end
+
+    % check all hashes first, so that the state is not changed if any of
+    % them does not match
+    n = numel(snapshot.keys);
+    for k = 1:n
+        key = snapshot.keys{k};
+        index = find_key(key_index, key);
+        if ~isempty(index)
+            hash = get_hash(hashes, index);
+            if ~isempty(hash) && ~isempty(snapshot.hashes{k}) && ...
+                    ~isequal(hash, snapshot.hashes{k})
+                error('Content hash mismatch for %s', key);
+            end
+        end
+    end
+
+    for k = 1:n
+        key = snapshot.keys{k};
+        if isempty(key)
+            % a file without name has no counts that can be merged
+            continue;
+        end
+
+        index = find_key(key_index, key);
+        if isempty(index)
+            % use the same position as in the snapshot if it is not taken
+            if k > numel(keys) || isempty(keys{k})
+                index = k;
+            else
+                index = numel(keys) + 1;
+            end
+            keys{index} = key;
+            line_count{index} = zeros(0, 1);
+            key_index(key) = index;
+        end
+
+        if isempty(get_hash(hashes, index)) && ~isempty(snapshot.hashes{k})
+            hashes{index} = snapshot.hashes{k};
+        end
+
+        counts = snapshot.line_count{k};
+        file_count = line_count{index}(:);
+        n_lines = numel(counts);
+        if numel(file_count) < n_lines
+            file_count(n_lines, 1) = 0;
+        end
+        file_count(1:n_lines) = file_count(1:n_lines) + counts;
+        line_count{index} = file_count;
+    end
+
+    % keep keys and line counts as column vectors, as in the state
+    keys = keys(:);
+    line_count = line_count(:);
+
+function key_index = get_key_index(keys)
+    % map from filenames to their position, so that files in a snapshot
+    % or added by name are found without comparing with all keys
+    key_index = containers.Map('KeyType', 'char', 'ValueType', 'double');
+    for k = numel(keys):-1:1
+        % the first position is used for keys that occur more than once
+        if ~isempty(keys{k})
+            key_index(keys{k}) = k;
+        end
+    end
+
+function index = find_key(key_index, key)
+    index = [];
+    if ~isempty(key) && isKey(key_index, key)
+        index = key_index(key);
+    end
+
+function [keys, line_count, key_index, index] = get_or_add_key(keys, ...
+                                                line_count, key_index, key)
+    % key_index is empty (rather than a containers.Map) after the keys were
+    % changed otherwise; it is then built again on the first lookup
+    if isnumeric(key_index)
+        key_index = get_key_index(keys);
+    end
+
+    index = find_key(key_index, key);
+    if isempty(index)
+        index = numel(keys) + 1;
+        keys{index} = key;
+        line_count{index} = zeros(0, 1);
+        if ~isempty(key)
+            key_index(key) = index;
+        end
+    end
+
+function line_count = add_counts(keys, line_count, is_boolean, index, ...
+                                lines, counts)
+    if nargin < 6
+        counts = ones(size(lines));
+    end
+
+    if ~isnumeric(index) || numel(index) ~= 1 || round(index) ~= index || ...
+            ~isnumeric(lines) || ~isnumeric(counts) || ...
+            numel(lines) ~= numel(counts) || ...
+            any(round(lines(:)) ~= lines(:)) || any(lines(:) < 1)
+        error('illegal argument');
+    end
+
+    if index < 1 || numel(keys) < index || isempty(keys{index})
+        error('File index %d was not registered', index);
+    end
+
+    if isempty(lines)
+        return
+    end
+
+    file_count = line_count{index}(:);
+    max_line = max(lines(:));
+    if numel(file_count) < max_line
+        file_count(max_line, 1) = 0;
+    end
+
+    % accumarray also sums counts of line numbers that occur more than once
+    added = accumarray(lines(:), counts(:), [max_line, 1]);
+    if is_boolean
+        file_count(1:max_line) = max(file_count(1:max_line), added > 0);
+    else
+        file_count(1:max_line) = file_count(1:max_line) + added;
+    end
+    line_count{index} = file_count;
+
+function [names, name_index, runs, active_context, active_hits] = ...
+                                                            init_contexts()
+    names = cell(0, 1);
+    % map from names to their position, so that setting a context does not
+    % compare its name with all names; being a handle object, it is
+    % changed in place by set_context
+    name_index = containers.Map('KeyType', 'char', 'ValueType', 'double');
+    runs = cell(0, 1);
+    active_context = 0;
+    active_hits = cell(0);
+
+function hits = mark_hits(hits, index, lines)
+    % hits{index} is a logical column with the lines hit by the active
+    % context in the file at position index
+    if numel(hits) < index
+        hits{index} = false(0, 1);
+    end
+
+    file_hits = hits{index};
+    max_line = max(lines(:));
+    if numel(file_hits) < max_line
+        file_hits(max_line, 1) = false;
+    end
+    file_hits(lines) = true;
+    hits{index} = file_hits;
+
+function hits = mark_added_hits(hits, index, lines, counts)
+    if nargin >= 4
+        lines = lines(counts > 0);
+    end
+    if ~isempty(lines)
+        hits = mark_hits(hits, index, lines(:));
+    end
+
+function runs = compress_hits(hits)
+    % runs of consecutive hit lines, as rows [file, first_line, last_line]
+    n = numel(hits);
+    file_runs = cell(n, 1);
+    for k = 1:n
+        file_hits = logical(hits{k}(:));
+        if ~any(file_hits)
+            continue
+        end
+
+        changes = diff([false; file_hits; false]);
+        first_lines = find(changes == 1);
+        last_lines = find(changes == -1) - 1;
+        file_runs{k} = [repmat(k, numel(first_lines), 1), ...
+                        first_lines, last_lines];
+    end
+    runs = vertcat(zeros(0, 3), file_runs{:});
+
+function hits = expand_runs(runs)
+    hits = cell(0);
+    for r = 1:size(runs, 1)
+        hits = mark_hits(hits, runs(r, 1), (runs(r, 2):runs(r, 3))');
+    end
+
+function [names, runs, active_context, active_hits] = set_context(name, ...
+                                                names, name_index, runs, ...
+                                                active_context, active_hits)
+    if active_context > 0
+        runs{active_context} = compress_hits(active_hits);
+    end
+    active_context = 0;
+    active_hits = cell(0);
+
+    if isempty(name)
+        return
+    end
+
+    if isKey(name_index, name)
+        active_context = name_index(name);
+    else
+        names{end + 1, 1} = name;
+        runs{end + 1, 1} = zeros(0, 3);
+        active_context = numel(names);
+        name_index(name) = active_context;
+    end
+
+    % continue a context that was used before
+    active_hits = expand_runs(runs{active_context});
+    runs{active_context} = zeros(0, 3);
+
+function contexts = get_contexts(keys, names, runs, active_context, ...
+                                 active_hits)
+    if active_context > 0
+        runs{active_context} = compress_hits(active_hits);
+    end
+
+    n = numel(names);
+    ranges = cell(n, 1);
+    for c = 1:n
+        ranges{c} = [repmat(c, size(runs{c}, 1), 1), runs{c}];
+    end
+
+    % files that were not registered have an empty name
+    keys = keys(:);
+    keys(cellfun(@isempty, keys)) = {''};
+
+    contexts = struct();
+    contexts.names = names;
+    contexts.keys = keys;
+    contexts.ranges = vertcat(zeros(0, 4), ranges{:});
+
+function timing = init_timing()
+    timing = struct();
+    timing.is_enabled = false;
+    timing.clock_id = tic();
+    timing.times = cell(0);
+    timing.last_index = 0;
+    timing.last_line = 0;
+    timing.last_clock = 0;
+
+function timing = record_time(timing, index, line)
+    % attribute the time since the previous line to that line
+    elapsed = toc(timing.clock_id);
+    last_index = timing.last_index;
+    if last_index > 0
+        if numel(timing.times) < last_index
+            timing.times{last_index} = [];
+        end
+
+        file_times = timing.times{last_index};
+        last_line = timing.last_line;
+        if numel(file_times) < last_line
+            file_times(last_line, 1) = 0;
+        end
+        file_times(last_line) = file_times(last_line) + ...
+                                elapsed - timing.last_clock;
+        timing.times{last_index} = file_times;
+    end
+
+    timing.last_index = index;
+    timing.last_line = line;
+
+    % the time spent above is not attributed to the line
+    timing.last_clock = toc(timing.clock_id);
+
+function times = get_times(line_count, timing)
+    % times have the same size as the line counts
+    n = numel(line_count);
+    times = cell(n, 1);
+    for k = 1:n
+        file_times = zeros(numel(line_count{k}), 1);
+        if k <= numel(timing.times)
+            n_lines = min(numel(timing.times{k}), numel(file_times));
+            file_times(1:n_lines) = timing.times{k}(1:n_lines);
+        end
+        times{k} = file_times;
+    end
+
+function counts = get_file_counts(keys, line_count, index)
+    if ischar(index)
+        key = index;
+        index = find(strcmp(keys, key), 1);
+        if isempty(index)
+            error('File %s is not in the state', key);
+        end
+    elseif ~isnumeric(index) || numel(index) ~= 1 || ...
+            round(index) ~= index || index < 1 || index > numel(keys)
+        error('File index is out of range');
+    end
+
+    counts = line_count{index}(:);
+
+function [delta, checkpoint] = get_delta(line_count, checkpoint)
+    % checkpoint{k} has the counts of file k at the previous call
+    n = numel(line_count);
+    if numel(checkpoint) < n
+        checkpoint{n} = [];
+    end
+
+    file_deltas = cell(n, 1);
+    for k = 1:n
+        counts = line_count{k}(:);
+        n_lines = numel(counts);
+
+        previous = checkpoint{k}(:);
+        if numel(previous) < n_lines
+            previous(n_lines, 1) = 0;
+        end
+
+        changed = find(counts ~= previous(1:n_lines));
+        if isempty(changed)
+            continue
+        end
+
+        file_deltas{k} = [repmat(k, numel(changed), 1), changed, ...
+                          counts(changed) - previous(changed)];
+        checkpoint{k} = counts;
+    end
+    delta = vertcat(zeros(0, 3), file_deltas{:});
+
+function info = get_info(line_count)
+    n_lines = sum(cellfun(@numel, line_count));
+
+    info = struct();
+    info.line_count_bits = 64;
+    info.bytes_per_line = 8;
+    info.n_files = numel(line_count);
+    info.n_lines = n_lines;
+    info.line_bytes = 8 * n_lines;
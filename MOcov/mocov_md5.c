@@ -0,0 +1,227 @@
+// C implementation of mocov_md5.m
+//
+// The C code below computes the md5 checksum of a byte array, so that
+// MOcovMFile can compute the checksum of the contents of an m-file it has
+// already read into memory, without starting a separate process (such as
+// 'md5sum') for every file. To use it, it needs compiling using 'mex' in
+// Octave or Matlab.
+//
+// Usage:
+//     md5 = mocov_md5(data)
+// where data is a uint8 array or a char array with only characters with
+// a code below 256 (each character is used as a single byte). The output
+// is a 1x32 char array with the checksum in lower-case hexadecimal
+// notation, equal to the output of the 'md5sum' command line tool for a
+// file with the same contents.
+//
+// The implementation follows RFC 1321.
+
+#include "mex.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+    uint32_t state[4];
+    uint64_t n_bytes;        // total number of bytes processed
+    unsigned char block[64]; // bytes not yet processed
+    size_t n_block;          // number of bytes in block
+} md5_context;
+
+// Shift amounts for each of the 64 steps
+static const unsigned int SHIFTS[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5, 9,  14, 20, 5, 9,  14, 20, 5, 9,  14, 20, 5, 9,  14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21};
+
+// Integer part of abs(sin(i+1))*2^32 for each of the 64 steps
+static const uint32_t SINES[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+    0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+    0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+    0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+    0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+    0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+
+static uint32_t rotate_left(uint32_t x, unsigned int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static void md5_init(md5_context *ctx) {
+    ctx->state[0] = 0x67452301;
+    ctx->state[1] = 0xefcdab89;
+    ctx->state[2] = 0x98badcfe;
+    ctx->state[3] = 0x10325476;
+    ctx->n_bytes = 0;
+    ctx->n_block = 0;
+}
+
+static void md5_process_block(md5_context *ctx, const unsigned char *block) {
+    // words are stored little-endian, independent of the platform
+    uint32_t m[16];
+    for (int i = 0; i < 16; i++) {
+        m[i] = (uint32_t)block[4 * i] | ((uint32_t)block[4 * i + 1] << 8) |
+               ((uint32_t)block[4 * i + 2] << 16) |
+               ((uint32_t)block[4 * i + 3] << 24);
+    }
+
+    uint32_t a = ctx->state[0];
+    uint32_t b = ctx->state[1];
+    uint32_t c = ctx->state[2];
+    uint32_t d = ctx->state[3];
+
+    for (int i = 0; i < 64; i++) {
+        uint32_t f;
+        int g;
+        if (i < 16) {
+            f = (b & c) | (~b & d);
+            g = i;
+        } else if (i < 32) {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) % 16;
+        } else if (i < 48) {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) % 16;
+        } else {
+            f = c ^ (b | ~d);
+            g = (7 * i) % 16;
+        }
+
+        uint32_t tmp = d;
+        d = c;
+        c = b;
+        b = b + rotate_left(a + f + SINES[i] + m[g], SHIFTS[i]);
+        a = tmp;
+    }
+
+    ctx->state[0] += a;
+    ctx->state[1] += b;
+    ctx->state[2] += c;
+    ctx->state[3] += d;
+}
+
+static void md5_update(md5_context *ctx, const unsigned char *data,
+                       size_t n) {
+    ctx->n_bytes += n;
+
+    // complete a partially filled block first
+    if (ctx->n_block > 0) {
+        size_t n_copy = 64 - ctx->n_block;
+        if (n_copy > n) {
+            n_copy = n;
+        }
+        memcpy(ctx->block + ctx->n_block, data, n_copy);
+        ctx->n_block += n_copy;
+        data += n_copy;
+        n -= n_copy;
+
+        if (ctx->n_block < 64) {
+            return;
+        }
+        md5_process_block(ctx, ctx->block);
+        ctx->n_block = 0;
+    }
+
+    // full blocks are processed without copying
+    while (n >= 64) {
+        md5_process_block(ctx, data);
+        data += 64;
+        n -= 64;
+    }
+
+    memcpy(ctx->block, data, n);
+    ctx->n_block = n;
+}
+
+static void md5_final(md5_context *ctx, unsigned char *digest) {
+    uint64_t n_bits = ctx->n_bytes * 8;
+
+    // padding is a single 1 bit, followed by zeros up to 56 bytes in the
+    // last block, followed by the number of bits as a little-endian
+    // 64 bit integer
+    unsigned char padding[72] = {0x80};
+    size_t n_padding = ctx->n_block < 56 ? 56 - ctx->n_block
+                                         : 120 - ctx->n_block;
+    for (int i = 0; i < 8; i++) {
+        padding[n_padding + i] = (unsigned char)(n_bits >> (8 * i));
+    }
+    md5_update(ctx, padding, n_padding + 8);
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            digest[4 * i + j] = (unsigned char)(ctx->state[i] >> (8 * j));
+        }
+    }
+}
+
+// Process the characters of a char array in chunks, as each mxChar must
+// be converted to a byte first
+static void md5_update_chars(md5_context *ctx, const mxChar *chars,
+                             size_t n) {
+    unsigned char buffer[4096];
+
+    size_t i = 0;
+    while (i < n) {
+        size_t n_buffer = 0;
+        while (i < n && n_buffer < sizeof(buffer)) {
+            if (chars[i] > 255) {
+                mexErrMsgIdAndTxt("mocov_md5:InvalidInput",
+                                  "Character at position %d has code %d, "
+                                  "only codes below 256 are supported",
+                                  (int)(i + 1), (int)chars[i]);
+            }
+            buffer[n_buffer++] = (unsigned char)chars[i++];
+        }
+        md5_update(ctx, buffer, n_buffer);
+    }
+}
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs,
+                 const mxArray *prhs[]) {
+    if (nrhs != 1 ||
+        !(mxIsUint8(prhs[0]) || mxIsChar(prhs[0]) || mxIsEmpty(prhs[0]))) {
+        mexErrMsgIdAndTxt("mocov_md5:InvalidInput",
+                          "Usage: mocov_md5(data), with data a uint8 or "
+                          "char array");
+    }
+
+    if (nlhs > 1) {
+        mexErrMsgIdAndTxt("mocov_md5:InvalidOutput",
+                          "This function returns at most one output");
+    }
+
+    size_t n = mxGetNumberOfElements(prhs[0]);
+
+    md5_context ctx;
+    md5_init(&ctx);
+    if (n > 0) {
+        if (mxIsUint8(prhs[0])) {
+            md5_update(&ctx, (const unsigned char *)mxGetData(prhs[0]), n);
+        } else if (mxIsChar(prhs[0])) {
+            md5_update_chars(&ctx, mxGetChars(prhs[0]), n);
+        } else {
+            mexErrMsgIdAndTxt("mocov_md5:InvalidInput",
+                              "Usage: mocov_md5(data), with data a uint8 "
+                              "or char array");
+        }
+    }
+
+    unsigned char digest[16];
+    md5_final(&ctx, digest);
+
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    char md5[33];
+    for (int i = 0; i < 16; i++) {
+        md5[2 * i] = HEX_DIGITS[digest[i] >> 4];
+        md5[2 * i + 1] = HEX_DIGITS[digest[i] & 0x0f];
+    }
+    md5[32] = '\0';
+
+    plhs[0] = mxCreateString(md5);
+}
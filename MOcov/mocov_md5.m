@@ -0,0 +1,120 @@
+function md5 = mocov_md5(data)
+    % compute the md5 checksum of a byte array
+    %
+    % md5=mocov_md5(data)
+    %
+    % Input:
+    %   data                uint8 array, or char array with only characters
+    %                       with a code below 256 (each character is used as
+    %                       a single byte)
+    %
+    % Output:
+    %   md5                 1x32 char array with the md5 checksum of data in
+    %                       lower-case hexadecimal notation, equal to the
+    %                       output of 'md5sum' for a file with contents data
+    %
+    % Notes:
+    %   - a faster implementation is provided in mocov_md5.c, which requires
+    %     compilation with mex. Without it, the builtin 'hash' function is
+    %     used if available (GNU Octave >= 4.4), then Java's MessageDigest
+    %     if Java is available (Matlab), and the checksum is computed in
+    %     this function otherwise, which is slow for large inputs. In no
+    %     case is a separate process started.
+    %
+    % See also: mocov_util_md5
+
+    if ~(isa(data, 'uint8') || ischar(data) || isempty(data))
+        error('Usage: mocov_md5(data), with data a uint8 or char array');
+    end
+
+    bytes = double(data(:));
+    if any(bytes > 255)
+        error('Only characters with a code below 256 are supported');
+    end
+
+    if exist('hash', 'builtin')
+        md5 = hash('md5', char(bytes'));
+    elseif usejava('jvm')
+        md5 = md5_from_java(bytes);
+    else
+        md5 = md5_from_bytes(bytes);
+    end
+
+function md5 = md5_from_java(bytes)
+    digest = java.security.MessageDigest.getInstance('MD5');
+    if ~isempty(bytes)
+        % Java bytes are signed
+        digest.update(typecast(uint8(bytes), 'int8'));
+    end
+    result = typecast(int8(digest.digest()), 'uint8');
+    md5 = lower(reshape(dec2hex(result(:), 2)', 1, 32));
+
+function md5 = md5_from_bytes(bytes)
+    % all arithmetic is on doubles with integer values below 2^32, which
+    % are represented exactly
+    shifts = repmat([7 12 17 22; 5 9 14 20; 4 11 16 23; 6 10 15 21], ...
+                    1, 4);
+    shifts = reshape(shifts', 1, 64);
+    sines = floor(abs(sin(1:64)) * 2^32);
+
+    % index (base 1) of the message word used in each step
+    steps = 0:63;
+    word_idx = [steps(1:16), ...
+                mod(5 * steps(17:32) + 1, 16), ...
+                mod(3 * steps(33:48) + 5, 16), ...
+                mod(7 * steps(49:64), 16)] + 1;
+
+    % padding is a single 1 bit, followed by zeros up to 56 bytes in the
+    % last block, followed by the number of bits as a little-endian 64 bit
+    % integer
+    n_bytes = numel(bytes);
+    n_zeros = mod(55 - n_bytes, 64);
+    n_bits = n_bytes * 8;
+    length_bytes = mod(floor(n_bits ./ 2 .^ (8 * (0:7)')), 256);
+    padded = [bytes; 128; zeros(n_zeros, 1); length_bytes];
+
+    % words are stored little-endian; one column per block
+    n_blocks = numel(padded) / 64;
+    words = reshape(padded, 4, 16 * n_blocks)' * 2 .^ [0; 8; 16; 24];
+    words = reshape(words, 16, n_blocks);
+
+    state = [1732584193 4023233417 2562383102 271733878];
+    for block = 1:n_blocks
+        m = words(:, block);
+        a = state(1);
+        b = state(2);
+        c = state(3);
+        d = state(4);
+
+        for i = 1:64
+            if i <= 16
+                f = bitor(bitand(b, c), bitand(bit_not(b), d));
+            elseif i <= 32
+                f = bitor(bitand(d, b), bitand(bit_not(d), c));
+            elseif i <= 48
+                f = bitxor(bitxor(b, c), d);
+            else
+                f = bitxor(c, bitor(b, bit_not(d)));
+            end
+
+            tmp = d;
+            d = c;
+            c = b;
+            x = mod(a + f + sines(i) + m(word_idx(i)), 2^32);
+            b = mod(b + rotate_left(x, shifts(i)), 2^32);
+            a = tmp;
+        end
+
+        state = mod(state + [a b c d], 2^32);
+    end
+
+    % digest is the state in little-endian byte order
+    digest = mod(floor(repmat(state, 4, 1) ./ ...
+                       repmat(2 .^ [0; 8; 16; 24], 1, 4)), 256);
+    md5 = lower(reshape(dec2hex(digest(:), 2)', 1, 32));
+
+function y = bit_not(x)
+    y = 2^32 - 1 - x;
+
+function y = rotate_left(x, n)
+    y = mod(x * 2^n, 2^32) + floor(x / 2^(32 - n));
@@ -0,0 +1,114 @@
+function varargout = mocov_metrics(command, varargin)
+    % record how long each phase of a coverage run takes, and counts
+    %
+    % Usages:
+    %   1) metrics=mocov_metrics()
+    %
+    %      Returns a struct with fields:
+    %       .phases     struct with, for each phase, the wall time in
+    %                   seconds spent on it
+    %       .counters   struct with, for each counter, its value
+    %      Fields are in the order in which the phases were started and
+    %      the counters were added.
+    %
+    %   2) mocov_metrics('reset')
+    %
+    %      Removes all phases and counters.
+    %
+    %   3) mocov_metrics('start', phase)
+    %
+    %      Starts timing the phase with name phase.
+    %
+    %   4) mocov_metrics('stop', phase)
+    %
+    %      Adds the time since phase was started to its time.
+    %
+    %   5) mocov_metrics('add', counter, value)
+    %
+    %      Adds value to the counter with name counter, which is set to
+    %      zero first if it was not added before.
+    %
+    %   6) mocov_metrics('merge', metrics)
+    %
+    %      Adds the phase times and counters in metrics, as returned by
+    %      usage 1), to those recorded here. This is used to combine the
+    %      metrics recorded by jobs that ran in other processes.
+    %
+    % Notes:
+    %   - names of phases and counters must be valid field names.
+    %   - the metrics are kept in this function, so that they can be
+    %     recorded by MOcovProgressMonitor instances that are copies of
+    %     each other. Metrics of a coverage run with mocov are kept until
+    %     the next run.
+    %   - phase times of jobs that ran in parallel are added up, so they
+    %     can exceed the wall time of the phase that ran the jobs.
+    %
+    % See also: mocov, MOcovProgressMonitor
+
+    persistent phases
+    persistent counters
+    persistent start_clocks
+
+    if isempty(phases)
+        [phases, counters, start_clocks] = init_metrics();
+    end
+
+    if nargin == 0
+        metrics = struct();
+        metrics.phases = phases;
+        metrics.counters = counters;
+        varargout = {metrics};
+        return
+    end
+
+    switch command
+        case 'reset'
+            [phases, counters, start_clocks] = init_metrics();
+
+        case 'start'
+            phase = varargin{1};
+            start_clocks.(phase) = tic();
+            if ~isfield(phases, phase)
+                phases.(phase) = 0;
+            end
+
+        case 'stop'
+            phase = varargin{1};
+            if ~isfield(start_clocks, phase)
+                error('phase ''%s'' was not started', phase);
+            end
+            phases.(phase) = phases.(phase) + toc(start_clocks.(phase));
+            start_clocks = rmfield(start_clocks, phase);
+
+        case 'add'
+            [counter, value] = varargin{:};
+            if isfield(counters, counter)
+                counters.(counter) = counters.(counter) + value;
+            else
+                counters.(counter) = value;
+            end
+
+        case 'merge'
+            metrics = varargin{1};
+            phases = add_fields(phases, metrics.phases);
+            counters = add_fields(counters, metrics.counters);
+
+        otherwise
+            error('illegal command ''%s''', command);
+    end
+
+function [phases, counters, start_clocks] = init_metrics()
+    phases = struct();
+    counters = struct();
+    start_clocks = struct();
+
+function s = add_fields(s, other)
+    keys = fieldnames(other);
+    for k = 1:numel(keys)
+        key = keys{k};
+        if isfield(s, key)
+            s.(key) = s.(key) + other.(key);
+        else
+            s.(key) = other.(key);
+        end
+    end
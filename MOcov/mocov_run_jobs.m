@@ -0,0 +1,168 @@
+function outputs = mocov_run_jobs(n_jobs, func, shared_args, job_args, ...
+                                  n_outputs)
+    % run several jobs in parallel
+    %
+    % outputs=mocov_run_jobs(n_jobs, func, shared_args, job_args, n_outputs)
+    %
+    % Inputs:
+    %   n_jobs              maximum number of jobs to run at the same time
+    %   func                name of the function to run for each job. The
+    %                       k-th job is run as
+    %                           [out1,...]=func(shared_args{:}, job_args{k}{:})
+    %   shared_args         cell with arguments used by all jobs
+    %   job_args            Nx1 cell, with the k-th element a cell with the
+    %                       arguments for the k-th job
+    %   n_outputs           number of outputs of func
+    %
+    % Output:
+    %   outputs             Nx1 cell, with the k-th element a 1xn_outputs
+    %                       cell with the outputs of the k-th job
+    %
+    % Notes:
+    %   - on GNU Octave, each job is run in a separate Octave process;
+    %     all processes in a batch of n_jobs jobs are started with a single
+    %     call to 'system', and their inputs and outputs are passed through
+    %     temporary files (see mocov_job). This requires a unix-like
+    %     platform. The name of the job file is passed to each process
+    %     through the MOCOV_JOB_FILE environment variable.
+    %   - on Matlab, jobs are run with parfor, which only runs jobs in
+    %     parallel if the Parallel Computing Toolbox is available.
+    %   - in all other cases, jobs are run one after the other.
+    %   - metrics recorded by jobs that ran in another process or on a
+    %     parallel worker are added to those of this process (see
+    %     mocov_metrics).
+    %   - an error is raised if any job raised an error.
+    %
+    % See also: mocov_job
+
+    if mocov_util_platform_is_octave()
+        if ispc()
+            outputs = run_in_sequence(func, shared_args, job_args, n_outputs);
+        else
+            outputs = run_in_processes(n_jobs, func, shared_args, ...
+                                       job_args, n_outputs);
+        end
+    else
+        outputs = run_with_parfor(n_jobs, func, shared_args, ...
+                                  job_args, n_outputs);
+    end
+
+function outputs = run_in_sequence(func, shared_args, job_args, n_outputs)
+    n = numel(job_args);
+    outputs = cell(n, 1);
+    for k = 1:n
+        outputs{k} = run_job(func, [shared_args, job_args{k}], n_outputs);
+    end
+
+function outputs = run_with_parfor(n_jobs, func, shared_args, ...
+                                   job_args, n_outputs)
+    n = numel(job_args);
+    results = cell(n, 1);
+    parfor (k = 1:n, n_jobs)
+        results{k} = run_worker_job(func, [shared_args, job_args{k}], ...
+                                    n_outputs);
+    end
+
+    outputs = cell(n, 1);
+    for k = 1:n
+        outputs{k} = results{k}.output;
+        if ~isempty(results{k}.metrics)
+            mocov_metrics('merge', results{k}.metrics);
+        end
+    end
+
+function result = run_worker_job(func, args, n_outputs)
+    % without a parallel pool, parfor runs jobs in this process, which
+    % then records their metrics itself
+    in_worker = exist('getCurrentTask', 'file') && ...
+                        ~isempty(getCurrentTask());
+    if in_worker
+        mocov_metrics('reset');
+    end
+
+    result = struct();
+    result.output = run_job(func, args, n_outputs);
+    result.metrics = [];
+    if in_worker
+        result.metrics = mocov_metrics();
+    end
+
+function output = run_job(func, args, n_outputs)
+    output = cell(1, n_outputs);
+    if n_outputs == 0
+        feval(func, args{:});
+    else
+        [output{:}] = feval(func, args{:});
+    end
+
+function outputs = run_in_processes(n_jobs, func, shared_args, ...
+                                    job_args, n_outputs)
+    temp_dir = tempname();
+    mkdir(temp_dir);
+    cleaner = onCleanup(@()mocov_util_rmdir_recursively(temp_dir));
+
+    % arguments shared by all jobs are stored only once
+    shared_fn = fullfile(temp_dir, 'shared');
+    save(shared_fn, '-binary', 'shared_args');
+
+    n = numel(job_args);
+    output_fns = cell(n, 1);
+    commands = cell(n, 1);
+
+    % the Octave expression is the same for all processes; only quoted
+    % filenames, which can contain any character, are put in commands
+    octave_cmd = sprintf('%s --norc --quiet -p %s --eval %s', ...
+                         shell_quote(get_octave_binary()), ...
+                         shell_quote(fileparts(mfilename('fullpath'))), ...
+                         shell_quote('mocov_job(getenv(''MOCOV_JOB_FILE''))'));
+
+    for k = 1:n
+        output_fns{k} = fullfile(temp_dir, sprintf('output%d', k));
+
+        job = struct();
+        job.func = func;
+        job.args = job_args{k};
+        job.n_outputs = n_outputs;
+        job.shared_fn = shared_fn;
+        job.output_fn = output_fns{k};
+
+        job_fn = fullfile(temp_dir, sprintf('job%d', k));
+        save(job_fn, '-binary', 'job');
+
+        commands{k} = sprintf('MOCOV_JOB_FILE=%s %s', shell_quote(job_fn), ...
+                              octave_cmd);
+    end
+
+    % output of the processes is only shown if a job did not finish
+    process_output = '';
+    for first = 1:n_jobs:n
+        % start a batch of processes, and wait until all have finished
+        batch = first:min(first + n_jobs - 1, n);
+        cmd = sprintf('%s & ', commands{batch});
+        [unused, output] = system([cmd 'wait']);
+        process_output = [process_output output];
+    end
+
+    outputs = cell(n, 1);
+    for k = 1:n
+        if ~exist(output_fns{k}, 'file')
+            error('Job %d did not finish. Output:\n%s', k, process_output);
+        end
+
+        result = load(output_fns{k});
+        if isfield(result, 'error_message')
+            error('Job %d failed: %s', k, result.error_message);
+        end
+        outputs{k} = result.output;
+        mocov_metrics('merge', result.metrics);
+    end
+
+function quoted = shell_quote(s)
+    % quote s for a POSIX shell; single quotes in s are written as '\''
+    quoted = ['''' strrep(s, '''', '''\''''') ''''];
+
+function octave_bin = get_octave_binary()
+    octave_bin = fullfile(OCTAVE_HOME(), 'bin', 'octave-cli');
+    if ~exist(octave_bin, 'file')
+        octave_bin = 'octave-cli';
+    end
@@ -0,0 +1,429 @@
+// C implementation of mocov_scan_mfile.m
+//
+// The C code below determines, for each line in the contents of an m-file,
+// whether it can be executed. It is used by MOcovMFile when parsing files
+// in `prepare`, and runs considerably faster than the .m code, which uses
+// several regular expressions for each line. To use it, it needs compiling
+// using 'mex' in Octave or Matlab.
+//
+// Usage:
+//     [executable, function_start, has_code, has_control_flow] = ...
+//                                                   mocov_scan_mfile(s)
+// where s is a char row vector with the contents of an m-file. Lines are
+// separated by newline characters; each output is an Nx1 logical array with
+// one element for each of the N lines.
+//
+// Each line is processed in a single pass: strings are removed, the part
+// before a comment is kept, and whitespace is removed. The resulting
+// code is then classified using the same rules as the regular expressions
+// in mocov_scan_mfile.m, so that both implementations classify all lines
+// in exactly the same way. Comments in the helper functions below show the
+// regular expression that each helper implements.
+
+#include "mex.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+// State that is kept between lines
+typedef struct {
+    bool in_line_continuation; // previous line contained '...'
+    bool inside_class;         // file contains a 'classdef' statement
+    bool inside_properties;    // a 'properties' section was opened
+                               // but not closed
+} scan_state;
+
+// Outputs for all lines
+typedef struct {
+    mxLogical *executable;
+    mxLogical *function_start;
+    mxLogical *has_code;
+    mxLogical *has_control_flow;
+} scan_result;
+
+// Keywords that may change the control flow. Words that start with one of
+// the prefixes (such as 'endfunction') also change the control flow.
+static const char *CONTROL_FLOW_KEYWORDS[] = {
+    "if",       "elseif", "else",     "for",    "parfor", "while",
+    "do",       "until",  "switch",   "case",   "otherwise", "try",
+    "catch",    "return", "break",    "continue", "function", "error",
+    "rethrow",  "keyboard", "exit",   "quit",   NULL};
+static const char *CONTROL_FLOW_PREFIXES[] = {"end", "unwind_protect",
+                                              "throw", NULL};
+
+////////////
+// Character helpers. Only ASCII characters are considered word characters
+// or whitespace, as in the regular expressions used in the .m code.
+
+static bool is_space(mxChar c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+           c == '\r';
+}
+
+static bool is_alpha(mxChar c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool is_word(mxChar c) {
+    return is_alpha(c) || (c >= '0' && c <= '9') || c == '_';
+}
+
+// true if s (with n characters) starts with the string in prefix
+static bool starts_with(const mxChar *s, size_t n, const char *prefix) {
+    size_t k = strlen(prefix);
+    if (n < k) {
+        return false;
+    }
+
+    for (size_t i = 0; i < k; i++) {
+        if (s[i] != (mxChar)prefix[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// true if s (with n characters) is equal to the string in word
+static bool equals(const mxChar *s, size_t n, const char *word) {
+    return n == strlen(word) && starts_with(s, n, word);
+}
+
+// Position of the first occurrence of the string in needle in s, starting
+// at position from; or n if there is no such occurrence
+static size_t find_string(const mxChar *s, size_t n, size_t from,
+                          const char *needle) {
+    for (size_t i = from; i < n; i++) {
+        if (starts_with(s + i, n - i, needle)) {
+            return i;
+        }
+    }
+    return n;
+}
+
+////////////
+// Removal of strings, comments and whitespace
+
+// regexprep(line, '''.*''|".*"', '')
+// As the regular expression is greedy, a string runs until the last quote
+// of the same type in the line.
+static size_t remove_quotes(const mxChar *line, size_t n, mxChar *out) {
+    size_t last_single = n;
+    size_t last_double = n;
+    for (size_t i = 0; i < n; i++) {
+        if (line[i] == '\'') {
+            last_single = i;
+        } else if (line[i] == '"') {
+            last_double = i;
+        }
+    }
+
+    size_t n_out = 0;
+    size_t i = 0;
+    while (i < n) {
+        mxChar c = line[i];
+        if (c == '\'' && last_single != n && last_single > i) {
+            i = last_single + 1;
+        } else if (c == '"' && last_double != n && last_double > i) {
+            i = last_double + 1;
+        } else {
+            out[n_out++] = c;
+            i++;
+        }
+    }
+    return n_out;
+}
+
+// Number of characters before the first '%'
+static size_t code_length(const mxChar *s, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (s[i] == '%') {
+            return i;
+        }
+    }
+    return n;
+}
+
+// regexprep(line_code, '\s', '')
+static size_t remove_whitespace(const mxChar *s, size_t n, mxChar *out) {
+    size_t n_out = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!is_space(s[i])) {
+            out[n_out++] = s[i];
+        }
+    }
+    return n_out;
+}
+
+////////////
+// Line classification. Helpers that take a trimmed line can assume that it
+// contains no whitespace.
+
+// regexp(line, ['(^|[^\w\.])(if|elseif|else|for|parfor|while|do|until|' ...
+//               'switch|case|otherwise|try|catch|end\w*|' ...
+//               'unwind_protect\w*|return|break|continue|function|' ...
+//               'error|rethrow|throw\w*|keyboard|exit|quit)(\W|$)'])
+// applied to the line including strings and comments
+static bool line_has_control_flow(const mxChar *line, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+        if (!is_word(line[i])) {
+            i++;
+            continue;
+        }
+
+        // find the end of the word starting at i
+        size_t word_start = i;
+        while (i < n && is_word(line[i])) {
+            i++;
+        }
+
+        if (word_start > 0 && line[word_start - 1] == '.') {
+            // field names are not keywords
+            continue;
+        }
+
+        const mxChar *word = line + word_start;
+        size_t word_length = i - word_start;
+        for (const char **kw = CONTROL_FLOW_KEYWORDS; *kw != NULL; kw++) {
+            if (equals(word, word_length, *kw)) {
+                return true;
+            }
+        }
+        for (const char **kw = CONTROL_FLOW_PREFIXES; *kw != NULL; kw++) {
+            if (starts_with(word, word_length, *kw)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// regexp(['\n' trimmed], ['\n\s*function([\[\]\w ,~]*=)?[ ]*' ...
+//                         '(?<name>[a-zA-Z]\w*)(\([^\)]*\))?']) ||
+// regexp(trimmed, 'function\s*\[.*\].*\.\.\.')
+static bool line_is_function_def(const mxChar *t, size_t n) {
+    const char *keyword = "function";
+    size_t k = strlen(keyword);
+
+    if (starts_with(t, n, keyword)) {
+        if (k < n && is_alpha(t[k])) {
+            return true;
+        }
+
+        // output arguments followed by '='
+        size_t i = k;
+        while (i < n && (is_word(t[i]) || t[i] == '[' || t[i] == ']' ||
+                         t[i] == ',' || t[i] == '~')) {
+            i++;
+        }
+        if (i + 1 < n && t[i] == '=' && is_alpha(t[i + 1])) {
+            return true;
+        }
+    }
+
+    // output arguments that continue on the next line
+    size_t start = find_string(t, n, 0, "function[");
+    if (start == n) {
+        return false;
+    }
+    size_t close = find_string(t, n, start + strlen("function["), "]");
+    if (close == n) {
+        return false;
+    }
+    return find_string(t, n, close + 1, "...") < n;
+}
+
+// regexp(trimmed, '^\s*classdef\W*')
+static bool line_is_class_def(const mxChar *t, size_t n) {
+    return starts_with(t, n, "classdef");
+}
+
+// regexp(trimmed, ['^\s*' keyword '\s*(\([^\(\)]*\))?\s*$'])
+static bool line_opens_section(const mxChar *t, size_t n,
+                               const char *keyword) {
+    if (!starts_with(t, n, keyword)) {
+        return false;
+    }
+
+    size_t k = strlen(keyword);
+    if (k == n) {
+        return true;
+    }
+
+    if (t[k] != '(' || t[n - 1] != ')' || n - k < 2) {
+        return false;
+    }
+    for (size_t i = k + 1; i < n - 1; i++) {
+        if (t[i] == '(' || t[i] == ')') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// isempty(regexprep(trimmed, '([\s,;]|^)?end([\s,;]|$)?', ''))
+static bool line_is_sole_end_statement(const mxChar *t, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+        size_t match_end;
+        if ((t[i] == ',' || t[i] == ';') &&
+            starts_with(t + i + 1, n - i - 1, "end")) {
+            match_end = i + 4;
+        } else if (starts_with(t + i, n - i, "end")) {
+            match_end = i + 3;
+        } else {
+            // a character remains after replacement
+            return false;
+        }
+
+        if (match_end < n && (t[match_end] == ',' || t[match_end] == ';')) {
+            match_end++;
+        }
+        i = match_end;
+    }
+    return true;
+}
+
+// regexp(line_code, ['^\s*' keyword '\W*'])
+static bool line_starts_with_keyword(const mxChar *s, size_t n,
+                                     const char *keyword) {
+    size_t i = 0;
+    while (i < n && is_space(s[i])) {
+        i++;
+    }
+    return starts_with(s + i, n - i, keyword);
+}
+
+// regexp(trimmed, '(^|\W)end\s*[,;]?\s*$')
+static bool line_ends_with_end_statement(const mxChar *t, size_t n) {
+    size_t end = n;
+    if (end > 0 && (t[end - 1] == ',' || t[end - 1] == ';')) {
+        end--;
+    }
+
+    if (end < 3 || !starts_with(t + end - 3, 3, "end")) {
+        return false;
+    }
+    return end == 3 || !is_word(t[end - 4]);
+}
+
+// regexp(line_code, '\.\.\.')
+static bool line_has_line_continuation(const mxChar *s, size_t n) {
+    return find_string(s, n, 0, "...") < n;
+}
+
+////////////
+// Scanning
+
+// Classify the k-th line, which has n characters. buffer_code and
+// buffer_trimmed must have space for at least n characters.
+static void scan_line(const mxChar *line, size_t n, size_t k,
+                      scan_state *st, scan_result *res, mxChar *buffer_code,
+                      mxChar *buffer_trimmed) {
+    size_t n_without_quotes = remove_quotes(line, n, buffer_code);
+
+    const mxChar *code = buffer_code;
+    size_t n_code = code_length(buffer_code, n_without_quotes);
+
+    const mxChar *trimmed = buffer_trimmed;
+    size_t n_trimmed = remove_whitespace(code, n_code, buffer_trimmed);
+
+    if (n_trimmed == 0) {
+        return;
+    }
+
+    res->has_code[k] = true;
+    res->has_control_flow[k] = line_has_control_flow(line, n);
+
+    // statements that change or depend on the state
+    bool classdef_statement = line_is_class_def(trimmed, n_trimmed);
+    st->inside_class = st->inside_class || classdef_statement;
+
+    bool properties_section =
+        st->inside_class &&
+        line_opens_section(trimmed, n_trimmed, "properties");
+    st->inside_properties =
+        (st->inside_properties || properties_section) &&
+        !line_ends_with_end_statement(trimmed, n_trimmed);
+
+    bool function_start = !st->in_line_continuation &&
+                          line_is_function_def(trimmed, n_trimmed);
+    res->function_start[k] = function_start;
+
+    bool methods_section = st->inside_class &&
+                           line_opens_section(trimmed, n_trimmed, "methods");
+
+    res->executable[k] =
+        !(st->in_line_continuation || function_start ||
+          classdef_statement || methods_section || st->inside_properties ||
+          line_starts_with_keyword(code, n_code, "case") ||
+          line_starts_with_keyword(code, n_code, "elseif") ||
+          line_starts_with_keyword(code, n_code, "else") ||
+          line_is_sole_end_statement(trimmed, n_trimmed));
+
+    st->in_line_continuation = line_has_line_continuation(code, n_code);
+}
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs,
+                 const mxArray *prhs[]) {
+    if (nrhs != 1 || !(mxIsChar(prhs[0]) || mxIsEmpty(prhs[0]))) {
+        mexErrMsgIdAndTxt("mocov_scan_mfile:InvalidInput",
+                          "Usage: mocov_scan_mfile(s), with s a string");
+    }
+
+    if (nlhs > 4) {
+        mexErrMsgIdAndTxt("mocov_scan_mfile:InvalidOutput",
+                          "This function returns at most four outputs");
+    }
+
+    size_t n_chars = mxGetNumberOfElements(prhs[0]);
+    const mxChar *s = n_chars == 0 ? NULL : mxGetChars(prhs[0]);
+
+    size_t n_lines = 1;
+    for (size_t i = 0; i < n_chars; i++) {
+        if (s[i] == '\n') {
+            n_lines++;
+        }
+    }
+
+    mxArray *outputs[4];
+    for (int i = 0; i < 4; i++) {
+        outputs[i] = mxCreateLogicalMatrix(n_lines, 1);
+    }
+
+    scan_result res = {mxGetLogicals(outputs[0]), mxGetLogicals(outputs[1]),
+                       mxGetLogicals(outputs[2]), mxGetLogicals(outputs[3])};
+    scan_state st = {false, false, false};
+
+    // no line is longer than the whole contents
+    mxChar *buffer_code = mxMalloc((n_chars + 1) * sizeof(mxChar));
+    mxChar *buffer_trimmed = mxMalloc((n_chars + 1) * sizeof(mxChar));
+
+    // an empty string has a single empty line, which is not executable
+    size_t line_start = 0;
+    size_t k = 0;
+    for (size_t i = 0; i < n_chars; i++) {
+        if (s[i] == '\n') {
+            scan_line(s + line_start, i - line_start, k, &st, &res,
+                      buffer_code, buffer_trimmed);
+            line_start = i + 1;
+            k++;
+        }
+    }
+    if (n_chars > 0) {
+        scan_line(s + line_start, n_chars - line_start, k, &st, &res,
+                  buffer_code, buffer_trimmed);
+    }
+
+    mxFree(buffer_code);
+    mxFree(buffer_trimmed);
+
+    int n_outputs = nlhs < 1 ? 1 : nlhs;
+    for (int i = 0; i < 4; i++) {
+        if (i < n_outputs) {
+            plhs[i] = outputs[i];
+        } else {
+            mxDestroyArray(outputs[i]);
+        }
+    }
+}
@@ -0,0 +1,155 @@
+function [executable, function_start, has_code, has_control_flow] = ...
+                                                        mocov_scan_mfile(s)
+    % determine which lines of the contents of an m-file can be executed
+    %
+    % [executable,function_start,has_code,has_control_flow]=...
+    %                                               mocov_scan_mfile(s)
+    %
+    % Input:
+    %   s                   char row vector with the contents of an m-file
+    %
+    % Outputs:
+    %   executable          Nx1 logical array for N lines (separated by
+    %                       newline characters), indicating which lines can
+    %                       be executed
+    %   function_start      Nx1 logical array, indicating which lines start
+    %                       a function definition
+    %   has_code            Nx1 logical array, indicating which lines contain
+    %                       code outside strings and comments
+    %   has_control_flow    Nx1 logical array, indicating which lines may
+    %                       contain a statement that changes the control flow
+    %
+    % Notes:
+    %   - a faster implementation is provided in mocov_scan_mfile.c, which
+    %     requires compilation with mex. Both implementations classify all
+    %     lines in the same way.
+    %
+    % See also: MOcovMFile
+
+    lines = regexp(s, sprintf('\n'), 'split');
+
+    % state variables
+    in_line_continuation = false;  % whether the previous line contained a
+    % line continuation, i.e. ended with '...'
+
+    inside_class = false;  % the file contains a `classdef` statement
+
+    inside_properties = false; % a `properties` section was opened
+    % but not closed.
+
+    % see which lines are executable
+    n = numel(lines);
+    executable = false(n, 1);
+    has_code = false(n, 1);
+    has_control_flow = false(n, 1);
+    function_start = false(n, 1);
+    for k = 1:n
+        line = lines{k};
+
+        line_without_quotes = regexprep(line, '''.*''|".*"', '');
+
+        comment_start = find(line_without_quotes == '%', 1);
+        if isempty(comment_start)
+            line_code = line_without_quotes;
+        else
+            line_code = line_without_quotes(1:(comment_start - 1));
+        end
+
+        line_code_trimmed = regexprep(line_code, '\s', '');
+        if isempty(line_code_trimmed)
+            continue
+        end
+
+        has_code(k) = true;
+        has_control_flow(k) = line_has_control_flow(line);
+
+        % Check for statements that ~changes/depends on~ the 'parser' state
+        classdef_statement = line_is_class_def(line_code_trimmed);
+        inside_class = inside_class || classdef_statement;
+
+        properties_section = line_opens_properties_section( ...
+                                                    line_code_trimmed, ...
+                                                    inside_class);
+        % When a properties section is opened set the inside_properties flag
+        inside_properties = inside_properties || properties_section;
+        % When inside_properties is set and an 'end' appears, the section
+        % is closed.
+        % This can be considered a hack, since assumes no code that includes
+        % an `end` is allowed inside properties.
+        inside_properties = inside_properties && ...
+            ~line_ends_with_end_statement(line_code_trimmed);
+
+        function_start(k) = ~in_line_continuation && ...
+            line_is_function_def(line_code_trimmed);
+
+        % classify line
+        executable(k) = ~( ...
+                          in_line_continuation || ...
+                          function_start(k) || ...
+                          classdef_statement || ...
+                          line_opens_methods_section(line_code_trimmed, inside_class) || ...
+                          inside_properties || ...  % Arbitrary code cannot run inside
+                          ...                       % properties section, just a subset
+                          line_is_case_statement(line_code) || ...
+                          line_is_elseif_statement(line_code) || ...
+                          line_is_else_statement(line_code) || ...
+                          line_is_sole_end_statement(line_code_trimmed));
+
+        in_line_continuation = line_has_line_continuation(line_code);
+    end
+
+function tf = line_is_function_def(line)
+    % returns true if the string in line indicates a function definition
+    newline = sprintf('\n');
+    pat = [newline '\s*function([\[\]\w ,~]*=)?[ ]*'...
+           '(?<name>[a-zA-Z]\w*)(\([^\)]*\))?'];
+
+    tf = ~isempty(regexp([newline line], pat, 'once'));
+    % addition, so that defs that span multiple lines with ... get
+    % recognized properly
+    tf = tf || ~isempty(regexp(line, 'function\s*\[.*\].*\.\.\.', 'once'));
+
+function tf = line_is_class_def(line)
+    % returns true if the line opens a class definition
+    tf = ~isempty(regexp(line, '^\s*classdef\W*', 'once'));
+
+function tf = line_opens_methods_section(line, inside_class)
+    % returns true if the line opens a method section inside class definition
+    tf = inside_class && ...
+       ~isempty(regexp(line, '^\s*methods\s*(\([^\(\)]*\))?\s*$', 'once'));
+
+function tf = line_opens_properties_section(line, inside_class)
+    % returns true if the line opens a properties section inside class definition
+    tf = inside_class && ...
+       ~isempty(regexp(line, '^\s*properties\s*(\([^\(\)]*\))?\s*$', 'once'));
+
+function tf = line_is_sole_end_statement(line)
+    % returns true if the string in line is just an end statement
+    tf = isempty(regexprep(line, '([\s,;]|^)?end([\s,;]|$)?', ''));
+
+function tf = line_is_case_statement(line)
+    tf = ~isempty(regexp(line, '^\s*case\W*', 'once'));
+
+function tf = line_is_elseif_statement(line)
+    tf = ~isempty(regexp(line, '^\s*elseif\W*', 'once'));
+
+function tf = line_is_else_statement(line)
+    tf = ~isempty(regexp(line, '^\s*else\W*', 'once'));
+
+function tf = line_ends_with_end_statement(line)
+    % returns true if the line has a finishing 'end'
+    tf = ~isempty(regexp(line, '(^|\W)end\s*[,;]?\s*$', 'once'));
+
+function tf = line_has_control_flow(line)
+    % returns true if the line may contain a statement that changes the
+    % control flow. The raw line (including strings and comments) is used,
+    % so that in case of doubt a line is considered to change control flow.
+    pat = ['(^|[^\w\.])(if|elseif|else|for|parfor|while|do|until|' ...
+           'switch|case|otherwise|try|catch|end\w*|unwind_protect\w*|' ...
+           'return|break|continue|function|error|rethrow|throw\w*|' ...
+           'keyboard|exit|quit)(\W|$)'];
+    tf = ~isempty(regexp(line, pat, 'once'));
+
+function tf = line_has_line_continuation(line)
+    % returns true if the line contains a line continuation
+    tf = ~isempty(regexp(line, '\.\.\.', 'once'));
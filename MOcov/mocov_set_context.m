@@ -0,0 +1,38 @@
+function mocov_set_context(name)
+    % set the context, such as the name of a test, that covered lines are
+    % attributed to
+    %
+    % mocov_set_context(name)
+    %
+    % Input:
+    %   name                name of the context, for example the name of the
+    %                       test that is about to run. If empty, lines are
+    %                       no longer attributed to any context.
+    %
+    % Notes:
+    %   - lines covered while a context is set are recorded both in the
+    %     aggregate line counts and as hit by that context, so that it can
+    %     be determined later which tests cover which lines (see
+    %     mocov_contexts_select).
+    %   - counts in the line buffers of the 'buffer' probe are added before
+    %     the context is changed, so that they are attributed to the
+    %     context that was set when they were counted.
+    %   - setting a context that was used before continues it.
+    %
+    % Example:
+    %   % attribute coverage to each test separately
+    %   for k = 1:numel(test_names)
+    %       mocov_set_context(test_names{k});
+    %       feval(test_names{k});
+    %   end
+    %   mocov_set_context('');
+    %
+    % See also: mocov_line_covered, mocov_contexts_save,
+    %           mocov_contexts_select
+
+    if nargin < 1 || ~(ischar(name) || isempty(name))
+        error('Usage: mocov_set_context(name), with name a string');
+    end
+
+    mocov_line_buffer('flush');
+    mocov_line_covered('set_context', name);
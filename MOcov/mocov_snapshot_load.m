@@ -0,0 +1,117 @@
+function snapshot = mocov_snapshot_load(fn)
+    % read a binary snapshot file without changing the coverage state
+    %
+    % snapshot=mocov_snapshot_load(fn)
+    %
+    % Input:
+    %   fn                  name of a snapshot file written by
+    %                       mocov_snapshot_save
+    %
+    % Output:
+    %   snapshot            struct with fields:
+    %     .keys             Nx1 cell with filenames
+    %     .line_count       Nx1 cell with how often each line of each file
+    %                       was executed, up to the last executed line
+    %     .hashes           Nx1 cell with the content hash of each file, or
+    %                       an empty string if unknown
+    %     .granularity      granularity of the counts, such as 'line' or
+    %                       'block', or an empty string if unknown
+    %
+    % Notes:
+    %   - snapshot.keys and snapshot.line_count can be used to set the
+    %     state with mocov_line_covered.
+    %   - the format of snapshot files is described in mocov_snapshot_save.
+    %
+    % See also: mocov_snapshot_save, mocov_snapshot_merge, mocov_line_covered
+
+    fid = fopen(fn, 'r');
+    if fid == -1
+        error('Unable to open snapshot %s', fn);
+    end
+    cleaner = onCleanup(@()fclose(fid));
+    bytes = fread(fid, inf, 'uint8=>double');
+
+    magic = 'MOCOVSNP';
+    n_magic = numel(magic);
+    if numel(bytes) < n_magic || ~isequal(char(bytes(1:n_magic)'), magic)
+        error('%s is not a MOcov snapshot', fn);
+    end
+
+    pos = n_magic + 1;
+    [version, pos] = read_varints(bytes, pos, 1);
+    if version ~= 1 && version ~= 2
+        error('Unsupported snapshot version %d in %s', version, fn);
+    end
+
+    % version 1 did not store the granularity
+    granularity = '';
+    if version >= 2
+        [granularity, pos] = read_string(bytes, pos);
+    end
+
+    [n_files, pos] = read_varints(bytes, pos, 1);
+    if n_files > numel(bytes)
+        error('Snapshot %s is corrupt', fn);
+    end
+
+    keys = cell(n_files, 1);
+    line_count = cell(n_files, 1);
+    hashes = cell(n_files, 1);
+    for k = 1:n_files
+        [keys{k}, pos] = read_string(bytes, pos);
+        [hashes{k}, pos] = read_string(bytes, pos);
+
+        [n_counted, pos] = read_varints(bytes, pos, 1);
+        [values, pos] = read_varints(bytes, pos, 2 * n_counted);
+        deltas = values(1:2:end);
+        if any(deltas == 0)
+            error('Snapshot %s is corrupt', fn);
+        end
+
+        lines = cumsum(deltas);
+        file_count = zeros(max([0; lines]), 1);
+        file_count(lines) = values(2:2:end);
+        line_count{k} = file_count;
+    end
+
+    if pos ~= numel(bytes) + 1
+        error('Snapshot %s has trailing data', fn);
+    end
+
+    snapshot = struct();
+    snapshot.keys = keys;
+    snapshot.line_count = line_count;
+    snapshot.hashes = hashes;
+    snapshot.granularity = granularity;
+
+function [s, pos] = read_string(bytes, pos)
+    [n, pos] = read_varints(bytes, pos, 1);
+    last = pos + n - 1;
+    if last > numel(bytes)
+        error('Snapshot is truncated');
+    end
+    s = char(bytes(pos:last)');
+    pos = last + 1;
+
+function [values, pos] = read_varints(bytes, pos, n)
+    % decode n unsigned LEB128 integers starting at bytes(pos)
+    values = zeros(n, 1);
+    if n == 0
+        return
+    end
+
+    % the last byte of each integer is the only one below 128
+    ends = find(bytes(pos:end) < 128, n);
+    if numel(ends) < n
+        error('Snapshot is truncated');
+    end
+
+    last = pos + ends(end) - 1;
+    chunk = bytes(pos:last);
+    is_start = [true; chunk(1:(end - 1)) < 128];
+    group = cumsum(is_start);
+    starts = find(is_start);
+    shift = (1:numel(chunk))' - starts(group);
+
+    values = accumarray(group, mod(chunk, 128) .* 128 .^ shift, [n, 1]);
+    pos = last + 1;
@@ -0,0 +1,31 @@
+function mocov_snapshot_merge(fns)
+    % add the line counts in binary snapshot files to the coverage state
+    %
+    % mocov_snapshot_merge(fns)
+    %
+    % Input:
+    %   fns                 name of a snapshot file, or cellstr with names
+    %                       of snapshot files, written by
+    %                       mocov_snapshot_save
+    %
+    % Notes:
+    %   - files are matched by name; files that are not yet in the state
+    %     are added to it.
+    %   - an error is raised if a file has a different content hash in a
+    %     snapshot than in the state, or if a snapshot has a different
+    %     granularity than the state. In that case, the counts of that
+    %     snapshot are not added at all.
+    %
+    % See also: mocov_snapshot_save, mocov_snapshot_load, mocov_line_covered
+
+    if ischar(fns)
+        fns = {fns};
+    end
+
+    if ~iscellstr(fns)
+        error('input must be a string or a cellstr');
+    end
+
+    for k = 1:numel(fns)
+        mocov_line_covered('merge', fns{k});
+    end
@@ -0,0 +1,39 @@
+function mocov_snapshot_save(fn)
+    % write the current coverage state to a binary snapshot file
+    %
+    % mocov_snapshot_save(fn)
+    %
+    % Input:
+    %   fn                  name of the snapshot file to write
+    %
+    % Notes:
+    %   - snapshots are intended for combining coverage of test shards run
+    %     in separate processes: each process saves its own snapshot, after
+    %     which they are combined using mocov_snapshot_merge.
+    %   - a snapshot (version 2) consists of, with varint denoting an
+    %     unsigned LEB128 integer (7 bits per byte, least significant byte
+    %     first):
+    %       magic               the 8 bytes 'MOCOVSNP'
+    %       version             varint
+    %       granularity         varint length, followed by the characters
+    %                           (empty if unknown; absent in version 1)
+    %       n_files             varint
+    %       for each file:
+    %         filename          varint length, followed by the characters
+    %         hash              varint length, followed by the characters
+    %                           (empty if the content hash is unknown)
+    %         n_counted         varint, number of lines with a non-zero
+    %                           count
+    %         for each of these lines, in increasing order:
+    %           line delta      varint, line number minus that of the
+    %                           previous line (or minus 0 for the first)
+    %           count           varint
+    %     Lines that were not executed are not stored, and line numbers and
+    %     counts mostly take a single byte each.
+    %   - the granularity is the one set with mocov_line_covered, which is
+    %     done by MOcovMFileCollection; snapshots with different
+    %     granularities cannot be merged.
+    %
+    % See also: mocov_snapshot_load, mocov_snapshot_merge, mocov_line_covered
+
+    mocov_line_covered('save', fn);
@@ -0,0 +1,45 @@
+function overhead = mocov_timing_probe_overhead(n_probes)
+    % measure the time that recording a covered line adds when timing
+    %
+    % overhead=mocov_timing_probe_overhead([n_probes])
+    %
+    % Input:
+    %   n_probes            optional number of covered lines to record for
+    %                       the measurement.
+    %                       Default: 10000
+    %
+    % Output:
+    %   overhead            time in seconds that is attributed to a line
+    %                       each time it is covered while timing, but that
+    %                       is spent on recording it
+    %
+    % Notes:
+    %   - this function records lines as a rewritten m-file does, with
+    %     timing enabled, and divides the time attributed to these lines
+    %     by the number of intervals measured. The state of
+    %     mocov_line_covered is restored afterwards, without contexts or
+    %     times.
+    %
+    % See also: mocov_line_covered, get_hotspots
+
+    if nargin < 1
+        n_probes = 10000;
+    end
+
+    if ~isscalar(n_probes) || n_probes < 2 || round(n_probes) ~= n_probes
+        error('number of probes must be an integer of at least 2');
+    end
+
+    state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(state));
+
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'mocov_timing_probe_overhead'}, 1);
+    mocov_line_covered('timing', true);
+    for k = 1:n_probes
+        mocov_line_covered(1, 1);
+    end
+    mocov_line_covered('timing', false);
+
+    times = mocov_line_covered('get_times');
+    overhead = times{1}(1) / (n_probes - 1);
@@ -0,0 +1,454 @@
+// C implementation of mocov_util_find_files.m
+//
+// The C code below finds files recursively in a directory, so that
+// mocov_find_files does not have to call 'dir' for every directory and
+// match every directory entry using 'regexp' in the interpreter. To use
+// it, it needs compiling using 'mex' in Octave or Matlab.
+//
+// Usage:
+//     res = mocov_util_find_files(root_dir, file_pat, exclude_pat)
+// where root_dir is the directory in which files are sought (or empty for
+// the current directory), file_pat a wildcard pattern (such as '*.m') for
+// the names of the files to find, and exclude_pat a cellstr with wildcard
+// patterns of files and directories to omit. Patterns that contain a '/'
+// are matched against the path relative to root_dir, with '/' separating
+// directories (on all platforms); other patterns against the name of the
+// file or directory. Directories that match an exclude pattern are not
+// read at all. In patterns, '*' matches any sequence of characters
+// (including '/'), and '?' any single character. The output is a Kx1 cell
+// with the paths of the files found, each starting with root_dir, in the
+// same order as mocov_util_find_files.m: for each directory, its entries
+// are sorted by name, and the files in a subdirectory are at the position
+// of the subdirectory.
+//
+// Patterns are compiled once before the search starts: patterns without
+// wildcards, and patterns with only a leading or trailing '*' (such as
+// '*.m'), are matched by comparing strings directly.
+
+#if !defined(_WIN32) && !defined(_DEFAULT_SOURCE)
+// for the d_type field of directory entries, which avoids calling stat
+#define _DEFAULT_SOURCE
+#endif
+
+#include "mex.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define PATH_SEPARATOR '\\'
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#define PATH_SEPARATOR '/'
+#endif
+
+// How a pattern is matched, determined once when the pattern is compiled
+typedef enum {
+    MATCH_ALL,     // '*'
+    MATCH_LITERAL, // no wildcards
+    MATCH_PREFIX,  // literal followed by a single '*'
+    MATCH_SUFFIX,  // a single '*' followed by a literal
+    MATCH_GLOB     // anything else
+} match_kind;
+
+typedef struct {
+    char *text;       // the pattern, or the literal part for prefix and
+                      // suffix patterns
+    size_t length;    // number of characters in text
+    match_kind kind;  // how the pattern is matched
+    bool is_path;     // whether matched against the relative path
+} glob_pattern;
+
+typedef struct {
+    glob_pattern *items;
+    size_t n;
+} glob_patterns;
+
+// Growable array of strings, each allocated with mxMalloc
+typedef struct {
+    char **items;
+    size_t n;
+    size_t capacity;
+} string_list;
+
+// Growable null-terminated string, used for the path being visited
+typedef struct {
+    char *chars;
+    size_t length;
+    size_t capacity;
+} path_buffer;
+
+// Directory entry, as read before visiting
+typedef struct {
+    char *name;
+    bool is_dir;
+} dir_entry;
+
+static void *allocate(size_t n_bytes) {
+    // mxMalloc raises an error (and does not return) if out of memory
+    return mxMalloc(n_bytes > 0 ? n_bytes : 1);
+}
+
+static char *copy_string(const char *s, size_t n) {
+    char *copy = allocate(n + 1);
+    memcpy(copy, s, n);
+    copy[n] = '\0';
+    return copy;
+}
+
+////////////
+// Patterns
+
+static bool has_wildcard(const char *s, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (s[i] == '*' || s[i] == '?') {
+            return true;
+        }
+    }
+    return false;
+}
+
+static glob_pattern compile_pattern(const char *pattern) {
+    glob_pattern compiled;
+    size_t n = strlen(pattern);
+    compiled.is_path = strchr(pattern, '/') != NULL;
+
+    if (n == 1 && pattern[0] == '*') {
+        compiled.kind = MATCH_ALL;
+        compiled.text = copy_string("", 0);
+        compiled.length = 0;
+    } else if (!has_wildcard(pattern, n)) {
+        compiled.kind = MATCH_LITERAL;
+        compiled.text = copy_string(pattern, n);
+        compiled.length = n;
+    } else if (pattern[0] == '*' && !has_wildcard(pattern + 1, n - 1)) {
+        compiled.kind = MATCH_SUFFIX;
+        compiled.text = copy_string(pattern + 1, n - 1);
+        compiled.length = n - 1;
+    } else if (pattern[n - 1] == '*' && !has_wildcard(pattern, n - 1)) {
+        compiled.kind = MATCH_PREFIX;
+        compiled.text = copy_string(pattern, n - 1);
+        compiled.length = n - 1;
+    } else {
+        compiled.kind = MATCH_GLOB;
+        compiled.text = copy_string(pattern, n);
+        compiled.length = n;
+    }
+    return compiled;
+}
+
+// Whether the whole of s matches the wildcard pattern. After a mismatch,
+// only the position after the most recent '*' is retried, so that the time
+// is at most proportional to the product of the lengths.
+static bool glob_match(const char *pattern, const char *s) {
+    const char *star = NULL;
+    const char *star_s = NULL;
+
+    while (*s != '\0') {
+        if (*pattern == '*') {
+            star = pattern++;
+            star_s = s;
+        } else if (*pattern != '\0' && (*pattern == '?' || *pattern == *s)) {
+            pattern++;
+            s++;
+        } else if (star != NULL) {
+            pattern = star + 1;
+            s = ++star_s;
+        } else {
+            return false;
+        }
+    }
+
+    while (*pattern == '*') {
+        pattern++;
+    }
+    return *pattern == '\0';
+}
+
+static bool pattern_matches(const glob_pattern *pattern, const char *s) {
+    size_t n;
+    switch (pattern->kind) {
+    case MATCH_ALL:
+        return true;
+    case MATCH_LITERAL:
+        return strcmp(pattern->text, s) == 0;
+    case MATCH_PREFIX:
+        return strncmp(pattern->text, s, pattern->length) == 0;
+    case MATCH_SUFFIX:
+        n = strlen(s);
+        return n >= pattern->length &&
+               memcmp(s + n - pattern->length, pattern->text,
+                      pattern->length) == 0;
+    default:
+        return glob_match(pattern->text, s);
+    }
+}
+
+// Whether an entry with the given name and relative path is excluded
+static bool is_excluded(const glob_patterns *excludes, const char *name,
+                        const char *rel_path) {
+    for (size_t i = 0; i < excludes->n; i++) {
+        const glob_pattern *pattern = &excludes->items[i];
+        if (pattern_matches(pattern, pattern->is_path ? rel_path : name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+////////////
+// Strings and paths
+
+static void add_string(string_list *list, char *s) {
+    if (list->n == list->capacity) {
+        size_t capacity = list->capacity == 0 ? 64 : 2 * list->capacity;
+        list->items = mxRealloc(list->items, capacity * sizeof(char *));
+        list->capacity = capacity;
+    }
+    list->items[list->n++] = s;
+}
+
+// Append a separator (unless the path is empty or already ends with one)
+// and a name to the path; returns the length of the path before, so that
+// it can be restored using truncate_path
+static size_t append_to_path(path_buffer *path, char separator,
+                             const char *name) {
+    size_t old_length = path->length;
+    size_t n = strlen(name);
+    bool needs_separator = path->length > 0 &&
+                           path->chars[path->length - 1] != separator &&
+                           path->chars[path->length - 1] != '/';
+
+    size_t required = path->length + (needs_separator ? 1 : 0) + n + 1;
+    if (required > path->capacity) {
+        size_t capacity = 2 * required;
+        path->chars = mxRealloc(path->chars, capacity);
+        path->capacity = capacity;
+    }
+
+    if (needs_separator) {
+        path->chars[path->length++] = separator;
+    }
+    memcpy(path->chars + path->length, name, n + 1);
+    path->length += n;
+    return old_length;
+}
+
+static void truncate_path(path_buffer *path, size_t length) {
+    path->length = length;
+    path->chars[length] = '\0';
+}
+
+static void init_path(path_buffer *path, const char *s) {
+    path->length = 0;
+    path->capacity = 0;
+    path->chars = NULL;
+    append_to_path(path, PATH_SEPARATOR, s);
+}
+
+////////////
+// Reading directories
+
+static int compare_entries(const void *a, const void *b) {
+    return strcmp(((const dir_entry *)a)->name, ((const dir_entry *)b)->name);
+}
+
+static void add_entry(dir_entry **entries, size_t *n, size_t *capacity,
+                      const char *name, bool is_dir) {
+    if (*n == *capacity) {
+        *capacity = *capacity == 0 ? 16 : 2 * *capacity;
+        *entries = mxRealloc(*entries, *capacity * sizeof(dir_entry));
+    }
+    (*entries)[*n].name = copy_string(name, strlen(name));
+    (*entries)[*n].is_dir = is_dir;
+    (*n)++;
+}
+
+static bool is_dot_entry(const char *name) {
+    return strcmp(name, ".") == 0 || strcmp(name, "..") == 0;
+}
+
+// Read the entries of a directory, except '.' and '..', sorted by name.
+// Returns false if the directory cannot be read.
+static bool read_dir(path_buffer *path, dir_entry **entries, size_t *n) {
+    size_t capacity = 0;
+    *entries = NULL;
+    *n = 0;
+
+#ifdef _WIN32
+    size_t length = append_to_path(path, PATH_SEPARATOR, "*");
+    WIN32_FIND_DATAA data;
+    HANDLE handle = FindFirstFileA(path->chars, &data);
+    truncate_path(path, length);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    do {
+        if (!is_dot_entry(data.cFileName)) {
+            bool is_dir =
+                (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+            add_entry(entries, n, &capacity, data.cFileName, is_dir);
+        }
+    } while (FindNextFileA(handle, &data));
+    FindClose(handle);
+#else
+    DIR *dir = opendir(path->length > 0 ? path->chars : ".");
+    if (dir == NULL) {
+        return false;
+    }
+
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        if (is_dot_entry(ent->d_name)) {
+            continue;
+        }
+
+        bool is_dir;
+        bool needs_stat = true;
+#ifdef DT_DIR
+        // symbolic links are followed, as by 'dir'
+        if (ent->d_type == DT_DIR || ent->d_type == DT_REG) {
+            is_dir = ent->d_type == DT_DIR;
+            needs_stat = false;
+        }
+#endif
+        if (needs_stat) {
+            size_t length = append_to_path(path, PATH_SEPARATOR, ent->d_name);
+            struct stat st;
+            is_dir = stat(path->chars, &st) == 0 && S_ISDIR(st.st_mode);
+            truncate_path(path, length);
+        }
+        add_entry(entries, n, &capacity, ent->d_name, is_dir);
+    }
+    closedir(dir);
+#endif
+
+    qsort(*entries, *n, sizeof(dir_entry), compare_entries);
+    return true;
+}
+
+// Add the files in the directory at path, and in its subdirectories, to
+// res. Returns false if the directory cannot be read.
+static bool find_files(path_buffer *path, path_buffer *rel_path,
+                       const glob_pattern *file_pattern,
+                       const glob_patterns *excludes, string_list *res) {
+    dir_entry *entries;
+    size_t n;
+    if (!read_dir(path, &entries, &n)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        const char *name = entries[i].name;
+        size_t length = append_to_path(path, PATH_SEPARATOR, name);
+        size_t rel_length = append_to_path(rel_path, '/', name);
+
+        if (is_excluded(excludes, name, rel_path->chars)) {
+            // excluded directories are not read
+        } else if (entries[i].is_dir) {
+            // unreadable subdirectories are skipped, as by 'dir'
+            find_files(path, rel_path, file_pattern, excludes, res);
+        } else if (pattern_matches(file_pattern, name)) {
+            add_string(res, copy_string(path->chars, path->length));
+        }
+
+        truncate_path(path, length);
+        truncate_path(rel_path, rel_length);
+        mxFree(entries[i].name);
+    }
+    mxFree(entries);
+    return true;
+}
+
+////////////
+// Inputs and outputs
+
+static char *get_string(const mxArray *mx_string, const char *message) {
+    if (!mxIsChar(mx_string) && !mxIsEmpty(mx_string)) {
+        mexErrMsgIdAndTxt("mocov_util_find_files:InvalidInput", "%s",
+                          message);
+    }
+    if (mxIsEmpty(mx_string)) {
+        return copy_string("", 0);
+    }
+    char *s = mxArrayToString(mx_string);
+    if (s == NULL) {
+        mexErrMsgIdAndTxt("mocov_util_find_files:InvalidInput", "%s",
+                          message);
+    }
+    return s;
+}
+
+static glob_patterns get_exclude_patterns(const mxArray *mx_patterns) {
+    glob_patterns patterns;
+    patterns.n = 0;
+    patterns.items = NULL;
+
+    if (mxIsEmpty(mx_patterns)) {
+        return patterns;
+    }
+    if (!mxIsCell(mx_patterns)) {
+        mexErrMsgIdAndTxt("mocov_util_find_files:InvalidInput",
+                          "exclude patterns must be a cellstr");
+    }
+
+    size_t n = mxGetNumberOfElements(mx_patterns);
+    patterns.items = allocate(n * sizeof(glob_pattern));
+    for (size_t i = 0; i < n; i++) {
+        const mxArray *mx_pattern = mxGetCell(mx_patterns, i);
+        if (mx_pattern == NULL) {
+            mexErrMsgIdAndTxt("mocov_util_find_files:InvalidInput",
+                              "exclude patterns must be a cellstr");
+        }
+        char *pattern =
+            get_string(mx_pattern, "exclude patterns must be a cellstr");
+        patterns.items[patterns.n++] = compile_pattern(pattern);
+        mxFree(pattern);
+    }
+    return patterns;
+}
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs,
+                 const mxArray *prhs[]) {
+    if (nrhs != 3) {
+        mexErrMsgIdAndTxt("mocov_util_find_files:InvalidInput",
+                          "Usage: mocov_util_find_files(root_dir, "
+                          "file_pat, exclude_pat)");
+    }
+
+    if (nlhs > 1) {
+        mexErrMsgIdAndTxt("mocov_util_find_files:InvalidOutput",
+                          "This function returns at most one output");
+    }
+
+    char *root_dir = get_string(prhs[0], "root_dir must be a string");
+    char *file_pat = get_string(prhs[1], "file_pat must be a string");
+    glob_pattern file_pattern = compile_pattern(file_pat);
+    glob_patterns excludes = get_exclude_patterns(prhs[2]);
+
+    path_buffer path;
+    path_buffer rel_path;
+    init_path(&path, root_dir);
+    init_path(&rel_path, "");
+
+    string_list res = {NULL, 0, 0};
+    if (!find_files(&path, &rel_path, &file_pattern, &excludes, &res)) {
+        mexErrMsgIdAndTxt("mocov_util_find_files:InvalidInput",
+                          "first argument must be directory");
+    }
+
+    plhs[0] = mxCreateCellMatrix(res.n, 1);
+    for (size_t i = 0; i < res.n; i++) {
+        mxSetCell(plhs[0], i, mxCreateString(res.items[i]));
+        mxFree(res.items[i]);
+    }
+
+    // other memory allocated with mxMalloc is freed when returning
+    mxFree(res.items);
+    mxFree(path.chars);
+    mxFree(rel_path.chars);
+}
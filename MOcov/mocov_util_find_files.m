@@ -0,0 +1,119 @@
+function res = mocov_util_find_files(root_dir, file_pat, exclude_pat)
+    % find files recursively in a directory
+    %
+    % res=mocov_util_find_files(root_dir, file_pat, exclude_pat)
+    %
+    % Inputs:
+    %   root_dir            directory in which files are sought, or empty
+    %                       for the current working directory.
+    %   file_pat            wildcard pattern for the names of the files to
+    %                       find, e.g. '*.m' for all files ending with '.m'.
+    %   exclude_pat         cellstr with wildcard patterns of files and
+    %                       directories to omit. Patterns that contain a
+    %                       '/' are matched against the path relative to
+    %                       root_dir, with '/' separating directories (on
+    %                       all platforms); other patterns against the name
+    %                       of the file or directory.
+    %
+    % Output:
+    %   res                 Kx1 cell with the paths of the files found, each
+    %                       starting with root_dir. For each directory, its
+    %                       entries are in the order returned by 'dir', and
+    %                       files in a subdirectory are at the position of
+    %                       the subdirectory.
+    %
+    % Notes:
+    %   - in patterns, '*' matches any sequence of characters (including
+    %     '/'), and '?' any single character.
+    %   - directories that match an exclude pattern are not read at all, so
+    %     that whole subtrees can be skipped using patterns such as
+    %     'external/*' or '*/private'.
+    %   - a faster implementation is provided in mocov_util_find_files.c,
+    %     which requires compilation with mex.
+    %
+    % See also: mocov_find_files
+
+    if ~(isempty(root_dir) || ischar(root_dir)) || ~ischar(file_pat) || ...
+            ~(isempty(exclude_pat) || iscellstr(exclude_pat))
+        error(['Usage: mocov_util_find_files(root_dir, file_pat, '...
+               'exclude_pat)']);
+    end
+
+    if ~(isempty(root_dir) || mocov_util_isfolder(root_dir))
+        error('first argument must be directory');
+    end
+
+    if isempty(exclude_pat)
+        exclude_pat = cell(0);
+    end
+
+    % patterns are translated to regular expressions only once
+    is_path_pat = ~cellfun(@isempty, strfind(exclude_pat, '/'));
+    file_re = pattern2re(file_pat);
+    name_re = join_patterns(exclude_pat(~is_path_pat));
+    path_re = join_patterns(exclude_pat(is_path_pat));
+
+    res = find_files_recursively(root_dir, '', file_re, name_re, path_re);
+
+function re = pattern2re(pat)
+    re = ['^' ... % start of the string
+          regexptranslate('wildcard', pat) ...
+          '$'];   % end of the string
+
+function re = join_patterns(pats)
+    if isempty(pats)
+        re = '';
+        return
+    end
+
+    res = cellfun(@pattern2re, pats, 'UniformOutput', false);
+    joined = sprintf('|%s', res{:});
+    re = joined(2:end);
+
+function is_match = matches(strs, re)
+    if isempty(re)
+        is_match = false(size(strs));
+    else
+        is_match = ~cellfun(@isempty, regexp(strs, re, 'once'));
+    end
+
+function res = find_files_recursively(root_dir, rel_dir, file_re, ...
+                                      name_re, path_re)
+    if isempty(root_dir)
+        d = dir();
+    else
+        d = dir(root_dir);
+    end
+
+    if isempty(d)
+        res = cell(0, 1);
+        return
+    end
+
+    names = {d.name};
+    is_dir = [d.isdir];
+    if isempty(rel_dir)
+        rel_paths = names;
+    else
+        rel_paths = strcat([rel_dir '/'], names);
+    end
+
+    % all entries of a directory are matched at once
+    keep = ~(strcmp(names, '.') | strcmp(names, '..')) & ...
+                ~matches(names, name_re) & ~matches(rel_paths, path_re);
+    is_file_match = keep & ~is_dir & matches(names, file_re);
+
+    n = numel(names);
+    res_cell = cell(n, 1);
+    for k = find(keep & (is_dir | is_file_match))
+        path_fn = fullfile(root_dir, names{k});
+        if is_dir(k)
+            res_cell{k} = find_files_recursively(path_fn, rel_paths{k}, ...
+                                                 file_re, name_re, path_re);
+        else
+            res_cell{k} = {path_fn};
+        end
+    end
+
+    res_cell = res_cell(~cellfun(@isempty, res_cell));
+    res = cat(1, cell(0, 1), res_cell{:});
@@ -0,0 +1,18 @@
+function mocov_util_mkdir_recursively(pth)
+    % create a directory, including any parent directories that are missing
+    %
+    % mocov_util_mkdir_recursively(pth)
+    %
+    % Input:
+    %   pth         name of directory to create. Nothing happens if the
+    %               directory already exists, or if pth is empty
+    %
+    % Notes:
+    %   - older versions of GNU Octave cannot create a directory when its
+    %     parent directory does not exist
+
+    if ~isempty(pth) && ~mocov_util_isfolder(pth)
+        parent = fileparts(pth);
+        mocov_util_mkdir_recursively(parent);
+        mkdir(pth);
+    end
@@ -0,0 +1,30 @@
+function [text, bytes] = mocov_util_read_text(filename)
+    % read the contents of a text file
+    %
+    % [text, bytes]=mocov_util_read_text(filename)
+    %
+    % Inputs:
+    %   filename            name of the file to read
+    %
+    % Outputs:
+    %   text                1xN char array with the contents of the file,
+    %                       decoded as fread with 'char=>char' does
+    %   bytes               Bx1 uint8 array with the contents of the file
+    %                       as stored, from which for example the md5
+    %                       checksum can be computed without reading the
+    %                       file again
+    %
+    % See also: mocov_md5
+
+    fid = fopen(filename);
+    if fid == -1
+        error('Unable to open file %s', filename);
+    end
+    cleaner = onCleanup(@()fclose(fid));
+    bytes = fread(fid, inf, 'uint8=>uint8');
+
+    if mocov_util_platform_is_octave()
+        text = char(bytes');
+    else
+        text = native2unicode(bytes');
+    end
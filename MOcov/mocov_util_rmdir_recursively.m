@@ -0,0 +1,21 @@
+function mocov_util_rmdir_recursively(pth)
+    % remove a directory, including all files and directories in it
+    %
+    % mocov_util_rmdir_recursively(pth)
+    %
+    % Input:
+    %   pth         name of directory to remove
+    %
+    % Notes:
+    %   - GNU Octave requires, by default, confirmation when using rmdir.
+    %     The state of confirm_recursive_rmdir is stored, and set back to
+    %     its original value when leaving this function.
+    %
+    % See also: mocov_util_mkdir_recursively
+
+    if mocov_util_platform_is_octave()
+        confirm_val = confirm_recursive_rmdir(false);
+        cleaner = onCleanup(@()confirm_recursive_rmdir(confirm_val));
+    end
+
+    rmdir(pth, 's');
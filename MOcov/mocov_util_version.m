@@ -0,0 +1,14 @@
+function v = mocov_util_version()
+    % return the version of MOcov
+    %
+    % v=mocov_util_version()
+    %
+    % Output:
+    %   v       string with the version of MOcov, for example '0.1.0'
+    %
+    % Notes:
+    %   - this version must be kept in sync with CITATION.cff
+    %   - rewritten files cached by earlier versions are not used by later
+    %     versions, and vice versa
+
+    v = '0.1.0';
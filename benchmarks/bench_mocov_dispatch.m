@@ -0,0 +1,118 @@
+function result = bench_mocov_dispatch(scale)
+    % compare function call overhead with a deep or shallow search path
+    %
+    % result=bench_mocov_dispatch([scale])
+    %
+    % Input:
+    %   scale               scaling factor for the number of directories and
+    %                       calls. Default: 1
+    %
+    % Output:
+    %   result              struct with fields:
+    %                       .n_dirs         number of directories in the
+    %                                       tree, excluding private, @class
+    %                                       and +package directories
+    %                       .n_calls        number of function calls
+    %                       .time_addpath_all   time (in seconds) to add all
+    %                                       directories of the tree to the
+    %                                       path (as with genpath)
+    %                       .time_calls_all time for the calls with all
+    %                                       directories in the path
+    %                       .time_addpath_root  time to add only the root
+    %                                       directory of the tree
+    %                       .time_calls_root    time for the calls with only
+    %                                       the root directory in the path
+    %
+    % Notes:
+    %   - this compares adding the whole rewritten tree to the path, as
+    %     MOcov did before, with adding only the directories of the
+    %     original path (see get_rewritten_path of MOcovMFileCollection).
+    %   - the tree is written to a temporary directory, which is removed
+    %     afterwards.
+
+    if nargin < 1
+        scale = 1;
+    end
+
+    n_dirs = max(10, round(1000 * scale));
+    n_calls = max(1000, round(1e5 * scale));
+
+    root_dir = tempname();
+    mkdir(root_dir);
+    cleaner_dir = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+    write_tree(root_dir, n_dirs);
+
+    result = struct();
+    result.n_dirs = n_dirs;
+    result.n_calls = n_calls;
+    [result.time_addpath_all, result.time_calls_all] = ...
+                                time_calls(genpath(root_dir), n_calls);
+    [result.time_addpath_root, result.time_calls_root] = ...
+                                time_calls(root_dir, n_calls);
+
+    if nargout == 0
+        fprintf('%d calls, tree with %d directories\n', n_calls, n_dirs);
+        labels = {'all', 'all directories:', ...
+                  'root', 'root directory only:'};
+        for k = 1:2:numel(labels)
+            key = labels{k};
+            fprintf('  %-21s addpath %8.3f sec, calls %8.3f sec\n', ...
+                    labels{k + 1}, result.(['time_addpath_' key]), ...
+                    result.(['time_calls_' key]));
+        end
+    end
+
+function write_tree(root_dir, n_dirs)
+    % directories are nested ten levels deep, and each has private,
+    % @class and +package subdirectories as well
+    write_file(root_dir, 'bench_dispatch_leaf', ...
+               {'function y = bench_dispatch_leaf(x)', ...
+                '    y = x + 1;'});
+    write_file(root_dir, 'bench_dispatch_main', ...
+               {'function y = bench_dispatch_main(n)', ...
+                '    y = 0;', ...
+                '    for k = 1:n', ...
+                '        y = bench_dispatch_leaf(y);', ...
+                '    end'});
+
+    parent_dir = root_dir;
+    for k = 1:n_dirs
+        if mod(k, 10) == 1
+            parent_dir = root_dir;
+        end
+        sub_dir = fullfile(parent_dir, sprintf('d%d', k));
+        mkdir(sub_dir);
+
+        name = sprintf('bench_dispatch_%d', k);
+        write_file(sub_dir, name, {['function y = ' name '(x)'], ...
+                                   '    y = x;'});
+
+        special_dirs = {'private', ['@' name], ['+' name]};
+        for j = 1:numel(special_dirs)
+            special_dir = fullfile(sub_dir, special_dirs{j});
+            mkdir(special_dir);
+            write_file(special_dir, name, {['function y = ' name '(x)'], ...
+                                           '    y = x;'});
+        end
+
+        parent_dir = sub_dir;
+    end
+
+function write_file(root_dir, name, lines)
+    fid = fopen(fullfile(root_dir, [name '.m']), 'w');
+    cleaner = onCleanup(@()fclose(fid));
+    fprintf(fid, '%s\n', lines{:});
+
+function [t_addpath, t_calls] = time_calls(path_dirs, n_calls)
+    orig_path = path();
+    cleaner = onCleanup(@()path(orig_path));
+
+    clock_start = tic();
+    addpath(path_dirs);
+    rehash();
+    t_addpath = toc(clock_start);
+
+    clear('bench_dispatch_main', 'bench_dispatch_leaf');
+    clock_start = tic();
+    bench_dispatch_main(n_calls);
+    t_calls = toc(clock_start);
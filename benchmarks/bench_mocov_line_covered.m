@@ -0,0 +1,89 @@
+function result = bench_mocov_line_covered(n_calls)
+    % measure how many calls per second mocov_line_covered can handle
+    %
+    % result=bench_mocov_line_covered([n_calls])
+    %
+    % Input:
+    %   n_calls             number of calls for each measurement.
+    %                       Default: 1e6
+    %
+    % Output:
+    %   result              struct with fields:
+    %                       .backend        'mex' if the compiled version of
+    %                                       mocov_line_covered is used, 'm'
+    %                                       otherwise
+    %                       .n_calls        number of calls
+    %                       .calls_per_sec_by_name   calls per second when
+    %                                       using mocov_line_covered(idx,fn,k)
+    %                                       (how files were rewritten before
+    %                                       files were registered)
+    %                       .calls_per_sec_by_index  calls per second when
+    %                                       using mocov_line_covered(idx,k)
+    %                                       for a registered file
+    %                       .sec_per_call_by_name   cost of a single call
+    %                       .sec_per_call_by_index  (in seconds), i.e. the
+    %                                       inverse of the above
+    %
+    % Notes:
+    %   - the state of mocov_line_covered is restored afterwards.
+    %   - the time used by the loop itself is measured separately and
+    %     subtracted.
+
+    if nargin < 1
+        n_calls = 1e6;
+    end
+
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'bench/file.m'});
+
+    loop_time = time_empty_loop(n_calls);
+    by_name_time = time_by_name(n_calls) - loop_time;
+    by_index_time = time_by_index(n_calls) - loop_time;
+
+    result = struct();
+    if exist('mocov_line_covered', 'file') == 3
+        result.backend = 'mex';
+    else
+        result.backend = 'm';
+    end
+    result.n_calls = n_calls;
+    result.calls_per_sec_by_name = n_calls / by_name_time;
+    result.calls_per_sec_by_index = n_calls / by_index_time;
+    result.sec_per_call_by_name = by_name_time / n_calls;
+    result.sec_per_call_by_index = by_index_time / n_calls;
+
+    if nargout == 0
+        fprintf('mocov_line_covered (%s), %d calls\n', ...
+                result.backend, n_calls);
+        fprintf('  by name:  %12.0f calls/sec\n', ...
+                result.calls_per_sec_by_name);
+        fprintf('  by index: %12.0f calls/sec (%.1fx)\n', ...
+                result.calls_per_sec_by_index, ...
+                result.calls_per_sec_by_index / result.calls_per_sec_by_name);
+    end
+
+function t = time_empty_loop(n_calls)
+    clock_start = tic();
+    for k = 1:n_calls
+        line = mod(k, 50) + 1;
+    end
+    t = toc(clock_start);
+
+function t = time_by_name(n_calls)
+    clock_start = tic();
+    for k = 1:n_calls
+        line = mod(k, 50) + 1;
+        mocov_line_covered(1, 'bench/file.m', line);
+    end
+    t = toc(clock_start);
+
+function t = time_by_index(n_calls)
+    clock_start = tic();
+    for k = 1:n_calls
+        line = mod(k, 50) + 1;
+        mocov_line_covered(1, line);
+    end
+    t = toc(clock_start);
@@ -0,0 +1,129 @@
+function tree = bench_mocov_make_tree(root_dir, scale)
+    % write a synthetic tree of m-files for benchmarking
+    %
+    % tree=bench_mocov_make_tree(root_dir[, scale])
+    %
+    % Inputs:
+    %   root_dir            directory in which the m-files are written; it
+    %                       is created if it does not exist
+    %   scale               scaling factor for the number and size of files
+    %                       and the number of iterations. Default: 1
+    %
+    % Output:
+    %   tree                struct with fields:
+    %                       .root_dir       root_dir
+    %                       .n_files        number of m-files written
+    %                       .n_lines        total number of lines
+    %                       .expression     expression that runs all code
+    %                                       in the tree, to be evaluated
+    %                                       with root_dir on the path
+    %
+    % Notes:
+    %   - the tree contains:
+    %     * many small functions (bench_small_*.m)
+    %     * a few huge functions with straight-line code (bench_huge_*.m)
+    %     * a loop-heavy function (bench_loop.m)
+    %     * a call-heavy function, which calls small functions in a loop
+    %       (bench_calls.m)
+    %     * a function that calls all of the above (bench_tree_main.m)
+
+    if nargin < 2
+        scale = 1;
+    end
+
+    if ~exist(root_dir, 'dir')
+        mkdir(root_dir);
+    end
+
+    n_small = max(10, round(200 * scale));
+    n_huge = 2;
+    n_huge_lines = max(100, round(5000 * scale));
+    n_iter = max(100, round(1e5 * scale));
+
+    n_lines = 0;
+    for k = 1:n_small
+        n_lines = n_lines + write_small(root_dir, k);
+    end
+
+    for k = 1:n_huge
+        n_lines = n_lines + write_huge(root_dir, k, n_huge_lines);
+    end
+
+    n_lines = n_lines + write_loop(root_dir);
+    n_lines = n_lines + write_calls(root_dir, min(10, n_small));
+    n_lines = n_lines + write_main(root_dir, n_small, n_huge);
+
+    tree = struct();
+    tree.root_dir = root_dir;
+    tree.n_files = n_small + n_huge + 3;
+    tree.n_lines = n_lines;
+    tree.expression = sprintf('bench_tree_main(%d)', n_iter);
+
+function n_lines = write_file(root_dir, name, lines)
+    fid = fopen(fullfile(root_dir, [name '.m']), 'w');
+    cleaner = onCleanup(@()fclose(fid));
+    fprintf(fid, '%s\n', lines{:});
+    n_lines = numel(lines);
+
+function n_lines = write_small(root_dir, k)
+    name = sprintf('bench_small_%d', k);
+    lines = {sprintf('function y = %s(x)', name), ...
+             sprintf('    %% small function %d', k), ...
+             '    y = x;', ...
+             sprintf('    if y > %d', k), ...
+             '        y = y - 1;', ...
+             '    else', ...
+             '        y = y + 1;', ...
+             '    end', ...
+             '    z = y * 2;', ...
+             '    y = z / 2;'};
+    n_lines = write_file(root_dir, name, lines);
+
+function n_lines = write_huge(root_dir, k, n_body_lines)
+    name = sprintf('bench_huge_%d', k);
+    body = repmat({'    y = y + 1;'; '    y = y * 1;'}, ...
+                  ceil(n_body_lines / 2), 1);
+    lines = [{sprintf('function y = %s(x)', name); '    y = x;'}; ...
+             body(1:n_body_lines)];
+    n_lines = write_file(root_dir, name, lines);
+
+function n_lines = write_loop(root_dir)
+    lines = {'function y = bench_loop(n)', ...
+             '    y = 0;', ...
+             '    for k = 1:n', ...
+             '        z = mod(k, 7);', ...
+             '        if z > 3', ...
+             '            y = y + z;', ...
+             '        else', ...
+             '            y = y - 1;', ...
+             '        end', ...
+             '    end'};
+    n_lines = write_file(root_dir, 'bench_loop', lines);
+
+function n_lines = write_calls(root_dir, n_called)
+    calls = cell(n_called, 1);
+    for k = 1:n_called
+        calls{k} = sprintf('        y = bench_small_%d(y);', k);
+    end
+    lines = [{'function y = bench_calls(n)'; ...
+              '    y = 0;'; ...
+              '    for k = 1:n'}; ...
+             calls; ...
+             {'    end'}];
+    n_lines = write_file(root_dir, 'bench_calls', lines);
+
+function n_lines = write_main(root_dir, n_small, n_huge)
+    small_calls = cell(n_small, 1);
+    for k = 1:n_small
+        small_calls{k} = sprintf('    bench_small_%d(%d);', k, k);
+    end
+    huge_calls = cell(n_huge, 1);
+    for k = 1:n_huge
+        huge_calls{k} = sprintf('    bench_huge_%d(%d);', k, k);
+    end
+    lines = [{'function bench_tree_main(n)'; ...
+              '    bench_loop(n);'; ...
+              '    bench_calls(round(n / 10));'}; ...
+             huge_calls; ...
+             small_calls];
+    n_lines = write_file(root_dir, 'bench_tree_main', lines);
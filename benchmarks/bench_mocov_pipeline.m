@@ -0,0 +1,125 @@
+function result = bench_mocov_pipeline(scale)
+    % measure the time of each phase of coverage on a synthetic tree
+    %
+    % result=bench_mocov_pipeline([scale])
+    %
+    % Input:
+    %   scale               scaling factor for the synthetic tree (see
+    %                       bench_mocov_make_tree). Default: 1
+    %
+    % Output:
+    %   result              struct with fields:
+    %                       .n_files        number of files in the tree
+    %                       .n_lines        number of lines in the tree
+    %                       .time_plain     time (in seconds) to run the
+    %                                       code without coverage
+    %                       .time_prepare   time to parse and rewrite all
+    %                                       files
+    %                       .time_instrumented  time to run the rewritten
+    %                                       code
+    %                       .time_add_lines_executed_count  time to
+    %                                       collect the line counts
+    %                       .time_write_xml_file    time to write reports
+    %                       .time_write_json_file   in each format
+    %                       .time_write_html_dir
+    %                       .overhead       time_instrumented / time_plain
+    %                       .line_count_bits    width of line counts used by
+    %                                       mocov_line_covered
+    %                       .line_bytes     memory (in bytes) used for the
+    %                                       line counts of the tree
+    %                       .line_bytes_8   memory the line counts would use
+    %                       .line_bytes_32  with counts of 8, 32 or 64 bits
+    %                       .line_bytes_64  (see LINE_COUNT_BITS in
+    %                                       mocov_line_covered.c), to
+    %                                       compare with the cache size
+    %
+    % Notes:
+    %   - the tree and reports are written to a temporary directory, which
+    %     is removed afterwards.
+    %   - the state of mocov_line_covered is restored afterwards.
+
+    if nargin < 1
+        scale = 1;
+    end
+
+    initial_state = mocov_line_covered();
+    cleaner_state = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+
+    temp_dir = tempname();
+    mkdir(temp_dir);
+    cleaner_dir = onCleanup(@()mocov_util_rmdir_recursively(temp_dir));
+
+    tree = bench_mocov_make_tree(fullfile(temp_dir, 'tree'), scale);
+    output_dir = fullfile(temp_dir, 'output');
+    mkdir(output_dir);
+
+    result = struct();
+    result.n_files = tree.n_files;
+    result.n_lines = tree.n_lines;
+    result.time_plain = time_plain(tree);
+
+    collection = MOcovMFileCollection(tree.root_dir, 'file', ...
+                                      MOcovProgressMonitor(0));
+    clock_start = tic();
+    collection = prepare(collection);
+    result.time_prepare = toc(clock_start);
+    cleaner_collection = onCleanup(@()cleanup(collection));
+
+    % all lines of the tree are registered while preparing
+    info = mocov_line_covered('info');
+    result.line_count_bits = info.line_count_bits;
+    result.line_bytes = info.line_bytes;
+    line_count_bits = [8 32 64];
+    for k = 1:numel(line_count_bits)
+        key = sprintf('line_bytes_%d', line_count_bits(k));
+        result.(key) = info.n_lines * line_count_bits(k) / 8;
+    end
+
+    clock_start = tic();
+    eval(tree.expression);
+    result.time_instrumented = toc(clock_start);
+
+    clock_start = tic();
+    collection = add_lines_executed_count(collection);
+    result.time_add_lines_executed_count = toc(clock_start);
+
+    writers = {'write_xml_file', fullfile(output_dir, 'coverage.xml'); ...
+               'write_json_file', fullfile(output_dir, 'coverage.json'); ...
+               'write_html_dir', fullfile(output_dir, 'html')};
+    for k = 1:size(writers, 1)
+        clock_start = tic();
+        feval(writers{k, 1}, collection, writers{k, 2});
+        result.(['time_' writers{k, 1}]) = toc(clock_start);
+    end
+
+    result.overhead = result.time_instrumented / result.time_plain;
+
+    if nargout == 0
+        fprintf('synthetic tree with %d files, %d lines\n', ...
+                result.n_files, result.n_lines);
+        keys = fieldnames(result);
+        for k = 1:numel(keys)
+            key = keys{k};
+            if strncmp(key, 'time_', 5)
+                fprintf('  %-32s %8.3f sec\n', key(6:end), result.(key));
+            end
+        end
+        fprintf('  %-32s %8.1fx\n', 'overhead', result.overhead);
+        fprintf('  line counts (%d bits)             %8d bytes\n', ...
+                result.line_count_bits, result.line_bytes);
+        for k = 1:numel(line_count_bits)
+            key = sprintf('line_bytes_%d', line_count_bits(k));
+            fprintf('    with %2d bits                   %8d bytes\n', ...
+                    line_count_bits(k), result.(key));
+        end
+    end
+
+function t = time_plain(tree)
+    orig_path = path();
+    addpath(tree.root_dir);
+    cleaner = onCleanup(@()path(orig_path));
+
+    clock_start = tic();
+    eval(tree.expression);
+    t = toc(clock_start);
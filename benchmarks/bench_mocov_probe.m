@@ -0,0 +1,103 @@
+function result = bench_mocov_probe(n_iter)
+    % compare the run time of a loop in files rewritten with different probes
+    %
+    % result=bench_mocov_probe([n_iter])
+    %
+    % Input:
+    %   n_iter              number of iterations of the loop in the
+    %                       benchmarked function. Default: 1e6
+    %
+    % Output:
+    %   result              struct with fields:
+    %                       .n_iter         number of iterations
+    %                       .time_plain     time (in seconds) to run the
+    %                                       function without coverage
+    %                       .time_call      time to run the function after
+    %                                       rewriting it with the 'call' probe
+    %                       .time_buffer    time to run the function after
+    %                                       rewriting it with the 'buffer'
+    %                                       probe, including adding the
+    %                                       buffered counts
+    %                       .time_buffer_block  as .time_buffer, but using
+    %                                       'block' granularity
+    %
+    % Notes:
+    %   - the function is written to a temporary directory, which is
+    %     removed afterwards.
+    %   - the state of mocov_line_covered is restored afterwards.
+
+    if nargin < 1
+        n_iter = 1e6;
+    end
+
+    initial_state = mocov_line_covered();
+    cleaner_state = onCleanup(@()mocov_line_covered(initial_state));
+
+    root_dir = tempname();
+    mkdir(root_dir);
+    funcname = write_loop_function(root_dir);
+    cleaner_dir = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+
+    result = struct();
+    result.n_iter = n_iter;
+    result.time_plain = time_plain(root_dir, funcname, n_iter);
+    result.time_call = time_rewritten(root_dir, funcname, n_iter, ...
+                                      'call', 'line');
+    result.time_buffer = time_rewritten(root_dir, funcname, n_iter, ...
+                                        'buffer', 'line');
+    result.time_buffer_block = time_rewritten(root_dir, funcname, n_iter, ...
+                                              'buffer', 'block');
+
+    if nargout == 0
+        fprintf('loop with %d iterations\n', n_iter);
+        fprintf('  no coverage:            %8.3f sec\n', result.time_plain);
+        labels = {'time_call', 'call probe:', ...
+                  'time_buffer', 'buffer probe:', ...
+                  'time_buffer_block', 'buffer probe, blocks:'};
+        for k = 1:2:numel(labels)
+            t = result.(labels{k});
+            fprintf('  %-22s %8.3f sec (%.1fx)\n', ...
+                    labels{k + 1}, t, t / result.time_plain);
+        end
+    end
+
+function funcname = write_loop_function(root_dir)
+    funcname = ['bench_loop_' char(96 + ceil(26 * rand(1, 10)))];
+    fid = fopen(fullfile(root_dir, [funcname '.m']), 'w');
+    cleaner = onCleanup(@()fclose(fid));
+    fprintf(fid, [ ...
+                  'function y = %s(n)\n', ...
+                  '    y = 0;\n', ...
+                  '    for k = 1:n\n', ...
+                  '        z = mod(k, 7);\n', ...
+                  '        z = z * 2;\n', ...
+                  '        if z > 6\n', ...
+                  '            y = y + z;\n', ...
+                  '        end\n', ...
+                  '    end\n' ...
+                 ], funcname);
+
+function t = time_plain(root_dir, funcname, n_iter)
+    orig_path = path();
+    addpath(root_dir);
+    cleaner = onCleanup(@()path(orig_path));
+
+    clock_start = tic();
+    feval(funcname, n_iter);
+    t = toc(clock_start);
+
+function t = time_rewritten(root_dir, funcname, n_iter, probe, granularity)
+    mocov_line_covered([]);
+
+    options = struct();
+    options.probe = probe;
+    options.granularity = granularity;
+    collection = MOcovMFileCollection(root_dir, 'file', ...
+                                      MOcovProgressMonitor(0), {}, options);
+    collection = prepare(collection);
+    cleaner = onCleanup(@()cleanup(collection));
+
+    clock_start = tic();
+    feval(funcname, n_iter);
+    add_lines_executed_count(collection);
+    t = toc(clock_start);
@@ -0,0 +1,142 @@
+function results = bench_mocov_run_all(output_fn, scale)
+    % run all benchmarks and store the results in a machine-readable file
+    %
+    % results=bench_mocov_run_all([output_fn[, scale]])
+    %
+    % Inputs:
+    %   output_fn           optional JSON file to which the results are
+    %                       written. If empty or omitted, no file is written.
+    %   scale               scaling factor for the size of all benchmarks;
+    %                       use a value below 1 for a quick run. Default: 1
+    %
+    % Output:
+    %   results             struct with a field for each benchmark, holding
+    %                       the result of that benchmark
+    %
+    % Notes:
+    %   - the JSON file has general information about the run (MOcov
+    %     version, platform, git commit, date and scale), and a flat object
+    %     "results" with keys of the form "<benchmark>.<measure>", so that
+    %     files for different commits can be compared directly.
+    %   - the .m implementation of mocov_line_covered is benchmarked with
+    %     fewer calls, because it is much slower.
+    %   - this function is used by 'make bench'.
+    %
+    % See also: bench_mocov_line_covered, bench_mocov_probe,
+    %           bench_mocov_pipeline, bench_mocov_dispatch
+
+    if nargin < 1
+        output_fn = '';
+    end
+
+    if nargin < 2
+        scale = 1;
+    end
+
+    n_calls = max(1000, round(1e6 * scale));
+
+    results = struct();
+    if exist('mocov_line_covered', 'file') == 3
+        results.line_covered_mex = bench_mocov_line_covered(n_calls);
+    end
+    n_calls_m = round(n_calls / 10);
+    results.line_covered_m = run_with_m_backend( ...
+                                @()bench_mocov_line_covered(n_calls_m));
+    results.probe = bench_mocov_probe(n_calls);
+    results.pipeline = bench_mocov_pipeline(scale);
+    results.dispatch = bench_mocov_dispatch(scale);
+
+    if ~isempty(output_fn)
+        write_results_json(output_fn, results, scale);
+        fprintf('Benchmark results written to %s\n', output_fn);
+    end
+
+function result = run_with_m_backend(func)
+    % the compiled mocov_line_covered shadows the .m file in the same
+    % directory; a copy of the .m file earlier in the path is used instead
+    mocov_dir = fileparts(which('mocov'));
+    m_fn = fullfile(mocov_dir, 'mocov_line_covered.m');
+
+    temp_dir = tempname();
+    mkdir(temp_dir);
+    copyfile(m_fn, temp_dir);
+
+    orig_path = addpath(temp_dir);
+    cleaner = onCleanup(@()remove_m_backend(orig_path, temp_dir));
+    clear('mocov_line_covered');
+
+    result = func();
+
+function remove_m_backend(orig_path, temp_dir)
+    path(orig_path);
+    clear('mocov_line_covered');
+    delete(fullfile(temp_dir, 'mocov_line_covered.m'));
+    rmdir(temp_dir);
+
+function write_results_json(output_fn, results, scale)
+    fid = fopen(output_fn, 'w');
+    if fid == -1
+        error('Unable to open %s for writing', output_fn);
+    end
+    cleaner = onCleanup(@()fclose(fid));
+
+    if mocov_util_platform_is_octave()
+        platform = 'octave';
+    else
+        platform = 'matlab';
+    end
+
+    fprintf(fid, '{\n');
+    fprintf(fid, '  "format": "mocov-bench-1",\n');
+    fprintf(fid, '  "mocov_version": "%s",\n', mocov_util_version());
+    fprintf(fid, '  "platform": "%s %s",\n', platform, version());
+    fprintf(fid, '  "commit": "%s",\n', get_git_commit());
+    fprintf(fid, '  "date": "%s",\n', datestr(now(), 'yyyy-mm-ddTHH:MM:SS'));
+    fprintf(fid, '  "scale": %g,\n', scale);
+    fprintf(fid, '  "results": {\n');
+
+    [keys, values] = flatten_results(results, '');
+    n = numel(keys);
+    for k = 1:n
+        if k < n
+            separator = ',';
+        else
+            separator = '';
+        end
+        fprintf(fid, '    "%s": %s%s\n', keys{k}, values{k}, separator);
+    end
+
+    fprintf(fid, '  }\n}\n');
+
+function [keys, values] = flatten_results(s, prefix)
+    keys = cell(0, 1);
+    values = cell(0, 1);
+
+    fns = fieldnames(s);
+    for k = 1:numel(fns)
+        fn = fns{k};
+        key = [prefix fn];
+        value = s.(fn);
+
+        if isstruct(value)
+            [sub_keys, sub_values] = flatten_results(value, [key '.']);
+            keys = [keys; sub_keys];
+            values = [values; sub_values];
+        else
+            keys{end + 1, 1} = key;
+            if ischar(value)
+                values{end + 1, 1} = sprintf('"%s"', value);
+            else
+                values{end + 1, 1} = sprintf('%.6g', value);
+            end
+        end
+    end
+
+function commit = get_git_commit()
+    commit = '';
+    mocov_dir = fileparts(which('mocov'));
+    [status, output] = system(sprintf('git -C "%s" rev-parse HEAD', ...
+                                      mocov_dir));
+    if status == 0
+        commit = strtrim(output);
+    end
@@ -0,0 +1,126 @@
+function test_suite = test_mocov_contexts
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function test_line_covered_contexts
+    % Test subject: 'set_context' and 'get_contexts' commands of
+    % `mocov_line_covered`
+
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+
+    mocov_line_covered('register', {'a.m'; 'b.m'}, [10; 10]);
+
+    % lines covered without a context are not attributed
+    mocov_line_covered(1, 1);
+
+    mocov_line_covered('set_context', 't1');
+    mocov_line_covered(1, 2);
+    mocov_line_covered(1, 3);
+    mocov_line_covered(1, 5);
+    mocov_line_covered(2, 4);
+
+    mocov_line_covered('set_context', 't2');
+    mocov_line_covered(1, 2);
+    mocov_line_covered('add', 2, [7 8], [1 0]);
+
+    % continuing a context adds to its lines
+    mocov_line_covered('set_context', 't1');
+    mocov_line_covered(1, 4);
+    mocov_line_covered('set_context', '');
+    mocov_line_covered(1, 9);
+
+    contexts = mocov_line_covered('get_contexts');
+    assertEqual(contexts.names, {'t1'; 't2'});
+    assertEqual(contexts.keys, {'a.m'; 'b.m'});
+    assertEqual(contexts.ranges, [1 1 2 5; ...
+                                  1 2 4 4; ...
+                                  2 1 2 2; ...
+                                  2 2 7 7]);
+
+    % aggregate counts are not affected
+    s = mocov_line_covered();
+    assertEqual(s.line_count{1}(1:5), [1; 2; 1; 1; 1]);
+
+    % setting the state removes all contexts
+    mocov_line_covered([]);
+    contexts = mocov_line_covered('get_contexts');
+    assertTrue(isempty(contexts.names));
+    assertEqual(size(contexts.ranges), [0 4]);
+end
+
+function test_contexts_select
+    % Test subject: `mocov_contexts_select` function
+
+    contexts = struct();
+    contexts.names = {'t1'; 't2'; 't3'};
+    contexts.keys = {'a.m'; 'b.m'};
+    contexts.ranges = [1 1 2 5; ...
+                       2 1 8 9; ...
+                       2 2 1 3; ...
+                       3 2 7 7];
+
+    assertEqual(mocov_contexts_select(contexts, {'a.m', [5 7]}), {'t1'});
+    assertEqual(mocov_contexts_select(contexts, {'a.m', [6 7]}), cell(0, 1));
+    assertEqual(mocov_contexts_select(contexts, {'a.m', [1 1; 9 9]}), ...
+                {'t1'; 't2'});
+    assertEqual(mocov_contexts_select(contexts, {'b.m', []}), {'t2'; 't3'});
+    assertEqual(mocov_contexts_select(contexts, {'a.m', [3 3]; ...
+                                                 'b.m', [7 7]; ...
+                                                 'c.m', []}), ...
+                {'t1'; 't3'});
+
+    % contexts can be read from a file
+    fn = [tempname() '.mat'];
+    cleaner = onCleanup(@()delete(fn));
+    mocov_contexts_save(fn, contexts);
+    assertEqual(mocov_contexts_load(fn), contexts);
+    assertEqual(mocov_contexts_select(fn, {'b.m', [2 2]}), {'t2'});
+end
+
+function result = run_tests_with_contexts(funcname)
+    mocov_set_context('positive');
+    result = feval(funcname, 1);
+    mocov_set_context('negative');
+    result = result + feval(funcname, -1);
+    mocov_set_context('');
+end
+
+function test_mocov_contexts_file
+    % Test subject: '-cover_contexts_file' option of `mocov`
+    root_dir = tempname();
+    mkdir(root_dir);
+    root_cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+    cover_dir = fullfile(root_dir, 'covered');
+    mkdir(cover_dir);
+
+    funcname = sprintf('f_%s', char(96 + ceil(26 * rand(1, 10))));
+    fid = fopen(fullfile(cover_dir, [funcname '.m']), 'w');
+    fprintf(fid, ['function y = %s(x)\n', ...
+                  '    if x > 0\n', ...
+                  '        y = 1;\n', ...
+                  '    else\n', ...
+                  '        y = 2;\n', ...
+                  '    end\n'], funcname);
+    fclose(fid);
+
+    contexts_fn = fullfile(root_dir, 'contexts.mat');
+    for granularity = {'line', 'block'}
+        mocov('-cover', cover_dir, ...
+              '-cover_granularity', granularity{1}, ...
+              '-cover_contexts_file', contexts_fn, ...
+              '-expression', @()run_tests_with_contexts(funcname));
+
+        fn = [funcname '.m'];
+        select = @(lines)mocov_contexts_select(contexts_fn, {fn, lines});
+        assertEqual(select([2 2]), {'positive'; 'negative'});
+        assertEqual(select([3 3]), {'positive'});
+        assertEqual(select([5 5]), {'negative'});
+        assertEqual(select([]), {'positive'; 'negative'});
+    end
+end
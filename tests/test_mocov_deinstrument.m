@@ -0,0 +1,119 @@
+function test_suite = test_mocov_deinstrument
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function write_file(fn, varargin)
+    fid = fopen(fn, 'w');
+    cleaner = onCleanup(@()fclose(fid));
+    fprintf(fid, varargin{:});
+end
+
+function test_line_covered_boolean
+    % Test subject: 'boolean' command of `mocov_line_covered`
+
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+
+    mocov_line_covered('register', {'a.m'; 'b.m'}, [4; 4]);
+    mocov_line_covered(1, 1);
+    mocov_line_covered(1, 1);
+
+    % lines are only recorded as hit; existing counts are kept
+    mocov_line_covered('boolean', true);
+    mocov_line_covered(1, 1);
+    mocov_line_covered(1, 2);
+    mocov_line_covered(1, 2);
+    mocov_line_covered('add', 2, [3 4 3], [5 0 2]);
+
+    s = mocov_line_covered();
+    assertEqual(s.line_count{1}(1:4), [2; 1; 0; 0]);
+    assertEqual(s.line_count{2}(1:4), [0; 0; 1; 0]);
+
+    mocov_line_covered('boolean', false);
+    mocov_line_covered(1, 2);
+    s = mocov_line_covered();
+    assertEqual(s.line_count{1}(2), 2);
+
+    assertExceptionThrown(@()mocov_line_covered('boolean'), '');
+end
+
+function result = run_with_deinstrument(names)
+    % the first file is fully covered by the first call
+    feval(names{1}, 1);
+    feval(names{2}, 1);
+    feval(names{3});
+    result = struct();
+    result.replaced = mocov_deinstrument();
+
+    % the replaced file is the original one, and is used afterwards
+    result.source = fileread(which(names{1}));
+    result.output = feval(names{1}, 1);
+    result.replaced_again = mocov_deinstrument();
+end
+
+function test_mocov_deinstrument_hit_mode
+    % Test subject: '-cover_mode hit' option of `mocov` and
+    % `mocov_deinstrument` function
+    root_dir = tempname();
+    mkdir(root_dir);
+    root_cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+    cover_dir = fullfile(root_dir, 'covered');
+    mkdir(cover_dir);
+
+    prefix = sprintf('f_%s', char(96 + ceil(26 * rand(1, 10))));
+    names = {[prefix '_full'], [prefix '_partial'], [prefix '_persistent']};
+
+    write_file(fullfile(cover_dir, [names{1} '.m']), ...
+               ['function y = %s(x)\n', ...
+                '    y = x + 1;\n'], names{1});
+    write_file(fullfile(cover_dir, [names{2} '.m']), ...
+               ['function y = %s(x)\n', ...
+                '    if x > 0\n', ...
+                '        y = 1;\n', ...
+                '    else\n', ...
+                '        y = 2;\n', ...
+                '    end\n'], names{2});
+    write_file(fullfile(cover_dir, [names{3} '.m']), ...
+               ['function y = %s()\n', ...
+                '    persistent n\n', ...
+                '    y = 1;\n'], names{3});
+
+    xml_fn = fullfile(root_dir, 'coverage.xml');
+    result = mocov('-cover', cover_dir, ...
+                   '-cover_mode', 'hit', ...
+                   '-cover_xml_file', xml_fn, ...
+                   '-expression', @()run_with_deinstrument(names));
+
+    % files that are partially covered or have persistent variables are
+    % not replaced
+    assertEqual(result.replaced, {[names{1} '.m']});
+    assertTrue(isempty(strfind(result.source, 'mocov_line_covered')));
+    assertEqual(result.output, 2);
+    assertTrue(isempty(result.replaced_again));
+
+    metrics = mocov_metrics();
+    assertEqual(metrics.counters.deinstrumented_files, 1);
+end
+
+function test_mocov_cover_mode_exceptions
+    % Test subject: '-cover_mode' option of `mocov`
+    expr = @()disp('');
+    cover_dir = fileparts(mfilename('fullpath'));
+
+    assertExceptionThrown(@()mocov('-cover', cover_dir, ...
+                                   '-cover_mode', 'foo', ...
+                                   '-expression', expr), '');
+    assertExceptionThrown(@()mocov('-cover', cover_dir, ...
+                                   '-cover_mode', 'hit', ...
+                                   '-cover_method', 'timing', ...
+                                   '-expression', expr), '');
+    assertExceptionThrown(@()mocov('-cover', cover_dir, ...
+                                   '-cover_mode', 'hit', ...
+                                   '-cover_contexts_file', 'c.mat', ...
+                                   '-expression', expr), '');
+end
@@ -0,0 +1,58 @@
+function test_suite = test_mocov_find_files
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function root_dir = make_tree(rel_fns)
+    root_dir = tempname();
+    for k = 1:numel(rel_fns)
+        fn = fullfile(root_dir, rel_fns{k});
+        mocov_util_mkdir_recursively(fileparts(fn));
+        fid = fopen(fn, 'w');
+        fclose(fid);
+    end
+end
+
+function assert_found(root_dir, file_pat, exclude_pat, expected_rel_fns)
+    expected = cellfun(@(fn)fullfile(root_dir, fn), expected_rel_fns(:), ...
+                       'UniformOutput', false);
+    found = mocov_find_files(root_dir, file_pat, [], exclude_pat);
+    assertEqual(sort(found), sort(expected));
+end
+
+function test_find_files_patterns
+    % Test subject: `mocov_find_files` and `mocov_util_find_files`
+    % functions
+    rel_fns = {'a.m', 'b.txt', fullfile('sub', 'c.m'), ...
+               fullfile('sub', 'private', 'd.m'), ...
+               fullfile('external', 'lib', 'e.m'), ...
+               fullfile('other', 'external', 'f.m')};
+    root_dir = make_tree(rel_fns);
+    cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+
+    assert_found(root_dir, '*.m', {}, rel_fns([1 3 4 5 6]));
+    assert_found(root_dir, '?.txt', {}, rel_fns(2));
+
+    % patterns without '/' match the name of a file or directory
+    assert_found(root_dir, '*.m', {'private', 'c*'}, rel_fns([1 5 6]));
+    assert_found(root_dir, '*.m', {'external'}, rel_fns([1 3 4]));
+
+    % patterns with '/' match the path relative to the root directory
+    assert_found(root_dir, '*.m', {'external/*'}, rel_fns([1 3 4 6]));
+    assert_found(root_dir, '*.m', {'*/private'}, rel_fns([1 3 5 6]));
+    assert_found(root_dir, '*.m', {'sub/c.m', 'other/external'}, ...
+                 rel_fns([1 4 5]));
+
+    % a single pattern can be given as a string
+    assert_found(root_dir, '*.m', 'sub', rel_fns([1 5 6]));
+
+    found = mocov_util_find_files(root_dir, '*.xyz', {});
+    assertEqual(size(found), [0 1]);
+
+    assertExceptionThrown(@()mocov_util_find_files(fullfile(root_dir, ...
+                                                            'a.m'), ...
+                                                   '*.m', {}), '');
+end
@@ -47,6 +47,206 @@ function test_mocov_line_covered_updates()
     s_actual = mocov_line_covered();
     assert_state_equal(s_actual, s_expected);
 
+function test_mocov_line_covered_register_and_update_by_index()
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+
+    % set state
+    s = get_base_state();
+    mocov_line_covered(s);
+
+    % registering keys already in the state keeps their line counts
+    mocov_line_covered('register', {'a'; 'c'; 'b'});
+
+    mocov_line_covered(1, 4);
+    mocov_line_covered(3, 3);
+    mocov_line_covered(2, 104);
+    mocov_line_covered(2, 104);
+
+    % the form with a filename can still be used
+    mocov_line_covered(3, 'b', 3);
+
+    s_expected = struct();
+    s_expected.keys = {'a'; 'c'; 'b'};
+    s_expected.line_count = {[0; 1; 3; 3; 0]; ...
+                             [0; 10; zeros(101, 1); 2]; ...
+                             [0; 0; 2]};
+    s_actual = mocov_line_covered();
+    assert_state_equal(s_actual, s_expected);
+
+function test_mocov_line_covered_register_with_n_lines()
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+
+    % set state
+    s = get_base_state();
+    mocov_line_covered(s);
+
+    mocov_line_covered('register', {'a'; 'c'; 'b'}, [3; 4; 6]);
+
+    mocov_line_covered(1, 4);
+    mocov_line_covered(2, 4);
+    mocov_line_covered(3, 6);
+
+    % lines beyond the registered number of lines can still be covered
+    mocov_line_covered(3, 20);
+
+    s_expected = struct();
+    s_expected.keys = {'a'; 'c'; 'b'};
+    s_expected.line_count = {[0; 1; 3; 3; 0]; ...
+                             [0; 10; 0; 1]; ...
+                             [0; 0; 0; 0; 0; 1; zeros(13, 1); 1]};
+    s_actual = mocov_line_covered();
+    assert_state_equal(s_actual, s_expected);
+
+    % registering with a wrong number of elements is not allowed
+    assertExceptionThrown(@()mocov_line_covered('register', ...
+                                                {'a'; 'c'; 'b'}, [3; 4]));
+
+function test_mocov_line_covered_add()
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+
+    % set state
+    s = get_base_state();
+    mocov_line_covered(s);
+
+    mocov_line_covered('register', {'a'; 'c'; 'b'});
+
+    % repeated line numbers are counted as often as they occur
+    mocov_line_covered('add', 1, [4 5 4]);
+    mocov_line_covered('add', 2, [2; 12], [3; 5]);
+    mocov_line_covered('add', 3, [], []);
+
+    s_expected = struct();
+    s_expected.keys = {'a'; 'c'; 'b'};
+    s_expected.line_count = {[0; 1; 3; 4; 1]; ...
+                             [0; 13; zeros(9, 1); 5]; ...
+                             []};
+    s_actual = mocov_line_covered();
+    assert_state_equal(s_actual, s_expected);
+
+    invalid_args = {{'add', 1}                 % missing line numbers
+                    {'add', 4, 1}              % file not registered
+                    {'add', 1, [1 0]}          % line number not positive
+                    {'add', 1, [1 2], [1 2 3]} % counts mismatch
+                   };
+    for k = 1:numel(invalid_args)
+        args = invalid_args{k};
+        assertExceptionThrown(@()mocov_line_covered(args{:}));
+    end
+
+function test_mocov_line_covered_add_by_filename()
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+
+    % set state
+    s = get_base_state();
+    mocov_line_covered(s);
+
+    % files are looked up by name, and added if not in the state
+    mocov_line_covered('add', 'c', [2; 4; 2], [1; 3; 2]);
+    mocov_line_covered('add', 'd', [3 1], [2 0]);
+    mocov_line_covered('add', 'd', 3);
+
+    s_expected = struct();
+    s_expected.keys = {'a'; 'c'; 'd'};
+    s_expected.line_count = {[0; 1; 3; 2]; ...
+                             [0; 13; 0; 3]; ...
+                             [0; 0; 3]};
+    s_actual = mocov_line_covered();
+    assert_state_equal(s_actual, s_expected);
+
+    invalid_args = {{'add', 'a', [1 0]}          % line number not positive
+                    {'add', 'a', [1 2], [1 2 3]} % counts mismatch
+                   };
+    for k = 1:numel(invalid_args)
+        args = invalid_args{k};
+        assertExceptionThrown(@()mocov_line_covered(args{:}));
+    end
+
+function test_mocov_line_covered_get_file_and_delta()
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+
+    % set state
+    s = get_base_state();
+    mocov_line_covered(s);
+
+    counts = mocov_line_covered('get_file', 2);
+    assertEqual(counts(counts > 0), 10);
+    counts = mocov_line_covered('get_file', 'a');
+    assertEqual(find(counts), [2; 3; 4]);
+
+    % the first delta has all counted lines
+    delta = mocov_line_covered('get_delta');
+    assertEqual(delta, [1 2 1; 1 3 3; 1 4 2; 2 2 10]);
+    assertEqual(size(mocov_line_covered('get_delta')), [0 3]);
+
+    % afterwards only the lines counted in the meantime
+    mocov_line_covered(2, 'c', 2);
+    mocov_line_covered('add', 1, [1 3 1]);
+    delta = mocov_line_covered('get_delta');
+    assertEqual(delta, [1 1 2; 1 3 1; 2 2 1]);
+
+    invalid_args = {{'get_file', 3}         % index out of range
+                    {'get_file', 'd'}       % file not in the state
+                    {'get_file'}            % missing file
+                    {'get_delta', 1}        % too many inputs
+                   };
+    for k = 1:numel(invalid_args)
+        args = invalid_args{k};
+        assertExceptionThrown(@()mocov_line_covered(args{:}));
+    end
+
+function test_mocov_line_covered_info()
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'a'; 'b'}, [10; 20]);
+    mocov_line_covered(2, 5);
+
+    info = mocov_line_covered('info');
+    assertTrue(any(info.line_count_bits == [8 32 64]));
+    assertTrue(info.bytes_per_line >= info.line_count_bits / 8);
+    assertEqual(info.n_files, 2);
+    assertTrue(info.n_lines >= 30);
+    assertEqual(info.line_bytes, info.n_lines * info.bytes_per_line);
+
+    % counts saturate rather than wrap around (counts of 64 bits, or
+    % doubles in the .m implementation, are not expected to overflow)
+    if info.line_count_bits < 64
+        max_count = 2^info.line_count_bits - 1;
+        mocov_line_covered('add', 1, [3 3], [max_count max_count]);
+        counts = mocov_line_covered('get_file', 1);
+        assertEqual(counts(3), max_count);
+    end
+
+function test_mocov_line_covered_register_exceptions()
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+
+    invalid_args = {{'register', {'not_a'}}  % different file
+                    {'register', 'a'}        % not a cell
+                    {'no_such_command'}      % unknown command
+                    {3, 1}                   % file not registered
+                    {1, 0}                   % line number not positive
+                    {1.5, 1}                 % non-integer
+                   };
+    n = numel(invalid_args);
+    for k = 1:n
+        % set state
+        s_base = get_base_state();
+        mocov_line_covered(s_base);
+        args = invalid_args{k};
+        assertExceptionThrown(@()mocov_line_covered(args{:}));
+
+        % verify state is maintained after exception was raised
+        s_after = mocov_line_covered();
+        assert_state_equal(s_base, s_after);
+    end
+
 function test_mocov_line_covered_exceptions()
     initial_state = mocov_line_covered();
     cleaner = onCleanup(@()mocov_line_covered(initial_state));
@@ -0,0 +1,64 @@
+function test_suite = test_mocov_md5
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function test_md5_known_values
+    % Test subject: `mocov_md5` function
+
+    assertEqual(mocov_md5(''), 'd41d8cd98f00b204e9800998ecf8427e');
+    assertEqual(mocov_md5(uint8([])), 'd41d8cd98f00b204e9800998ecf8427e');
+    assertEqual(mocov_md5('abc'), '900150983cd24fb0d6963f7d28e17f72');
+    assertEqual(mocov_md5('The quick brown fox jumps over the lazy dog'), ...
+                '9e107d9d372bb6826bd81d3542a419d6');
+    assertEqual(mocov_md5(uint8([233 10 255])), ...
+                '0f70c8e8f1f3f44316aa083d4b0f4036');
+end
+
+function test_md5_block_boundaries
+    % Test subject: `mocov_md5` function, with the length of the data
+    % around the size of a block (64 bytes) and of its padding
+
+    expected = {55, '6912ee65fff2d9f9ce2508cddf8bcda0'; ...
+                56, '51fdd1acda72405dfdfa03fcb85896d7'; ...
+                63, '48a6295221902e8e0938f773a7185e72'; ...
+                64, 'b2d3f56bc197fd985d5965079b5e7148'; ...
+                65, '8bd7053801c768420faf816fadba971c'; ...
+                1000, 'cbecbdb0fdd5cec1e242493b6008cc79'};
+
+    for k = 1:size(expected, 1)
+        n = expected{k, 1};
+        data = uint8(mod(0:(n - 1), 256));
+        assertEqual(mocov_md5(data), expected{k, 2});
+        assertEqual(mocov_md5(char(data)), expected{k, 2});
+    end
+end
+
+function test_md5_illegal_input
+    % Test subject: `mocov_md5` function
+
+    assertExceptionThrown(@()mocov_md5(1), '');
+    assertExceptionThrown(@()mocov_md5({'abc'}), '');
+end
+
+function test_mfile_content_hash
+    % Test subject: `get_content_hash` method of `MOcovMFile`
+
+    fn = [tempname() '.m'];
+    fid = fopen(fn, 'w');
+    fprintf(fid, 'x = 1;\ny = 2;\n');
+    fclose(fid);
+    cleaner = onCleanup(@()delete(fn));
+
+    mfile = MOcovMFile(fn);
+    assertEqual(get_content_hash(mfile), mocov_util_md5(fn));
+    assertEqual(get_content_hash(mfile), ...
+                mocov_md5(sprintf('x = 1;\ny = 2;\n')));
+
+    % the checksum is kept when parse information is reused
+    reused = MOcovMFile(fn, get_parse_info(mfile));
+    assertEqual(get_content_hash(reused), get_content_hash(mfile));
+end
@@ -0,0 +1,95 @@
+function test_suite = test_mocov_metrics
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function test_metrics_phases_and_counters
+    % Test subject: `mocov_metrics` function, through the methods of
+    % `MOcovProgressMonitor`
+
+    mocov_metrics('reset');
+    cleaner = onCleanup(@()mocov_metrics('reset'));
+
+    monitor = MOcovProgressMonitor(0);
+    start_phase(monitor, 'first');
+    pause(0.05);
+    stop_phase(monitor, 'first');
+    start_phase(monitor, 'second');
+    stop_phase(monitor, 'second');
+
+    % phases that are started again add to their time
+    start_phase(monitor, 'first');
+    stop_phase(monitor, 'first');
+
+    add_count(monitor, 'files', 2);
+    add_count(monitor, 'files', 3);
+
+    metrics = mocov_metrics();
+    assertEqual(fieldnames(metrics.phases), {'first'; 'second'});
+    assertTrue(metrics.phases.first >= 0.04);
+    assertEqual(metrics.counters.files, 5);
+
+    assertExceptionThrown(@()stop_phase(monitor, 'third'), '');
+
+    mocov_metrics('reset');
+    metrics = mocov_metrics();
+    assertTrue(isempty(fieldnames(metrics.phases)));
+    assertTrue(isempty(fieldnames(metrics.counters)));
+end
+
+function test_monitor_quiet
+    % Test subject: `notify` and `is_notifying` methods of
+    % `MOcovProgressMonitor`
+
+    monitor = MOcovProgressMonitor(0);
+    assertFalse(is_notifying(monitor));
+    assertEqual(evalc('notify(monitor, ''hello'')'), '');
+
+    monitor = MOcovProgressMonitor(1);
+    assertTrue(is_notifying(monitor));
+    assertEqual(evalc('notify(monitor, ''hello'')'), sprintf('hello\n'));
+end
+
+function test_mocov_metrics_json_file
+    % Test subject: '-metrics_json_file' option of `mocov`
+    root_dir = tempname();
+    mkdir(root_dir);
+    root_cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+    cover_dir = fullfile(root_dir, 'covered');
+    mkdir(cover_dir);
+
+    funcname = sprintf('f_%s', char(96 + ceil(26 * rand(1, 10))));
+    fid = fopen(fullfile(cover_dir, [funcname '.m']), 'w');
+    fprintf(fid, ['function y = %s(x)\n', ...
+                  '    y = x + 1;\n'], funcname);
+    fclose(fid);
+
+    xml_fn = fullfile(root_dir, 'coverage.xml');
+    metrics_fn = fullfile(root_dir, 'metrics.json');
+    mocov('-cover', cover_dir, ...
+          '-cover_xml_file', xml_fn, ...
+          '-metrics_json_file', metrics_fn, ...
+          '-expression', @()feval(funcname, 1));
+
+    metrics = mocov_metrics();
+    phases = {'find', 'parse', 'rewrite', 'addpath', 'run', 'collect', ...
+              'write_cover_xml_file'};
+    assertTrue(all(isfield(metrics.phases, phases)));
+    assertEqual(metrics.counters.files, 1);
+    assertEqual(metrics.counters.lines, 3);
+    assertEqual(metrics.counters.executable_lines, 1);
+    assertEqual(metrics.counters.probe_hits, 1);
+    d = dir(xml_fn);
+    assertEqual(metrics.counters.bytes_cover_xml_file, d.bytes);
+
+    fid = fopen(metrics_fn);
+    json_cleaner = onCleanup(@()fclose(fid));
+    json = fread(fid, inf, 'char=>char')';
+    for k = 1:numel(phases)
+        assertFalse(isempty(strfind(json, sprintf('"%s": ', phases{k}))));
+    end
+    assertFalse(isempty(strfind(json, '"files": 1')));
+end
@@ -0,0 +1,79 @@
+function test_suite = test_mocov_mfile_block_granularity
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function filepath = create_function_file()
+    % Creates a temporary file with a function with some control flow
+
+    funcname = ['f', char(96 + ceil(26 * rand(1, 20)))];
+    filepath = fullfile(tempdir, [funcname '.m']);
+    fid = fopen(filepath, 'w');
+    fprintf(fid, [ ...
+                  'function y = %s(x)\n', ...     % 1
+                  '    y = 0;\n', ...             % 2
+                  '    z = 1; %% comment\n', ...  % 3
+                  '    if x > z\n', ...           % 4
+                  '        y = 1;\n', ...         % 5
+                  '\n', ...                       % 6
+                  '        y = y + 1;\n', ...     % 7
+                  '    else\n', ...               % 8
+                  '        y = 2;\n', ...         % 9
+                  '    end\n', ...                % 10
+                  '    y = y * 2;\n', ...         % 11
+                  '    return\n', ...             % 12
+                  '    y = 3;\n' ...              % 13
+                 ], funcname);
+    fclose(fid);
+end
+
+function test_block_leader
+    % Test subject: `MOcovMFile` constructor
+
+    tempfile = create_function_file();
+    teardown = onCleanup(@() delete(tempfile));
+
+    mfile = MOcovMFile(tempfile);
+    leader = get_lines_block_leader(mfile);
+
+    expected_leader = [0; 2; 2; 2; 5; 0; 5; 0; 9; 0; 11; 11; 13; 0];
+    assertEqual(leader, expected_leader);
+end
+
+function test_block_counts_are_expanded
+    % Test subject: `add_lines_executed_count` method
+
+    tempfile = create_function_file();
+    teardown = onCleanup(@() delete(tempfile));
+
+    mfile = MOcovMFile(tempfile);
+    block_counts = [0; 3; 0; 0; 2; 0; 0; 0; 1; 0; 3];
+    mfile = add_lines_executed_count(mfile, block_counts, 'block');
+
+    expected_count = [0; 3; 3; 3; 2; 0; 2; 0; 1; 0; 3; 3; 0; 0];
+    assertEqual(get_lines_executed_count(mfile), expected_count);
+end
+
+function test_only_block_leaders_are_decorated
+    % Test subject: `write_lines_with_prefix` method
+
+    tempfile = create_function_file();
+    teardown = onCleanup(@() delete(tempfile));
+
+    outfile = [tempname() '.m'];
+    teardown_out = onCleanup(@() delete(outfile));
+
+    mfile = MOcovMFile(tempfile);
+    decorator = @(line_number) sprintf('abs(%d);', line_number);
+    write_lines_with_prefix(mfile, outfile, decorator, 'block');
+
+    decorated_mfile = MOcovMFile(outfile);
+    lines = get_lines(decorated_mfile);
+    for k = 1:numel(lines)
+        is_decorated = ~isempty(strfind(lines{k}, sprintf('abs(%d);', k)));
+        assertEqual(is_decorated, any(k == [2, 5, 9, 11, 13]));
+    end
+end
@@ -0,0 +1,104 @@
+function test_suite = test_mocov_mfile_collection
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function write_file(fn, contents)
+    fid = fopen(fn, 'w');
+    fprintf(fid, '%s', contents);
+    fclose(fid);
+end
+
+function test_get_mfile_by_name
+    % Test subject: `get_mfile` method of `MOcovMFileCollection`
+
+    root_dir = tempname();
+    mkdir(root_dir);
+    dir_cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+    mkdir(fullfile(root_dir, 'sub'));
+
+    write_file(fullfile(root_dir, 'a.m'), sprintf('x = 1;\n'));
+    write_file(fullfile(root_dir, 'sub', 'b.m'), sprintf('y = 2;\nz = 3;\n'));
+
+    collection = MOcovMFileCollection(root_dir, 'file', ...
+                                      MOcovProgressMonitor(0));
+    collection = load_mfiles(collection);
+    assertEqual(count_mfiles(collection), 2);
+
+    rel_fns = {'a.m', fullfile('sub', 'b.m')};
+    for k = 1:numel(rel_fns)
+        rel_fn = rel_fns{k};
+        [mfile, idx] = get_mfile(collection, rel_fn);
+        assertEqual(get_filename(mfile), ...
+                    mocov_get_absolute_path(fullfile(root_dir, rel_fn)));
+        assertEqual(get_filename(get_mfile(collection, idx)), ...
+                    get_filename(mfile));
+    end
+
+    % names that are not in canonical form are found as well
+    [unused, idx] = get_mfile(collection, fullfile('sub', '..', 'a.m'));
+    assertEqual(idx, get_mfile_index(collection, 'a.m'));
+
+    assertExceptionThrown(@()get_mfile(collection, 'c.m'), '');
+end
+
+function idx = get_mfile_index(collection, rel_fn)
+    [unused, idx] = get_mfile(collection, rel_fn);
+end
+
+function dirs = get_added_path_dirs(orig_path)
+    dirs = setdiff(regexp(path(), pathsep(), 'split'), ...
+                   regexp(orig_path, pathsep(), 'split'));
+    dirs = sort(dirs(:));
+end
+
+function test_prepare_adds_original_path_layout
+    % Test subject: `prepare` and `get_rewritten_path` methods of
+    % `MOcovMFileCollection`
+    initial_state = mocov_line_covered();
+    state_cleaner = onCleanup(@()mocov_line_covered(initial_state));
+
+    orig_path = path();
+    path_cleaner = onCleanup(@()path(orig_path));
+
+    root_dir = tempname();
+    mkdir(root_dir);
+    dir_cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+
+    rel_dirs = {'sub', fullfile('sub', 'private'), '@cls', '+pkg', 'other'};
+    for k = 1:numel(rel_dirs)
+        mkdir(fullfile(root_dir, rel_dirs{k}));
+        write_file(fullfile(root_dir, rel_dirs{k}, sprintf('f%d.m', k)), ...
+                   sprintf('x = %d;\n', k));
+    end
+    write_file(fullfile(root_dir, 'a.m'), sprintf('x = 1;\n'));
+
+    % only directories that are in the original path are added
+    addpath(fullfile(root_dir, 'sub'));
+    sub_path = path();
+
+    collection = MOcovMFileCollection(root_dir, 'file', ...
+                                      MOcovProgressMonitor(0));
+    collection = prepare(collection);
+    dirs = get_added_path_dirs(sub_path);
+    cleanup(collection);
+
+    assertEqual(numel(dirs), 1);
+    assertEqual(dirs{1}((end - 3):end), [filesep() 'sub']);
+    assertEqual(path(), sub_path);
+
+    % without such directories, all directories that can be in the path
+    path(orig_path);
+    collection = MOcovMFileCollection(root_dir, 'file', ...
+                                      MOcovProgressMonitor(0));
+    collection = prepare(collection);
+    dirs = get_added_path_dirs(orig_path);
+    cleanup(collection);
+
+    assertEqual(numel(dirs), 3);
+    assertEqual(dirs(2:3), {fullfile(dirs{1}, 'other'); ...
+                            fullfile(dirs{1}, 'sub')});
+end
@@ -0,0 +1,62 @@
+function test_suite = test_mocov_mfile_lazy_lines
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function fn = write_mfile(contents)
+    fn = [tempname() '.m'];
+    fid = fopen(fn, 'w');
+    fprintf(fid, '%s', contents);
+    fclose(fid);
+end
+
+function test_lines_are_read_from_file
+    % Test subject: `get_lines` and `get_parse_info` methods of
+    % `MOcovMFile`
+
+    contents = sprintf('function y = f(x)\n    y = x;\n\n%% 100%%\n');
+    fn = write_mfile(contents);
+    cleaner = onCleanup(@()delete(fn));
+
+    mfile = MOcovMFile(fn);
+    expected = {'function y = f(x)'; '    y = x;'; ''; '% 100%'; ''};
+    assertEqual(get_lines(mfile), expected);
+    assertEqual(get_text(mfile), contents);
+
+    % the lines themselves are not kept
+    parse_info = get_parse_info(mfile);
+    assertFalse(isfield(parse_info, 'lines'));
+    assertEqual(get_lines(MOcovMFile(fn, parse_info)), expected);
+
+    % parse information stored by an earlier version has the lines
+    parse_info = rmfield(parse_info, 'line_offsets');
+    parse_info.lines = expected';
+    assertEqual(get_lines(MOcovMFile(fn, parse_info)), expected);
+
+    % lines of a file that changed after parsing are not returned
+    fid = fopen(fn, 'w');
+    fprintf(fid, 'x = 1;\n');
+    fclose(fid);
+    assertExceptionThrown(@()get_lines(mfile), '');
+end
+
+function test_rewritten_file_keeps_contents
+    % Test subject: `write_lines_with_prefix` method of `MOcovMFile`
+
+    contents = sprintf('function y = f(x)\n    y = x;\n    y = y + 1;\n');
+    fn = write_mfile(contents);
+    cleaner = onCleanup(@()delete(fn));
+
+    out_fn = [tempname() '.m'];
+    out_cleaner = onCleanup(@()delete(out_fn));
+
+    mfile = MOcovMFile(fn);
+    write_lines_with_prefix(mfile, out_fn, @(k)sprintf('p(%d);', k));
+    assertEqual(fileread(out_fn), ...
+                sprintf(['function y = f(x)\n', ...
+                         'p(2);    y = x;\n', ...
+                         'p(3);    y = y + 1;\n']));
+end
@@ -0,0 +1,134 @@
+function test_suite = test_mocov_probe_buffer
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function funcname = create_function_file(root_dir)
+    % Creates a file with a function with a loop and a subfunction
+
+    funcname = ['f', char(96 + ceil(26 * rand(1, 20)))];
+    fid = fopen(fullfile(root_dir, [funcname '.m']), 'w');
+    fprintf(fid, [ ...
+                  'function y = %s(n)\n', ...     % 1
+                  '    y = 0;\n', ...             % 2
+                  '    for k = 1:n\n', ...        % 3
+                  '        y = y + k;\n', ...     % 4
+                  '    end\n', ...                % 5
+                  '    y = helper(y);\n', ...     % 6
+                  '\n', ...                       % 7
+                  'function z = helper(y)\n', ... % 8
+                  '    z = -y;\n' ...             % 9
+                 ], funcname);
+    fclose(fid);
+end
+
+function test_buffer_probe_counts_executed_lines
+    % Test subject: 'buffer' probe of `MOcovMFileCollection`
+
+    initial_state = mocov_line_covered();
+    state_cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+
+    root_dir = tempname();
+    mkdir(root_dir);
+    dir_cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+    funcname = create_function_file(root_dir);
+
+    options = struct();
+    options.probe = 'buffer';
+    collection = MOcovMFileCollection(root_dir, 'file', ...
+                                      MOcovProgressMonitor(0), {}, options);
+    collection = prepare(collection);
+    collection_cleaner = onCleanup(@()cleanup(collection));
+
+    assertEqual(feval(funcname, 3), -6);
+    assertEqual(feval(funcname, 2), -3);
+
+    collection = add_lines_executed_count(collection);
+    mfile = get_mfile(collection, 1);
+    count = get_lines_executed_count(mfile);
+
+    assertEqual(count([2 3 4 6 9])', [2 2 5 2 2]);
+    assertEqual(count([1 5 7 8])', [0 0 0 0]);
+end
+
+function test_buffer_probe_with_nested_function
+    % Test subject: 'buffer' probe of `MOcovMFileCollection`, for a file
+    % with a nested function, which cannot declare a global variable
+
+    initial_state = mocov_line_covered();
+    state_cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+
+    root_dir = tempname();
+    mkdir(root_dir);
+    dir_cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+
+    funcname = ['f', char(96 + ceil(26 * rand(1, 20)))];
+    fid = fopen(fullfile(root_dir, [funcname '.m']), 'w');
+    fprintf(fid, [ ...
+                  'function y = %s(n)\n', ...     % 1
+                  '    y = 0;\n', ...             % 2
+                  '    function add(k)\n', ...    % 3
+                  '        y = y + k;\n', ...     % 4
+                  '    end\n', ...                % 5
+                  '    for k = 1:n\n', ...        % 6
+                  '        add(k);\n', ...        % 7
+                  '    end\n', ...                % 8
+                  'end\n' ...                     % 9
+                 ], funcname);
+    fclose(fid);
+
+    options = struct();
+    options.probe = 'buffer';
+    collection = MOcovMFileCollection(root_dir, 'file', ...
+                                      MOcovProgressMonitor(0), {}, options);
+    collection = prepare(collection);
+    collection_cleaner = onCleanup(@()cleanup(collection));
+
+    assertEqual(feval(funcname, 3), 6);
+
+    collection = add_lines_executed_count(collection);
+    mfile = get_mfile(collection, 1);
+    count = get_lines_executed_count(mfile);
+
+    assertEqual(count([2 4 6 7])', [1 3 1 3]);
+    assertEqual(count([1 3 5 8 9])', [0 0 0 0 0]);
+end
+
+function test_buffer_flush_warns_for_cleared_buffer
+    % Test subject: 'flush' command of `mocov_line_buffer`, after a line
+    % buffer was cleared
+
+    initial_state = mocov_line_covered();
+    state_cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'a.m'; 'b.m'}, [3; 3]);
+
+    mocov_line_buffer('init', [3; 3]);
+    buffer_cleaner = onCleanup(@()mocov_line_buffer('clear'));
+
+    names = {mocov_line_buffer('name', 1), mocov_line_buffer('name', 2)};
+    eval(sprintf('global %s %s', names{:}));
+    eval(sprintf('%s(2) = 4; %s(3) = 5;', names{:}));
+
+    % as by 'clear global' for the second buffer only
+    if mocov_util_platform_is_octave()
+        clear('-global', names{2});
+    else
+        clear('global', names{2});
+    end
+
+    lastwarn('');
+    mocov_line_buffer('flush');
+    [unused, warning_id] = lastwarn();
+    assertEqual(warning_id, 'mocov:line_buffer_cleared');
+
+    % counts of the other buffer are kept
+    counts = mocov_line_covered('get_file', 1);
+    assertEqual(counts(1:3), [0; 4; 0]);
+    assertEqual(find(mocov_line_covered('get_file', 2)), zeros(0, 1));
+end
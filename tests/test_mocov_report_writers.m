@@ -0,0 +1,114 @@
+function test_suite = test_mocov_report_writers
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function write_file(fn, s)
+    fid = fopen(fn, 'w');
+    cleaner = onCleanup(@()fclose(fid));
+    fprintf(fid, '%s', s);
+end
+
+function test_report_writers_stream_all_mfiles
+    % Test subject: `write_xml_file` and `write_json_file` methods of
+    % `MOcovMFileCollection`
+    initial_state = mocov_line_covered();
+    state_cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+
+    root_dir = tempname();
+    mkdir(root_dir);
+    root_cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+
+    suffix = char(96 + ceil(26 * rand(1, 10)));
+    covered_name = ['covered_' suffix];
+    empty_name = ['empty_' suffix];
+    write_file(fullfile(root_dir, [covered_name '.m']), ...
+               sprintf('function y = %s(x)\n    y = x + 1;\n', covered_name));
+    write_file(fullfile(root_dir, [empty_name '.m']), ...
+               sprintf('function %s()\n', empty_name));
+
+    collection = MOcovMFileCollection(root_dir, 'file', ...
+                                      MOcovProgressMonitor(0));
+    collection = prepare(collection);
+    collection_cleaner = onCleanup(@()cleanup(collection));
+
+    func = str2func(covered_name);
+    func(1);
+    collection = add_lines_executed_count(collection);
+
+    % XML report has all executable lines, and none for the empty file
+    xml_fn = fullfile(root_dir, 'coverage.xml');
+    write_xml_file(collection, xml_fn);
+    xml = fileread(xml_fn);
+
+    assertEqual(numel(strfind(xml, '<class ')), 2);
+    assertEqual(numel(strfind(xml, '<line ')), 1);
+    assertFalse(isempty(strfind(xml, ...
+                                '<line number="2" hits="1" branch="false"/>')));
+    assertFalse(isempty(strfind(xml, sprintf('<lines>\n</lines>'))));
+    assertFalse(isempty(regexp(xml, '</coverage>\s*$', 'once')));
+
+    % JSON report written to a file is the same as when built in memory
+    json_fn = fullfile(root_dir, 'coverage.json');
+    write_json_file(collection, json_fn);
+    json = fileread(json_fn);
+
+    assertEqual(json, get_coverage_json(collection));
+    assertFalse(isempty(strfind(json, '"coverage": [null,1,null]')));
+    assertFalse(isempty(strfind(json, '"coverage": [null,null]')));
+end
+
+function test_html_dir_writes_changed_pages_only
+    % Test subject: `write_html_dir` and `get_html_page_names` methods of
+    % `MOcovMFileCollection`
+    initial_state = mocov_line_covered();
+    state_cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+
+    root_dir = tempname();
+    mkdir(root_dir);
+    root_cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+    cover_dir = fullfile(root_dir, 'covered');
+    mkdir(fullfile(cover_dir, '+pkg'));
+    html_dir = fullfile(root_dir, 'html');
+
+    write_file(fullfile(cover_dir, 'a_b.m'), sprintf('x = 1;\n'));
+    write_file(fullfile(cover_dir, '+pkg', 'c.m'), sprintf('y = 2;\n'));
+
+    collection = MOcovMFileCollection(cover_dir, 'file', ...
+                                      MOcovProgressMonitor(0));
+    collection = load_mfiles(collection);
+
+    % names are derived from the paths, not from the order of the files
+    page_names = sort(get_html_page_names(collection));
+    assertEqual(page_names, {'-2Bpkg--c.m.html'; 'a_b.m.html'});
+
+    write_html_dir(collection, html_dir);
+    page_fn = fullfile(html_dir, 'a_b.m.html');
+    other_page_fn = fullfile(html_dir, '-2Bpkg--c.m.html');
+    assertFalse(isempty(strfind(fileread(page_fn), 'x&nbsp;=&nbsp;1;')));
+    assertTrue(exist(other_page_fn, 'file') > 0);
+
+    % unchanged pages are not written again
+    write_file(page_fn, 'unchanged');
+    write_html_dir(collection, html_dir);
+    assertEqual(fileread(page_fn), 'unchanged');
+
+    % pages of removed files are deleted, and changed pages written
+    delete(fullfile(cover_dir, '+pkg', 'c.m'));
+    write_file(fullfile(cover_dir, 'a_b.m'), sprintf('x = 3;\n'));
+    collection = MOcovMFileCollection(cover_dir, 'file', ...
+                                      MOcovProgressMonitor(0));
+    collection = load_mfiles(collection);
+    write_html_dir(collection, html_dir);
+
+    assertFalse(isempty(strfind(fileread(page_fn), 'x&nbsp;=&nbsp;3;')));
+    assertFalse(exist(other_page_fn, 'file') > 0);
+    assertFalse(isempty(strfind(fileread(fullfile(html_dir, ...
+                                                  'index.html')), ...
+                                'a_b.m.html')));
+end
@@ -0,0 +1,118 @@
+function test_suite = test_mocov_rewrite_cache
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function write_function_file(fn, funcname, value)
+    fid = fopen(fn, 'w');
+    fprintf(fid, [ ...
+                  'function y = %s()\n', ...
+                  '    y = %d;\n' ...
+                 ], funcname, value);
+    fclose(fid);
+end
+
+function lines = read_rewritten_file(collection, funcname)
+    % prepare the collection, and read the file that is used instead of
+    % the original one
+    collection = prepare(collection);
+    cleaner = onCleanup(@()cleanup(collection));
+    lines = fileread(which(funcname));
+end
+
+function append_to_file(fn, str)
+    fid = fopen(fn, 'a');
+    fprintf(fid, '%s', str);
+    fclose(fid);
+end
+
+function test_unchanged_files_are_reused_from_cache
+    % Test subject: `cache_dir` option of `MOcovMFileCollection`
+
+    initial_state = mocov_line_covered();
+    state_cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+
+    root_dir = tempname();
+    mkdir(root_dir);
+    root_cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+
+    cache_dir = tempname();
+    mkdir(cache_dir);
+    cache_cleaner = onCleanup(@()mocov_util_rmdir_recursively(cache_dir));
+
+    funcname = ['f', char(96 + ceil(26 * rand(1, 20)))];
+    fn = fullfile(root_dir, [funcname '.m']);
+    write_function_file(fn, funcname, 1);
+
+    options = struct();
+    options.cache_dir = cache_dir;
+    collection = MOcovMFileCollection(root_dir, 'file', ...
+                                      MOcovProgressMonitor(0), {}, options);
+
+    % first run fills the cache
+    read_rewritten_file(collection, funcname);
+    version_dir = fullfile(cache_dir, ['mocov-' mocov_util_version()]);
+    assertEqual(numel(dir(fullfile(version_dir, '*.mat'))), 1);
+    cached_mfiles = dir(fullfile(version_dir, '*.m'));
+    assertEqual(numel(cached_mfiles), 1);
+
+    % the second run uses the cached rewritten file
+    marker = '% from cache';
+    append_to_file(fullfile(version_dir, cached_mfiles(1).name), marker);
+    lines = read_rewritten_file(collection, funcname);
+    assertFalse(isempty(strfind(lines, marker)));
+
+    % after changing the file, it is rewritten again
+    write_function_file(fn, funcname, 2);
+    lines = read_rewritten_file(collection, funcname);
+    assertTrue(isempty(strfind(lines, marker)));
+    assertFalse(isempty(strfind(lines, 'y = 2;')));
+    assertEqual(numel(dir(fullfile(version_dir, '*.m'))), 2);
+end
+
+function test_cached_files_do_not_depend_on_index
+    % Test subject: `cache_dir` option of `MOcovMFileCollection`, when
+    % files are added
+
+    initial_state = mocov_line_covered();
+    state_cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+
+    root_dir = tempname();
+    mkdir(root_dir);
+    root_cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+
+    cache_dir = tempname();
+    mkdir(cache_dir);
+    cache_cleaner = onCleanup(@()mocov_util_rmdir_recursively(cache_dir));
+
+    funcname = ['f', char(96 + ceil(26 * rand(1, 20)))];
+    write_function_file(fullfile(root_dir, [funcname '.m']), funcname, 1);
+
+    options = struct();
+    options.cache_dir = cache_dir;
+    collection = MOcovMFileCollection(root_dir, 'file', ...
+                                      MOcovProgressMonitor(0), {}, options);
+
+    read_rewritten_file(collection, funcname);
+    version_dir = fullfile(cache_dir, ['mocov-' mocov_util_version()]);
+    cached_mfiles = dir(fullfile(version_dir, '*.m'));
+    assertEqual(numel(cached_mfiles), 1);
+
+    marker = '% from cache';
+    append_to_file(fullfile(version_dir, cached_mfiles(1).name), marker);
+
+    % a file that comes first changes the index of the other file, but
+    % its cached rewritten file is still used
+    other_funcname = ['a', funcname];
+    write_function_file(fullfile(root_dir, [other_funcname '.m']), ...
+                        other_funcname, 2);
+    lines = read_rewritten_file(collection, funcname);
+    assertFalse(isempty(strfind(lines, marker)));
+    assertTrue(isempty(regexp(lines, '[0-9a-f]{32}', 'once')));
+    assertEqual(numel(dir(fullfile(version_dir, '*.m'))), 2);
+end
@@ -0,0 +1,82 @@
+function test_suite = test_mocov_run_jobs
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function test_run_jobs_outputs
+    % Test subject: `mocov_run_jobs` function
+
+    job_args = {{ones(2, 3)}; {ones(4, 1)}; {'abc'}};
+    outputs = mocov_run_jobs(2, 'size', {}, job_args, 2);
+
+    assertEqual(size(outputs), [3 1]);
+    assertEqual(outputs{1}, {2, 3});
+    assertEqual(outputs{2}, {4, 1});
+    assertEqual(outputs{3}, {1, 3});
+
+    % shared arguments come first
+    outputs = mocov_run_jobs(2, 'minus', {10}, {{1}; {2}}, 1);
+    assertEqual(outputs, {{9}; {8}});
+end
+
+function test_run_jobs_raises_error
+    % Test subject: `mocov_run_jobs` function
+
+    job_args = {{'first problem'}; {'mocov:test', 'second problem'}};
+    assertExceptionThrown(@()mocov_run_jobs(2, 'error', {}, job_args, 0));
+end
+
+function test_run_jobs_merges_metrics
+    % Test subject: `mocov_run_jobs` function
+
+    mocov_metrics('reset');
+    cleaner = onCleanup(@()mocov_metrics('reset'));
+
+    % counters added by the jobs are added up, whether or not the jobs
+    % ran in another process
+    job_args = {{'add', 'job_counter', 1}; {'add', 'job_counter', 2}};
+    mocov_run_jobs(2, 'mocov_metrics', {}, job_args, 0);
+
+    metrics = mocov_metrics();
+    assertEqual(metrics.counters.job_counter, 3);
+end
+
+function test_collection_with_jobs_gives_same_report
+    % Test subject: `jobs` option of `MOcovMFileCollection`
+
+    initial_state = mocov_line_covered();
+    state_cleaner = onCleanup(@()mocov_line_covered(initial_state));
+
+    root_dir = tempname();
+    mkdir(root_dir);
+    root_cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+
+    for k = 1:3
+        funcname = sprintf('f%d_%s', k, char(96 + ceil(26 * rand(1, 10))));
+        fid = fopen(fullfile(root_dir, [funcname '.m']), 'w');
+        fprintf(fid, 'function y = %s(x)\n    y = x + %d;\n', funcname, k);
+        fclose(fid);
+    end
+
+    reports = cell(2, 1);
+    for jobs = 1:2
+        mocov_line_covered([]);
+        options = struct();
+        options.jobs = jobs;
+        collection = MOcovMFileCollection(root_dir, 'file', ...
+                                          MOcovProgressMonitor(0), {}, ...
+                                          options);
+        collection = prepare(collection);
+        collection_cleaner = onCleanup(@()cleanup(collection));
+
+        xml_fn = fullfile(root_dir, sprintf('coverage%d.xml', jobs));
+        write_xml_file(collection, xml_fn);
+        reports{jobs} = fileread(xml_fn);
+        clear collection_cleaner;
+    end
+
+    assertEqual(reports{1}, reports{2});
+end
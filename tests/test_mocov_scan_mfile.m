@@ -0,0 +1,107 @@
+function test_suite = test_mocov_scan_mfile
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function s = get_contents()
+    s = sprintf([ ...
+                 'function [a, b] = f(x, ...\n', ...            % 1
+                 '                     y)\n', ...               % 2
+                 '    s = ''if %% not a comment'';\n', ...      % 3
+                 '    t = "end";   %% comment with end\n', ...  % 4
+                 '    if x > 1, a = 1; end\n', ...              % 5
+                 '    a = s.return;\n', ...                     % 6
+                 '    b = [1, 2, ...\n', ...                    % 7
+                 '         3];\n', ...                          % 8
+                 '    switch a\n', ...                          % 9
+                 '        case 1\n', ...                        % 10
+                 '            b = 2;\n', ...                    % 11
+                 '        otherwise\n', ...                     % 12
+                 '            b = 3;\n', ...                    % 13
+                 '    end\n', ...                               % 14
+                 'end\n' ...                                    % 15
+                ]);
+end
+
+function test_scan_mfile_classifies_lines
+    [executable, function_start, has_code, has_control_flow] = ...
+                                        mocov_scan_mfile(get_contents());
+
+    % the line after the last newline is empty
+    assertEqual(executable', [0 0 1 1 1 1 1 0 1 0 1 1 1 0 0 0] == 1);
+    assertEqual(function_start', [1 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0] == 1);
+    assertEqual(has_code', [1 1 1 1 1 1 1 1 1 1 1 1 1 1 1 0] == 1);
+
+    % strings and comments are considered as well, so 'if' on line 3
+    % counts, but a field named 'return' on line 6 does not
+    assertEqual(has_control_flow', ...
+                [1 0 1 1 1 0 0 0 1 1 0 1 0 1 1 0] == 1);
+end
+
+function test_scan_mfile_empty
+    [executable, function_start, has_code, has_control_flow] = ...
+                                                    mocov_scan_mfile('');
+    assertEqual(executable, false);
+    assertEqual(function_start, false);
+    assertEqual(has_code, false);
+    assertEqual(has_control_flow, false);
+end
+
+function test_scan_mfile_mex_and_m_file_agree
+    % the compiled and .m implementations must classify lines identically
+    if exist('mocov_scan_mfile', 'file') ~= 3
+        moxunit_throw_test_skipped_exception('mex file not compiled');
+    end
+
+    [m_scan, cleaner] = get_m_file_scanner();
+
+    test_dir = fileparts(mfilename('fullpath'));
+    mocov_dir = fileparts(which('mocov'));
+    fns = [mocov_find_files(mocov_dir, '*.m'); ...
+           mocov_find_files(test_dir, '*.m')];
+
+    contents = cellfun(@read_file, fns, 'UniformOutput', false);
+    contents{end + 1} = get_contents();
+
+    for k = 1:numel(contents)
+        s = contents{k};
+        expected = cell(1, 4);
+        result = cell(1, 4);
+        [expected{:}] = m_scan(s);
+        [result{:}] = mocov_scan_mfile(s);
+        assertEqual(result, expected);
+    end
+end
+
+function s = read_file(fn)
+    fid = fopen(fn);
+    cleaner = onCleanup(@()fclose(fid));
+    s = fread(fid, inf, 'char=>char')';
+end
+
+function [m_scan, cleaner] = get_m_file_scanner()
+    % the mex file shadows mocov_scan_mfile.m, therefore a copy of the .m
+    % file with a different name is used
+    mocov_dir = fileparts(which('mocov'));
+    s = read_file(fullfile(mocov_dir, 'mocov_scan_mfile.m'));
+
+    temp_dir = tempname();
+    mkdir(temp_dir);
+    name = ['mocov_scan_mfile_m_' char(96 + ceil(26 * rand(1, 10)))];
+    fid = fopen(fullfile(temp_dir, [name '.m']), 'w');
+    fprintf(fid, '%s', strrep(s, 'mocov_scan_mfile(s)', [name '(s)']));
+    fclose(fid);
+
+    orig_path = addpath(temp_dir);
+    cleaner = onCleanup(@()remove_scanner(orig_path, temp_dir));
+    m_scan = str2func(name);
+end
+
+function remove_scanner(orig_path, temp_dir)
+    path(orig_path);
+    delete(fullfile(temp_dir, '*.m'));
+    rmdir(temp_dir);
+end
@@ -0,0 +1,181 @@
+function test_suite = test_mocov_shared_counters
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function skip_if_unsupported()
+    if ~mocov_util_platform_is_octave() || ~isunix()
+        moxunit_throw_test_skipped_exception(['shared counters are only '...
+                                              'tested on GNU Octave on '...
+                                              'unix-like platforms']);
+    end
+
+    if exist('mocov_line_covered') ~= 3
+        moxunit_throw_test_skipped_exception('mex file not compiled');
+    end
+end
+
+function octave_bin = get_octave_binary()
+    octave_bin = fullfile(OCTAVE_HOME(), 'bin', 'octave-cli');
+    if ~exist(octave_bin, 'file')
+        octave_bin = 'octave-cli';
+    end
+end
+
+function test_shared_counters_concurrent_writers
+    % Test subject: 'share' and 'unshare' commands of `mocov_line_covered`,
+    % with several processes recording lines at the same time
+    skip_if_unsupported();
+
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+
+    fn = tempname();
+    file_cleaner = onCleanup(@()delete(fn));
+
+    mocov_line_covered('register', {'a.m'; 'b.m'}, [4; 4]);
+    mocov_line_covered(1, 2);
+    mocov_line_covered('share', fn);
+
+    % each process attaches to the shared counts when it first records a
+    % line, and records lines one at a time and in bulk
+    n_processes = 4;
+    n_iterations = 5000;
+    expr = sprintf(['for k = 1:%d, '...
+                    'mocov_line_covered(1, 3); '...
+                    'mocov_line_covered(''add'', 2, [1 4], [1 2]); '...
+                    'end'], n_iterations);
+    mex_dir = fileparts(which('mocov_line_covered'));
+    cmd = sprintf(['MOCOV_SHARED_COUNTERS_FILE="%s" "%s" --norc --quiet '...
+                   '-p "%s" --eval "%s" & '], ...
+                  fn, get_octave_binary(), mex_dir, expr);
+    [status, output] = system([repmat(cmd, 1, n_processes) 'wait']);
+    assertEqual(status, 0, output);
+
+    n = n_processes * n_iterations;
+    s = mocov_line_covered();
+    assertEqual(s.keys, {'a.m'; 'b.m'});
+    assertEqual(s.line_count{1}, [0; 1; n; 0]);
+    assertEqual(s.line_count{2}, [n; 0; 0; 2 * n]);
+
+    % counts are kept after sharing stops, and are no longer shared
+    mocov_line_covered('unshare');
+    mocov_line_covered(1, 3);
+    s = mocov_line_covered();
+    assertEqual(s.line_count{1}, [0; 1; n + 1; 0]);
+
+    mocov_line_covered([]);
+    mocov_line_covered('share', fn);
+    s = mocov_line_covered();
+    assertEqual(s.line_count{1}, [0; 1; n; 0]);
+end
+
+function test_shared_counters_save_while_writing
+    % Test subject: 'save' command of `mocov_line_covered`, while other
+    % processes record lines in the shared counters
+    skip_if_unsupported();
+
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+
+    fn = tempname();
+    file_cleaner = onCleanup(@()delete(fn));
+    done_fn = tempname();
+    done_cleaner = onCleanup(@()delete(done_fn));
+    snapshot_fn = tempname();
+    snapshot_cleaner = onCleanup(@()delete(snapshot_fn));
+
+    % each line goes from zero to a positive count while saving
+    n_lines = 20000;
+    mocov_line_covered('register', {'a.m'}, n_lines);
+    mocov_line_covered('share', fn);
+
+    n_processes = 2;
+    expr = sprintf('for k = 1:%d, mocov_line_covered(1, k); end', n_lines);
+    mex_dir = fileparts(which('mocov_line_covered'));
+    cmd = sprintf(['MOCOV_SHARED_COUNTERS_FILE="%s" "%s" --norc --quiet '...
+                   '-p "%s" --eval "%s" & '], ...
+                  fn, get_octave_binary(), mex_dir, expr);
+    status = system(sprintf('(%s wait; touch "%s") &', ...
+                            repmat(cmd, 1, n_processes), done_fn));
+    assertEqual(status, 0);
+
+    % every snapshot saved in the meantime must be valid
+    n_saved = 0;
+    clock_start = tic();
+    while ~exist(done_fn, 'file') && toc(clock_start) < 60
+        mocov_line_covered('save', snapshot_fn);
+        snapshot = mocov_snapshot_load(snapshot_fn);
+        counts = snapshot.line_count{1};
+        assertTrue(all(counts(1:(end - 1)) <= n_processes));
+        n_saved = n_saved + 1;
+    end
+    assertTrue(exist(done_fn, 'file') > 0);
+    assertTrue(n_saved > 0);
+
+    mocov_line_covered('save', snapshot_fn);
+    snapshot = mocov_snapshot_load(snapshot_fn);
+    assertEqual(snapshot.line_count{1}, repmat(n_processes, n_lines, 1));
+end
+
+function test_shared_counters_layout_mismatch
+    % Test subject: 'share' command of `mocov_line_covered`, with files
+    % that do not match those in the shared counter file
+    skip_if_unsupported();
+
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+
+    fn = tempname();
+    file_cleaner = onCleanup(@()delete(fn));
+
+    mocov_line_covered('register', {'a.m'}, 4);
+    mocov_line_covered('share', fn);
+    assertExceptionThrown(@()mocov_line_covered('share', fn), ...
+                          'mocov_line_covered:AlreadyShared');
+
+    % lines beyond those registered cannot be shared
+    assertExceptionThrown(@()mocov_line_covered(1, 5), ...
+                          'mocov_line_covered:SharedLayoutExceeded');
+
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'b.m'}, 4);
+    assertExceptionThrown(@()mocov_line_covered('share', fn), ...
+                          'mocov_line_covered:LayoutMismatch');
+end
+
+function test_shared_counters_merge_beyond_layout
+    % Test subject: 'merge' command of `mocov_line_covered`, with a
+    % snapshot that has lines beyond those in the shared counter file
+    skip_if_unsupported();
+
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+
+    fn = tempname();
+    file_cleaner = onCleanup(@()delete(fn));
+    snapshot_fn = tempname();
+    snapshot_cleaner = onCleanup(@()delete(snapshot_fn));
+
+    mocov_line_covered('register', {'a.m'}, 8);
+    mocov_line_covered('add', 1, [1 8], [1 5]);
+    mocov_line_covered('save', snapshot_fn);
+
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'a.m'}, 4);
+    mocov_line_covered(1, 1);
+    mocov_line_covered('share', fn);
+
+    % the state is left unchanged
+    assertExceptionThrown(@()mocov_line_covered('merge', snapshot_fn), ...
+                          'mocov_line_covered:SharedLayoutExceeded');
+    assertEqual(mocov_line_covered('get_file', 1), [1; 0; 0; 0]);
+    mocov_line_covered('unshare');
+end
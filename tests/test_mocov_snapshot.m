@@ -0,0 +1,239 @@
+function test_suite = test_mocov_snapshot
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function fn = get_temp_filename()
+    fn = [tempname() '.mocov'];
+end
+
+function delete_if_exists(fn)
+    if exist(fn, 'file')
+        delete(fn);
+    end
+end
+
+function assert_counts_equal(counts, expected_counts)
+    % trailing lines that were not executed do not matter
+    assertEqual(numel(counts), numel(expected_counts));
+    for k = 1:numel(counts)
+        c = counts{k}(:);
+        e = expected_counts{k}(:);
+        assertEqual(find(c), find(e));
+        assertEqual(c(c > 0), e(e > 0));
+    end
+end
+
+function test_snapshot_save_and_load
+    % Test subject: `mocov_snapshot_save` and `mocov_snapshot_load`
+    initial_state = mocov_line_covered();
+    state_cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    fn = get_temp_filename();
+    file_cleaner = onCleanup(@()delete_if_exists(fn));
+
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'a.m'; 'b.m'}, [4; 300], ...
+                       {'0123abcd'; ''});
+    mocov_line_covered('add', 1, [1 3 3]);
+    mocov_line_covered('add', 2, [2 290], [200 100000]);
+
+    mocov_snapshot_save(fn);
+    snapshot = mocov_snapshot_load(fn);
+
+    assertEqual(snapshot.keys, {'a.m'; 'b.m'});
+    assertEqual(snapshot.hashes, {'0123abcd'; ''});
+    assert_counts_equal(snapshot.line_count, ...
+                        {[1; 0; 2]; [0; 200; zeros(287, 1); 100000]});
+
+    % loading does not change the state
+    state = mocov_line_covered();
+    assert_counts_equal(state.line_count, snapshot.line_count);
+end
+
+function test_snapshot_merge_shards
+    % Test subject: `mocov_snapshot_merge`
+    initial_state = mocov_line_covered();
+    state_cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    fns = {get_temp_filename(); get_temp_filename()};
+    file_cleaner = onCleanup(@()cellfun(@delete_if_exists, fns));
+
+    % two shards that covered different parts of the same files
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'a.m'; 'b.m'});
+    mocov_line_covered('add', 1, [1 2]);
+    mocov_snapshot_save(fns{1});
+
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'a.m'; 'b.m'; 'c.m'});
+    mocov_line_covered('add', 1, [2 5]);
+    mocov_line_covered('add', 3, 7);
+    mocov_snapshot_save(fns{2});
+
+    mocov_line_covered([]);
+    mocov_snapshot_merge(fns);
+
+    state = mocov_line_covered();
+    assertEqual(state.keys(1:3), {'a.m'; 'b.m'; 'c.m'});
+    assert_counts_equal(state.line_count(1:3), ...
+                        {[1; 2; 0; 0; 1]; []; [zeros(6, 1); 1]});
+
+    % files are matched by name, not by position
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'c.m'; 'd.m'; 'a.m'});
+    mocov_snapshot_merge(fns{2});
+
+    state = mocov_line_covered();
+    assertEqual(state.keys(1:4), {'c.m'; 'd.m'; 'a.m'; 'b.m'});
+    assert_counts_equal(state.line_count(1:4), ...
+                        {[zeros(6, 1); 1]; []; [0; 1; 0; 0; 1]; []});
+end
+
+function test_snapshot_merge_checks_content_hash
+    % Test subject: `mocov_snapshot_merge`
+    initial_state = mocov_line_covered();
+    state_cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    fn = get_temp_filename();
+    file_cleaner = onCleanup(@()delete_if_exists(fn));
+
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'a.m'; 'b.m'}, [2; 2], {'aaaa'; 'bbbb'});
+    mocov_line_covered('add', 1, 1);
+    mocov_line_covered('add', 2, 2);
+    mocov_snapshot_save(fn);
+
+    % b.m has changed since the snapshot was saved
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'a.m'; 'b.m'}, [2; 2], {'aaaa'; 'cccc'});
+    assertExceptionThrown(@()mocov_snapshot_merge(fn));
+
+    % the state is not changed
+    state = mocov_line_covered();
+    assert_counts_equal(state.line_count, {[0; 0]; [0; 0]});
+
+    % unknown hashes are not checked
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'a.m'; 'b.m'}, [2; 2], {'aaaa'; ''});
+    mocov_snapshot_merge(fn);
+    state = mocov_line_covered();
+    assert_counts_equal(state.line_count, {[1; 0]; [0; 1]});
+end
+
+function test_snapshot_merge_checks_granularity
+    % Test subject: `mocov_snapshot_merge`
+    initial_state = mocov_line_covered();
+    state_cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    fn = get_temp_filename();
+    file_cleaner = onCleanup(@()delete_if_exists(fn));
+
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'a.m'}, 2);
+    mocov_line_covered('granularity', 'block');
+    mocov_line_covered('add', 1, 1);
+    mocov_snapshot_save(fn);
+
+    snapshot = mocov_snapshot_load(fn);
+    assertEqual(snapshot.granularity, 'block');
+
+    % block counts cannot be added to line counts
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'a.m'}, 2);
+    mocov_line_covered('granularity', 'line');
+    assertExceptionThrown(@()mocov_snapshot_merge(fn));
+
+    state = mocov_line_covered();
+    assert_counts_equal(state.line_count, {[0; 0]});
+
+    % a state with unknown granularity takes that of the snapshot
+    mocov_line_covered([]);
+    mocov_snapshot_merge(fn);
+    mocov_snapshot_save(fn);
+    snapshot = mocov_snapshot_load(fn);
+    assertEqual(snapshot.granularity, 'block');
+    assert_counts_equal(snapshot.line_count, {1});
+end
+
+function test_snapshot_invalid_file
+    % Test subject: `mocov_snapshot_merge` and `mocov_snapshot_load`
+    initial_state = mocov_line_covered();
+    state_cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    fn = get_temp_filename();
+    file_cleaner = onCleanup(@()delete_if_exists(fn));
+
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'a.m'});
+    mocov_line_covered('add', 1, [1 2]);
+    mocov_snapshot_save(fn);
+
+    fid = fopen(fn, 'r');
+    bytes = fread(fid, inf, 'uint8');
+    fclose(fid);
+
+    % truncate the snapshot
+    fid = fopen(fn, 'w');
+    fwrite(fid, bytes(1:(end - 1)), 'uint8');
+    fclose(fid);
+
+    assertExceptionThrown(@()mocov_snapshot_load(fn));
+    assertExceptionThrown(@()mocov_snapshot_merge(fn));
+
+    state = mocov_line_covered();
+    assert_counts_equal(state.line_count, {[1; 1]});
+end
+
+function test_mocov_merges_shard_snapshots
+    % Test subject: '-cover_snapshot_file' and '-merge_snapshot' options of
+    % `mocov`
+    root_dir = tempname();
+    mkdir(root_dir);
+    root_cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+    cover_dir = fullfile(root_dir, 'covered');
+    mkdir(cover_dir);
+
+    funcname = sprintf('f_%s', char(96 + ceil(26 * rand(1, 10))));
+    fid = fopen(fullfile(cover_dir, [funcname '.m']), 'w');
+    fprintf(fid, ['function y = %s(x)\n', ...
+                  '    if x > 0\n', ...
+                  '        y = 1;\n', ...
+                  '    else\n', ...
+                  '        y = 2;\n', ...
+                  '    end\n'], funcname);
+    fclose(fid);
+
+    % nothing is written to the working directory (such as a cache)
+    work_dir = fullfile(root_dir, 'work');
+    mkdir(work_dir);
+    orig_pwd = pwd();
+    pwd_cleaner = onCleanup(@()cd(orig_pwd));
+    cd(work_dir);
+
+    % each shard covers a different branch
+    shard_fns = {fullfile(root_dir, 'shard1.mocov'); ...
+                 fullfile(root_dir, 'shard2.mocov')};
+    shard_args = [1; -1];
+    for k = 1:2
+        expr = sprintf('%s(%d)', funcname, shard_args(k));
+        mocov('-cover', cover_dir, ...
+              '-cover_snapshot_file', shard_fns{k}, ...
+              '-expression', expr);
+    end
+
+    work_dir_contents = dir(work_dir);
+    assertEqual(sort({work_dir_contents.name}), {'.', '..'});
+    root_dir_contents = dir(root_dir);
+    assertEqual(sort({root_dir_contents.name}), ...
+                {'.', '..', 'covered', 'shard1.mocov', 'shard2.mocov', ...
+                 'work'});
+
+    xml_fn = fullfile(root_dir, 'coverage.xml');
+    mocov('-cover', cover_dir, ...
+          '-cover_xml_file', xml_fn, ...
+          '-merge_snapshot', shard_fns);
+    xml = fileread(xml_fn);
+
+    assertFalse(isempty(strfind(xml, '<line number="2" hits="2"')));
+    assertFalse(isempty(strfind(xml, '<line number="3" hits="1"')));
+    assertFalse(isempty(strfind(xml, '<line number="5" hits="1"')));
+end
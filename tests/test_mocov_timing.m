@@ -0,0 +1,117 @@
+function test_suite = test_mocov_timing
+    try % assignment of 'localfunctions' is necessary in Matlab >= 2016
+        test_functions = localfunctions();
+    catch % no problem; early Matlab versions can use initTestSuite fine
+    end
+    initTestSuite;
+end
+
+function test_line_covered_timing
+    % Test subject: 'timing' and 'get_times' commands of
+    % `mocov_line_covered`
+
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+
+    mocov_line_covered('register', {'a.m'; 'b.m'}, [5; 5]);
+
+    % lines covered before timing is enabled have no time
+    mocov_line_covered(1, 1);
+    pause(0.05);
+
+    mocov_line_covered('timing', true);
+    mocov_line_covered(1, 2);
+    pause(0.1);
+    mocov_line_covered(2, 3);
+    mocov_line_covered('timing', false);
+    pause(0.05);
+    mocov_line_covered(1, 4);
+
+    times = mocov_line_covered('get_times');
+    s = mocov_line_covered();
+    assertEqual(size(times), [2 1]);
+    assertEqual(size(times{1}), size(s.line_count{1}));
+    assertEqual(size(times{2}), size(s.line_count{2}));
+
+    % the time until the next covered line is attributed to a line
+    assertTrue(times{1}(2) >= 0.09);
+    assertEqual(times{1}([1 3 4 5]), zeros(4, 1));
+    assertEqual(times{2}, zeros(5, 1));
+
+    % setting the state removes all times
+    mocov_line_covered([]);
+    assertTrue(isempty(mocov_line_covered('get_times')));
+end
+
+function test_timing_probe_overhead
+    % Test subject: `mocov_timing_probe_overhead` function
+
+    initial_state = mocov_line_covered();
+    cleaner = onCleanup(@()mocov_line_covered(initial_state));
+    mocov_line_covered([]);
+    mocov_line_covered('register', {'a.m'}, 3);
+    mocov_line_covered(1, 2);
+    state = mocov_line_covered();
+
+    overhead = mocov_timing_probe_overhead(100);
+    assertTrue(isscalar(overhead) && overhead >= 0 && overhead < 1);
+
+    % the state is restored
+    assertEqual(mocov_line_covered(), state);
+
+    assertExceptionThrown(@()mocov_timing_probe_overhead(1), '');
+end
+
+function test_mocov_timing_method
+    % Test subject: 'timing' method of `mocov`
+    root_dir = tempname();
+    mkdir(root_dir);
+    root_cleaner = onCleanup(@()mocov_util_rmdir_recursively(root_dir));
+    cover_dir = fullfile(root_dir, 'covered');
+    mkdir(cover_dir);
+
+    funcname = sprintf('f_%s', char(96 + ceil(26 * rand(1, 10))));
+    fid = fopen(fullfile(cover_dir, [funcname '.m']), 'w');
+    fprintf(fid, ['function y = %s(x)\n', ...
+                  '    y = helper(x);\n', ...
+                  '    y = y + 1;\n', ...
+                  '\n', ...
+                  'function y = helper(x)\n', ...
+                  '    pause(x);\n', ...
+                  '    y = x;\n'], funcname);
+    fclose(fid);
+
+    csv_fn = fullfile(root_dir, 'timing.csv');
+    html_fn = fullfile(root_dir, 'timing.html');
+    mocov('-cover', cover_dir, ...
+          '-cover_method', 'timing', ...
+          '-timing_csv_file', csv_fn, ...
+          '-timing_html_file', html_fn, ...
+          '-expression', @()feval(funcname, 0.1));
+
+    fid = fopen(csv_fn);
+    csv_cleaner = onCleanup(@()fclose(fid));
+    header = fgetl(fid);
+    first_row = fgetl(fid);
+    assertEqual(header, 'file,function,line,count,time,self_time');
+
+    % the line with the pause has the most self time
+    prefix = sprintf('"%s.m","helper",6,1,', funcname);
+    assertTrue(strncmp(first_row, prefix, numel(prefix)));
+    values = sscanf(first_row((numel(prefix) + 1):end), '%f,%f');
+    assertTrue(values(1) >= 0.09);
+    assertTrue(values(2) <= values(1));
+
+    assertTrue(~isempty(dir(html_fn)));
+
+    % timing requires the 'timing' method and the 'call' probe
+    expr = @()feval(funcname, 0);
+    assertExceptionThrown(@()mocov('-cover', cover_dir, ...
+                                   '-timing_csv_file', csv_fn, ...
+                                   '-expression', expr), '');
+    assertExceptionThrown(@()mocov('-cover', cover_dir, ...
+                                   '-cover_method', 'timing', ...
+                                   '-cover_probe', 'buffer', ...
+                                   '-expression', expr), '');
+end